@@ -0,0 +1,176 @@
+/**
+ * ARC implementation
+ */
+#include <algorithm>
+#include <cassert>
+
+#include "buffer/arc_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+/*
+ * Identity of the page a value stands for
+ */
+static int64_t GetPageKey(Page *page) { return page->GetPageId(); }
+static int64_t GetPageKey(int value) { return value; }
+
+template <typename T>
+ARCReplacer<T>::ARCReplacer(size_t capacity) : capacity_(capacity) {
+  assert(capacity_ > 0);
+}
+
+template <typename T> ARCReplacer<T>::~ARCReplacer() {}
+
+/*
+ * Insert value into the replacer, called when it is unpinned. The second
+ * access of a resident page moves it to T2, a page new to its frame goes to
+ * T1, or straight to T2 (adapting p) if it is still remembered as a ghost.
+ */
+template <typename T> void ARCReplacer<T>::Insert(const T &value) {
+  lock_guard<mutex> lck(latch);
+  const int64_t key = GetPageKey(value);
+  auto it = resident_.find(value);
+  if (it != resident_.end() && it->second.key != key) {
+    // the frame was reused for another page
+    Forget(value);
+    it = resident_.end();
+  }
+  if (it != resident_.end()) {
+    stats_.hits++;
+    Entry &entry = it->second;
+    if (entry.evictable) {
+      (entry.in_t2 ? t2_ : t1_).erase(entry.pos);
+    }
+    if (!entry.in_t2) {
+      entry.in_t2 = true;
+      t1_size_--;
+      t2_size_++;
+    }
+    t2_.push_front(value);
+    entry.pos = t2_.begin();
+    entry.evictable = true;
+    return;
+  }
+
+  stats_.misses++;
+  bool in_t2 = false;
+  auto ghost = ghosts_.find(key);
+  if (ghost != ghosts_.end()) {
+    in_t2 = true;
+    if (ghost->second.in_b2) {
+      stats_.b2_ghost_hits++;
+      size_t delta = max<size_t>(b1_.size() / b2_.size(), 1);
+      target_t1_ -= min(delta, target_t1_);
+      b2_.erase(ghost->second.pos);
+    } else {
+      stats_.b1_ghost_hits++;
+      size_t delta = max<size_t>(b2_.size() / b1_.size(), 1);
+      target_t1_ = min(target_t1_ + delta, capacity_);
+      b1_.erase(ghost->second.pos);
+    }
+    ghosts_.erase(ghost);
+  }
+  list<T> &lru = in_t2 ? t2_ : t1_;
+  lru.push_front(value);
+  resident_[value] = {key, in_t2, true, lru.begin()};
+  (in_t2 ? t2_size_ : t1_size_)++;
+}
+
+/* Pop the LRU evictable value of T1 if T1 is larger than its target (or T2
+ * has nothing evictable), of T2 otherwise, to argument "value" and remember
+ * its page as a ghost. If nothing is evictable, return false
+ */
+template <typename T> bool ARCReplacer<T>::Victim(T &value) {
+  lock_guard<mutex> lck(latch);
+  if (t1_.empty() && t2_.empty()) {
+    return false;
+  }
+  const bool from_t1 = t2_.empty() || (!t1_.empty() && t1_size_ > target_t1_);
+  value = from_t1 ? t1_.back() : t2_.back();
+  const int64_t key = resident_[value].key;
+  Forget(value);
+  AddGhost(key, !from_t1);
+  return true;
+}
+
+/*
+ * Drop value from T1/T2 without remembering it, its page was deleted. If it
+ * was evictable, return true, otherwise return false
+ */
+template <typename T> bool ARCReplacer<T>::Erase(const T &value) {
+  lock_guard<mutex> lck(latch);
+  auto it = resident_.find(value);
+  if (it == resident_.end()) {
+    return false;
+  }
+  const bool evictable = it->second.evictable;
+  Forget(value);
+  return evictable;
+}
+
+/*
+ * Remove value from the evictable set, it stays resident. If it was
+ * evictable, return true, otherwise return false
+ */
+template <typename T> bool ARCReplacer<T>::Pin(const T &value) {
+  lock_guard<mutex> lck(latch);
+  auto it = resident_.find(value);
+  if (it == resident_.end() || !it->second.evictable) {
+    return false;
+  }
+  (it->second.in_t2 ? t2_ : t1_).erase(it->second.pos);
+  it->second.evictable = false;
+  return true;
+}
+
+template <typename T> size_t ARCReplacer<T>::Size() {
+  lock_guard<mutex> lck(latch);
+  return t1_.size() + t2_.size();
+}
+
+template <typename T> ARCStats ARCReplacer<T>::GetStats() {
+  lock_guard<mutex> lck(latch);
+  ARCStats stats = stats_;
+  stats.target_t1 = target_t1_;
+  stats.t1_size = t1_size_;
+  stats.t2_size = t2_size_;
+  return stats;
+}
+
+/*
+ * Drop the resident entry of value, called with latch held
+ */
+template <typename T> void ARCReplacer<T>::Forget(const T &value) {
+  Entry &entry = resident_[value];
+  if (entry.evictable) {
+    (entry.in_t2 ? t2_ : t1_).erase(entry.pos);
+  }
+  (entry.in_t2 ? t2_size_ : t1_size_)--;
+  resident_.erase(value);
+}
+
+/*
+ * Remember an evicted page, keeping |T1| + |B1| <= c and the ghosts of both
+ * lists at most c, called with latch held
+ */
+template <typename T> void ARCReplacer<T>::AddGhost(int64_t key, bool in_b2) {
+  list<int64_t> &lru = in_b2 ? b2_ : b1_;
+  lru.push_front(key);
+  ghosts_[key] = {in_b2, lru.begin()};
+  while (!b1_.empty() && t1_size_ + b1_.size() > capacity_) {
+    ghosts_.erase(b1_.back());
+    b1_.pop_back();
+  }
+  while (b1_.size() + b2_.size() > capacity_) {
+    list<int64_t> &oldest = b2_.empty() ? b1_ : b2_;
+    ghosts_.erase(oldest.back());
+    oldest.pop_back();
+  }
+}
+
+template class ARCReplacer<Page *>;
+// test only
+template class ARCReplacer<int>;
+
+} // namespace cmudb
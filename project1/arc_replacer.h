@@ -0,0 +1,92 @@
+/**
+ * arc_replacer.h
+ *
+ * Functionality: Adaptive Replacement Cache policy. Resident values are split
+ * in T1 (accessed once since they were loaded) and T2 (accessed again), and
+ * recently evicted ones are remembered as ghosts in B1 and B2. A miss on a B1
+ * ghost means T1 was too small and grows its target size p, a miss on a B2
+ * ghost shrinks it. Victim takes the LRU evictable value of T1 while T1 is
+ * above its target, of T2 otherwise, so the policy drifts towards recency
+ * during scans and towards frequency during point lookups.
+ *
+ * The values are frames, a frame holds different pages over time: ghosts are
+ * remembered by page id (the value itself for test types), and an Insert of a
+ * frame holding another page than last time is a new page.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "buffer/replacer.h"
+
+using namespace std;
+namespace cmudb {
+
+// counters exposed by ARCReplacer, the ghost hits and p of the replacer of a
+// buffer pool also by BufferPoolManager::GetStats
+struct ARCStats {
+  size_t hits = 0;          // Insert of a resident page
+  size_t misses = 0;        // Insert of a page loaded into its frame
+  size_t b1_ghost_hits = 0; // misses of pages recently evicted from T1
+  size_t b2_ghost_hits = 0; // misses of pages recently evicted from T2
+  size_t target_t1 = 0;     // current target size p of T1
+  size_t t1_size = 0;       // resident pages in T1, pinned ones included
+  size_t t2_size = 0;       // resident pages in T2, pinned ones included
+};
+
+template <typename T> class ARCReplacer : public Replacer<T> {
+  struct Entry {
+    int64_t key;  // page held by the frame
+    bool in_t2;
+    bool evictable;
+    typename list<T>::iterator pos; // in t1_ or t2_ while evictable
+  };
+  struct Ghost {
+    bool in_b2;
+    list<int64_t>::iterator pos;
+  };
+
+public:
+  // capacity is the number of frames
+  explicit ARCReplacer(size_t capacity);
+
+  ~ARCReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  // value is gone, it is not remembered as a ghost either
+  bool Erase(const T &value);
+
+  // value stays resident but is not evictable until inserted again
+  bool Pin(const T &value);
+
+  size_t Size();
+
+  ARCStats GetStats();
+
+private:
+  void Forget(const T &value);
+  void AddGhost(int64_t key, bool in_b2);
+  const size_t capacity_;
+  size_t target_t1_ = 0;
+  // all resident entries, t1_/t2_ only hold the evictable ones, MRU first
+  unordered_map<T, Entry> resident_;
+  list<T> t1_;
+  list<T> t2_;
+  size_t t1_size_ = 0;
+  size_t t2_size_ = 0;
+  // ghosts, MRU first
+  unordered_map<int64_t, Ghost> ghosts_;
+  list<int64_t> b1_;
+  list<int64_t> b2_;
+  ARCStats stats_;
+  mutable mutex latch;
+};
+
+} // namespace cmudb
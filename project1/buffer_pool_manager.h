@@ -7,42 +7,247 @@
  */
 
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <list>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_guard.h"
 #include "disk/disk_manager.h"
 #include "hash/extendible_hash.h"
+#include "hash/linear_probe_hash_table.h"
 #include "logging/log_manager.h"
 #include "page/page.h"
 
 namespace cmudb {
+// result of a FlushAllPages/FlushDirtyPages call
+struct FlushStats {
+  size_t pages_written = 0; // dirty pages written back
+  size_t write_calls = 0;   // vectored writes, one per run of consecutive pages
+  size_t pages_copied = 0;  // pinned pages, written from a private copy
+  bool log_flushed = false; // log had to be flushed first (WAL)
+};
+
+// snapshot of the counters of a buffer pool, see BufferPoolManager::GetStats
+struct BufferPoolStats {
+  static const size_t HISTOGRAM_SIZE = 32;
+  size_t hits = 0;              // FetchPage found the page buffered
+  size_t misses = 0;            // FetchPage had to read the page
+  size_t evictions = 0;         // frames handed over to another page
+  size_t dirty_write_backs = 0; // evictions writing the old page back
+  size_t cleaner_writes = 0;    // pages written back by the page cleaner
+  size_t wal_flushes = 0;       // log flushes forced before a page write
+  size_t pin_waits = 0;         // fetches waiting for the I/O of a frame
+  size_t all_pinned = 0;        // FetchPage/NewPage found no victim
+  size_t prefetched = 0;        // pages read by the prefetch thread
+  size_t swizzles = 0;          // child page ids replaced by their frame
+  size_t unswizzles = 0;        // swizzled ids put back
+  // ReplacerType::ARC only, see ARCStats
+  size_t b1_ghost_hits = 0;     // misses on pages recently evicted from T1
+  size_t b2_ghost_hits = 0;     // misses on pages recently evicted from T2
+  size_t target_t1 = 0;         // target size of T1, summed over instances
+  // latch_ acquisitions by wait time: [0] did not wait, [i] waited less than
+  // 2^i ns, the last bucket takes everything longer
+  size_t latch_wait[HISTOGRAM_SIZE] = {};
+
+  std::string ToString() const;
+};
+
+// replacement policy of the frames
+enum class ReplacerType { LRU = 0, LRU_K, CLOCK, ARC };
+
+// a swizzled page id is this tag and the index of the frame holding the page
+static const page_id_t SWIZZLE_TAG = INT32_MIN;
+
 class BufferPoolManager {
+  friend class ParallelBufferPoolManager;
+
 public:
   BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
-                          LogManager *log_manager = nullptr);
+                          LogManager *log_manager = nullptr,
+                          ReplacerType replacer_type = ReplacerType::LRU,
+                          size_t numa_partitions = 1);
+
+  virtual ~BufferPoolManager();
 
-  ~BufferPoolManager();
+  virtual Page *FetchPage(page_id_t page_id);
+  // buffered page without pin or latch, nullptr if FetchPage has to be used:
+  // its content is only valid if Page::Validate(version) holds after reading
+  virtual Page *FetchPageOptimistic(page_id_t page_id, uint64_t &version);
+  // FetchPage/NewPage and latch the page, the returned guard holds both and
+  // is empty if no frame was available
+  ReadPageGuard FetchPageRead(page_id_t page_id);
+  WritePageGuard FetchPageWrite(page_id_t page_id);
+  WritePageGuard NewPageGuarded(page_id_t &page_id);
 
-  Page *FetchPage(page_id_t page_id);
+  // pointer swizzling: a child page id stored inside a buffered page may be
+  // replaced by the frame of the child, which stays pinned until the id is
+  // put back. Swizzled ids never reach the disk.
+  static inline bool IsSwizzled(page_id_t page_id) {
+    return page_id < INVALID_PAGE_ID;
+  }
+  inline Page *GetSwizzledPage(page_id_t page_id) {
+    return &pages_[page_id & ~SWIZZLE_TAG];
+  }
+  // at most max_pins children pinned by swizzled ids, 0 (default) is off
+  virtual void SetSwizzling(size_t max_pins);
+  // swizzle *slot, inside parent as of version, to the frame of child
+  virtual bool Swizzle(Page *parent, uint64_t version, page_id_t *slot,
+                       Page *child);
+  // put back the ids swizzled inside page, write latched by the caller
+  virtual void Unswizzle(Page *page);
 
-  bool UnpinPage(page_id_t page_id, bool is_dirty);
+  virtual bool UnpinPage(page_id_t page_id, bool is_dirty);
+  // same for a page pinned by the caller, without asking the page table
+  virtual bool UnpinFrame(Page *page, bool is_dirty);
 
-  bool FlushPage(page_id_t page_id);
+  virtual bool FlushPage(page_id_t page_id);
 
-  Page *NewPage(page_id_t &page_id);
+  virtual Page *NewPage(page_id_t &page_id);
 
-  bool DeletePage(page_id_t page_id);
+  virtual bool DeletePage(page_id_t page_id);
+
+  virtual bool CheckAllUnpined();
+
+  // write back every dirty page, e.g. on checkpoint or shutdown
+  FlushStats FlushAllPages() { return FlushDirtyPages(SIZE_MAX); }
+  // write back at most batch dirty pages, lowest page ids first
+  virtual FlushStats FlushDirtyPages(size_t batch);
+
+  // load pages in the background into free or clean frames, without pinning
+  virtual void Prefetch(page_id_t page_id, size_t count);
+  virtual void Prefetch(const std::vector<page_id_t> &page_ids);
+  // block until the pages queued so far are loaded or dropped
+  virtual void WaitForPrefetch();
+  // prefetch window pages ahead once FetchPage sees a sequential scan, 0 = off
+  void SetReadAhead(size_t window);
+
+  virtual BufferPoolStats GetStats();
+  // hand GetStats() to dumper every interval from a background thread
+  void RunStatsDumper(std::function<void(const BufferPoolStats &)> dumper,
+                      std::chrono::milliseconds interval);
+  void StopStatsDumper();
+
+  // background write-back of dirty unpinned pages, the cleaner must be
+  // stopped before the pool is deleted
+  virtual void RunPageCleaner(double high_watermark = 0.5,
+                              double low_watermark = 0.25);
+  virtual void StopPageCleaner();
+
+protected:
+  // used by subclasses that own no frames themselves
+  BufferPoolManager(DiskManager *disk_manager, LogManager *log_manager);
 
 private:
   size_t pool_size_; // number of pages in buffer pool
   Page *pages_;      // array of pages
+  FrameArena *arena_; // page data of all the frames, in one region
   DiskManager *disk_manager_;
   LogManager *log_manager_;
   HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
   Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
+  ARCReplacer<Page *> *arc_replacer_ = nullptr; // replacer_, if ARC
   std::list<Page *> *free_list_; // to find a free page for replacement
   std::mutex latch_;             // to protect shared data structure
+  bool *io_pending_;             // frames whose disk I/O is in flight
+  std::condition_variable *io_cv_; // waiters of each frame's I/O
+  size_t *flushing_;             // write-backs in flight reading each frame
+  // swizzled ids inside each frame: offset in the page and child frame
+  std::vector<std::pair<size_t, Page *>> *swizzles_;
+  std::atomic<size_t> max_swizzled_{0};
+  size_t swizzled_count_ = 0;    // children pinned by swizzled ids
+  // pages being written back from an evicted frame
+  std::unordered_map<page_id_t, Page *> writing_back_;
+  // page cleaner related
+  size_t dirty_count_ = 0;       // number of dirty frames
+  bool cleaner_running_ = false;
+  double high_watermark_ = 1;    // ratio of dirty frames waking the cleaner
+  double low_watermark_ = 1;     // ratio of dirty frames the cleaner stops at
+  size_t cleaner_hand_ = 0;      // next frame the cleaner looks at
+  std::thread *cleaner_thread_ = nullptr;
+  std::condition_variable cleaner_cv_;
+  // prefetch related
+  std::deque<page_id_t> prefetch_queue_;
+  bool prefetch_running_ = false;
+  std::thread *prefetch_thread_ = nullptr;
+  std::condition_variable prefetch_cv_;
+  std::condition_variable prefetch_idle_cv_; // queue empty, nothing in flight
+  size_t prefetch_in_flight_ = 0; // reads submitted by the prefetch thread
+  // read without a lock, the scan state below is under latch_ (or the scan
+  // latch of ParallelBufferPoolManager)
+  std::atomic<size_t> read_ahead_window_{0};
+  page_id_t last_fetched_ = INVALID_PAGE_ID;
+  size_t sequential_run_ = 0;    // fetches of consecutive page ids in a row
+  page_id_t read_ahead_next_ = 0; // first page not queued by read-ahead yet
+  // statistics related
+  struct {
+    std::atomic<size_t> hits{0};
+    std::atomic<size_t> misses{0};
+    std::atomic<size_t> evictions{0};
+    std::atomic<size_t> dirty_write_backs{0};
+    std::atomic<size_t> cleaner_writes{0};
+    std::atomic<size_t> wal_flushes{0};
+    std::atomic<size_t> pin_waits{0};
+    std::atomic<size_t> all_pinned{0};
+    std::atomic<size_t> prefetched{0};
+    std::atomic<size_t> swizzles{0};
+    std::atomic<size_t> unswizzles{0};
+    std::atomic<size_t> latch_wait[BufferPoolStats::HISTOGRAM_SIZE] = {};
+  } stats_;
+  bool dumper_running_ = false;
+  std::thread *dumper_thread_ = nullptr;
+  std::mutex dumper_latch_;
+  std::condition_variable dumper_cv_;
   Page *GetVictimPage();
+  Page *NewPageWithId(page_id_t page_id);
+  void ReplaceFrame(Page *tar, page_id_t page_id, bool read,
+                    std::unique_lock<std::mutex> &lck);
+  page_id_t ClaimFrame(Page *tar, page_id_t page_id);
+  void FinishIO(Page *tar, page_id_t old_page_id);
+  void WaitForIO(Page *tar, std::unique_lock<std::mutex> &lck);
+  void WriteBack(Page *tar, page_id_t old_page_id);
+  bool Unpin(Page *tar, bool is_dirty);
+  void RestoreSwizzled(Page *tar);
+  void RestoreSwizzled(Page *tar, char *copy);
+  void CleanDirtyPages(std::unique_lock<std::mutex> &lck);
+
+  // a dirty page picked by FlushDirtyPages
+  struct FlushTarget {
+    Page *page;
+    page_id_t page_id;
+    bool pinned; // pinned by a user, may be latched: written from a copy
+    lsn_t lsn;   // page LSN of the content written
+    // ids swizzled inside a pinned page when it was claimed: offset and page
+    // id, to put back into its copy without latch_
+    std::vector<std::pair<size_t, page_id_t>> swizzled;
+  };
+  static void RestoreSwizzled(const FlushTarget &target, char *copy);
+  void ClaimDirtyPages(size_t batch, std::vector<FlushTarget> &targets);
+  // unlatches the unpinned targets once they are written
+  void WriteDirtyPages(std::vector<FlushTarget> &targets, FlushStats &stats);
+  void WritePageRuns(std::vector<FlushTarget> &targets,
+                     std::vector<const char *> &data,
+                     std::vector<size_t> &indexes, FlushStats &stats);
+  void ReleaseDirtyPages(std::vector<FlushTarget> &targets);
+
+  std::unique_lock<std::mutex> LockLatch();
+  void AcquireLatch(std::unique_lock<std::mutex> &lck);
+
+  void QueuePrefetch(page_id_t page_id);
+  void StopPrefetcher();
+  bool SequentialFetch(page_id_t page_id, page_id_t &first, size_t &count);
 };
 } // namespace cmudb
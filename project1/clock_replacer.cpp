@@ -0,0 +1,74 @@
+/**
+ * CLOCK implementation
+ */
+#include <cassert>
+
+#include "buffer/clock_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T>
+ClockReplacer<T>::ClockReplacer(size_t num_frames, T base)
+    : num_frames_(num_frames), base_(base),
+      frames_(new std::atomic<uint8_t>[num_frames]()), hand_(0), size_(0) {}
+
+template <typename T> ClockReplacer<T>::~ClockReplacer() { delete[] frames_; }
+
+/*
+ * Make the frame of value evictable and give it a second chance. size_ is
+ * counted before the frame is published: a Victim or Erase taking the frame
+ * right away must not bring it below zero.
+ */
+template <typename T> void ClockReplacer<T>::Insert(const T &value) {
+  assert(GetFrameId(value) < num_frames_);
+  size_++;
+  uint8_t old = frames_[GetFrameId(value)].exchange(EVICTABLE | REFERENCED);
+  if (old & EVICTABLE) {
+    size_--;
+  }
+}
+
+/* Advance the clock hand until an evictable frame with a clear reference bit
+ * is found, clearing the reference bits on the way. Pop it to argument
+ * "value" and return true. If nothing is evictable, return false
+ */
+template <typename T> bool ClockReplacer<T>::Victim(T &value) {
+  while (size_.load() > 0) {
+    const size_t frame_id = hand_.fetch_add(1) % num_frames_;
+    uint8_t state = frames_[frame_id].load();
+    if (!(state & EVICTABLE)) {
+      continue;
+    }
+    // a failed exchange means somebody else changed the frame, move on
+    if (state & REFERENCED) {
+      frames_[frame_id].compare_exchange_strong(state, EVICTABLE);
+    } else if (frames_[frame_id].compare_exchange_strong(state, 0)) {
+      size_--;
+      value = base_ + frame_id;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Make the frame of value not evictable. If it was evictable, return true,
+ * otherwise return false
+ */
+template <typename T> bool ClockReplacer<T>::Erase(const T &value) {
+  assert(GetFrameId(value) < num_frames_);
+  if (!(frames_[GetFrameId(value)].exchange(0) & EVICTABLE)) {
+    return false;
+  }
+  size_--;
+  return true;
+}
+
+template <typename T> size_t ClockReplacer<T>::Size() { return size_.load(); }
+
+template class ClockReplacer<Page *>;
+// test only
+template class ClockReplacer<int>;
+
+} // namespace cmudb
@@ -0,0 +1,56 @@
+/**
+ * clock_replacer.h
+ *
+ * Functionality: CLOCK (second chance) replacement policy over a fixed array
+ * of frames. Every frame has an evictable bit and a reference bit packed in
+ * one atomic byte, indexed by its position in the frame array. Insert and
+ * Erase are a single atomic exchange, with no lock and no allocation. Victim
+ * sweeps the frames with an atomic clock hand: it clears the reference bit of
+ * recently inserted frames and evicts the first evictable frame whose bit is
+ * already clear.
+ *
+ * BufferPoolManager still calls its replacer with latch_ held, the pin count
+ * and the page table change together with it. There CLOCK only saves the
+ * replacer's own mutex and the list allocations of LRUReplacer, the calls are
+ * not concurrent.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class ClockReplacer : public Replacer<T> {
+  static const uint8_t EVICTABLE = 1;
+  static const uint8_t REFERENCED = 2;
+
+public:
+  // values are base, base + 1, ... base + num_frames - 1
+  ClockReplacer(size_t num_frames, T base);
+
+  ~ClockReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+private:
+  size_t GetFrameId(const T &value) const {
+    return static_cast<size_t>(value - base_);
+  }
+  const size_t num_frames_;
+  const T base_;
+  std::atomic<uint8_t> *frames_;
+  std::atomic<size_t> hand_;
+  std::atomic<size_t> size_;
+};
+
+} // namespace cmudb
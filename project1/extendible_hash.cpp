@@ -1,4 +1,7 @@
 #include <list>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "hash/extendible_hash.h"
 #include "page/page.h"
@@ -11,13 +14,14 @@ namespace cmudb {
  * array_size: fixed array size for each bucket
  */
 template <typename K, typename V>
-ExtendibleHash<K, V>::ExtendibleHash(size_t size) :  globalDepth(0),bucketSize(size),bucketNum(1) {
-  buckets.push_back(make_shared<Bucket>(0));
+ExtendibleHash<K, V>::ExtendibleHash(size_t size) : bucketSize(size),bucketNum(1) {
+  directories.emplace_back(new Directory(0));
+  buckets.emplace_back(new Bucket(0, 0, bucketSize));
+  directories[0]->slots[0].store(buckets[0].get(), memory_order_relaxed);
+  directory.store(directories[0].get(), memory_order_release);
 }
 template<typename K, typename V>
-ExtendibleHash<K, V>::ExtendibleHash() {
-  ExtendibleHash(64);
-}
+ExtendibleHash<K, V>::ExtendibleHash() : ExtendibleHash(64) {}
 
 /*
  * helper function to calculate the hashing address of input key
@@ -27,14 +31,59 @@ size_t ExtendibleHash<K, V>::HashKey(const K &key) const{
   return hash<K>{}(key);
 }
 
+/*
+ * helper function to pick the fingerprint of a key out of its hash, from the
+ * high bits of a multiplicative hash since the low bits of HashKey address the
+ * directory and are mostly the same within a bucket
+ */
+template <typename K, typename V>
+uint8_t ExtendibleHash<K, V>::Fingerprint(size_t hash) {
+  return static_cast<uint8_t>((hash * 0x9e3779b97f4a7c15ULL) >> 56);
+}
+
+/*
+ * helper function to find the slot of key in bucket, comparing a group of
+ * fingerprints at once and the key only on a fingerprint match
+ */
+template <typename K, typename V>
+int ExtendibleHash<K, V>::FindSlot(const Bucket &bucket, const K &key,
+                                   uint8_t fingerprint) const {
+  const size_t count = bucket.entries.size();
+#ifdef __SSE2__
+  const __m128i needle = _mm_set1_epi8(static_cast<char>(fingerprint));
+  for (size_t i = 0; i < count; i += FINGERPRINT_GROUP) {
+    const __m128i group = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(&bucket.fingerprints[i]));
+    unsigned match = _mm_movemask_epi8(_mm_cmpeq_epi8(group, needle));
+    if (count - i < FINGERPRINT_GROUP) {
+      match &= (1u << (count - i)) - 1;
+    }
+    while (match) {
+      const size_t slot = i + __builtin_ctz(match);
+      if (bucket.entries[slot].first == key) {
+        return static_cast<int>(slot);
+      }
+      match &= match - 1;
+    }
+  }
+#else
+  for (size_t slot = 0; slot < count; ++slot) {
+    if (bucket.fingerprints[slot] == fingerprint &&
+        bucket.entries[slot].first == key) {
+      return static_cast<int>(slot);
+    }
+  }
+#endif
+  return -1;
+}
+
 /*
  * helper function to return global depth of hash table
  * NOTE: you must implement this function in order to pass test
  */
 template <typename K, typename V>
 int ExtendibleHash<K, V>::GetGlobalDepth() const{
-  lock_guard<mutex> lock(latch);
-  return globalDepth;
+  return directory.load(memory_order_acquire)->depth;
 }
 
 /*
@@ -43,13 +92,15 @@ int ExtendibleHash<K, V>::GetGlobalDepth() const{
  */
 template <typename K, typename V>
 int ExtendibleHash<K, V>::GetLocalDepth(int bucket_id) const {
-  //lock_guard<mutex> lck2(latch);
-  if (buckets[bucket_id]) {
-    lock_guard<mutex> lck(buckets[bucket_id]->latch);
-    if (buckets[bucket_id]->kmap.size() == 0) return -1;
-    return buckets[bucket_id]->localDepth;
+  // the directory may halve under a removal
+  Directory *dir = directory.load(memory_order_acquire);
+  if (bucket_id < 0 || static_cast<size_t>(bucket_id) >= dir->Size()) {
+    return -1;
   }
-  return -1;
+  Bucket *cur = dir->slots[bucket_id].load(memory_order_acquire);
+  lock_guard<mutex> lck(cur->latch);
+  if (cur->entries.empty()) return -1;
+  return cur->localDepth;
 }
 
 /*
@@ -61,44 +112,171 @@ int ExtendibleHash<K, V>::GetNumBuckets() const{
   return bucketNum;
 }
 
+/*
+ * helper function to latch the bucket key belongs to
+ * The directory is read without latch, the bucket latched afterwards: a split
+ * or a merge in between may have moved key elsewhere, then the bucket does not
+ * own its hash anymore and the directory is read again. Whatever changed it
+ * did so before releasing the latch just taken, the retry sees the change.
+ */
+template <typename K, typename V>
+typename ExtendibleHash<K, V>::Bucket *
+ExtendibleHash<K, V>::LockBucket(size_t hash, unique_lock<mutex> &lck) {
+  while (true) {
+    Directory *dir = directory.load(memory_order_acquire);
+    Bucket *cur = dir->slots[hash & (dir->Size() - 1)].load(
+            memory_order_acquire);
+    lck = unique_lock<mutex>(cur->latch);
+    if (!cur->merged &&
+        (hash & ((size_t(1) << cur->localDepth) - 1)) == cur->bits) {
+      return cur;
+    }
+    lck.unlock();
+  }
+}
+
 /*
  * lookup function to find value associate with input key
  */
 template <typename K, typename V>
 bool ExtendibleHash<K, V>::Find(const K &key, V &value) {
-
-  int idx = getIdx(key);
-  lock_guard<mutex> lck(buckets[idx]->latch);
-  if (buckets[idx]->kmap.find(key) != buckets[idx]->kmap.end()) {
-    value = buckets[idx]->kmap[key];
-    return true;
-
+  const size_t hash = HashKey(key);
+  unique_lock<mutex> lck;
+  Bucket *cur = LockBucket(hash, lck);
+  int slot = FindSlot(*cur, key, Fingerprint(hash));
+  if (slot == -1) {
+    return false;
   }
-  return false;
+  value = cur->entries[slot].second;
+  return true;
 }
 
 template <typename K, typename V>
 int ExtendibleHash<K, V>::getIdx(const K &key) const{
-  lock_guard<mutex> lck(latch);
-  return HashKey(key) & ((1 << globalDepth) - 1);
+  return HashKey(key) & (directory.load(memory_order_acquire)->Size() - 1);
 }
 
 /*
  * delete <key,value> entry in hash table
- * Shrink & Combination is not required for this project
+ * A bucket left at most half full together with its split image is merged
+ * with it, and the directory halves as long as no bucket needs all its bits
  */
 template <typename K, typename V>
 bool ExtendibleHash<K, V>::Remove(const K &key) {
-  int idx = getIdx(key);
-  lock_guard<mutex> lck(buckets[idx]->latch);
-  shared_ptr<Bucket> cur = buckets[idx];
-  if (cur->kmap.find(key) == cur->kmap.end()) {
+  const size_t hash = HashKey(key);
+  unique_lock<mutex> lck;
+  Bucket *cur = LockBucket(hash, lck);
+  int slot = FindSlot(*cur, key, Fingerprint(hash));
+  if (slot == -1) {
     return false;
   }
-  cur->kmap.erase(key);
+  // the last entry fills the hole, entries stay packed
+  const size_t last = cur->entries.size() - 1;
+  if (static_cast<size_t>(slot) != last) {
+    cur->entries[slot] = std::move(cur->entries[last]);
+    cur->fingerprints[slot] = cur->fingerprints[last];
+  }
+  cur->entries.pop_back();
+  if (cur->localDepth > 0) {
+    Merge(cur);
+  }
   return true;
 }
 
+/*
+ * Called with latch held: a bucket out of the directory, for bits of hashes
+ * at local depth depth, returned latched in lck. A merged bucket is reused
+ * when there is one; a lookup may still be validating it, so it must stay
+ * latched until it holds its entries and the directory points to it.
+ */
+template <typename K, typename V>
+typename ExtendibleHash<K, V>::Bucket *
+ExtendibleHash<K, V>::NewBucket(int depth, size_t bits,
+                                unique_lock<mutex> &lck) {
+  bucketNum++;
+  if (freeBuckets.empty()) {
+    buckets.emplace_back(new Bucket(depth, bits, bucketSize));
+    lck = unique_lock<mutex>(buckets.back()->latch);
+    return buckets.back().get();
+  }
+  Bucket *bucket = freeBuckets.back();
+  freeBuckets.pop_back();
+  lck = unique_lock<mutex>(bucket->latch);
+  bucket->localDepth = depth;
+  bucket->bits = bits;
+  bucket->merged = false;
+  return bucket;
+}
+
+/*
+ * Called with latch held: publish the directory of global depth depth, one
+ * more or one less than the current one. Its slots are filled from the
+ * current directory first; a lookup still in an older one gets validated out.
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::Resize(int depth) {
+  Directory *cur = directory.load(memory_order_relaxed);
+  if (directories.size() <= static_cast<size_t>(depth)) {
+    directories.emplace_back(new Directory(depth));
+  }
+  Directory *dir = directories[depth].get();
+  for (size_t i = 0; i < dir->Size(); i++) {
+    dir->slots[i].store(
+            cur->slots[i & (cur->Size() - 1)].load(memory_order_relaxed),
+            memory_order_relaxed);
+  }
+  directory.store(dir, memory_order_release);
+}
+
+/*
+ * Called with the latch of cur held. The split image is only try-latched:
+ * latches are taken bucket first, directory second, and another thread may
+ * hold the image waiting for the directory; a busy image is simply not merged.
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::Merge(Bucket *cur) {
+  lock_guard<mutex> lck(latch);
+  Directory *dir = directory.load(memory_order_relaxed);
+  bool merged = false;
+  while (cur->localDepth > 0) {
+    const size_t bit = size_t(1) << (cur->localDepth - 1);
+    Bucket *image = dir->slots[cur->bits ^ bit].load(memory_order_relaxed);
+    unique_lock<mutex> imageLck(image->latch, try_to_lock);
+    if (!imageLck.owns_lock() || image->localDepth != cur->localDepth ||
+        cur->entries.size() + image->entries.size() > bucketSize / 2) {
+      break;
+    }
+    for (size_t i = 0; i < image->entries.size(); i++) {
+      cur->fingerprints[cur->entries.size()] = image->fingerprints[i];
+      cur->entries.push_back(std::move(image->entries[i]));
+    }
+    image->entries.clear();
+    image->merged = true;
+    freeBuckets.push_back(image);
+    cur->localDepth--;
+    cur->bits &= bit - 1;
+    for (size_t i = cur->bits; i < dir->Size(); i += bit) {
+      dir->slots[i].store(cur, memory_order_release);
+    }
+    bucketNum--;
+    merged = true;
+  }
+  // each slot of the upper half points where its lower half twin does
+  while (merged && dir->depth > 0) {
+    const size_t half = dir->Size() / 2;
+    size_t i = 0;
+    while (i < half && dir->slots[i].load(memory_order_relaxed) ==
+                               dir->slots[i + half].load(memory_order_relaxed)) {
+      i++;
+    }
+    if (i < half) {
+      break;
+    }
+    Resize(dir->depth - 1);
+    dir = directory.load(memory_order_relaxed);
+  }
+}
+
 /*
  * insert <key,value> entry in hash table
  * Split & Redistribute bucket when there is overflow and if necessary increase
@@ -106,45 +284,51 @@ bool ExtendibleHash<K, V>::Remove(const K &key) {
  */
 template <typename K, typename V>
 void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {
-  int idx = getIdx(key);
-  shared_ptr<Bucket> cur = buckets[idx];
+  const size_t hash = HashKey(key);
+  const uint8_t fingerprint = Fingerprint(hash);
   while (true) {
-    lock_guard<mutex> lck(cur->latch);
-    if (cur->kmap.find(key) != cur->kmap.end() || cur->kmap.size() < bucketSize) {
-      cur->kmap[key] = value;
+    unique_lock<mutex> lck;
+    Bucket *cur = LockBucket(hash, lck);
+    int slot = FindSlot(*cur, key, fingerprint);
+    if (slot != -1) {
+      cur->entries[slot].second = value;
+      break;
+    }
+    if (cur->entries.size() < bucketSize) {
+      cur->fingerprints[cur->entries.size()] = fingerprint;
+      cur->entries.emplace_back(key, value);
       break;
     }
-    int mask = (1 << (cur->localDepth));
+    size_t mask = (size_t(1) << (cur->localDepth));
     cur->localDepth++;
 
-    {
-      lock_guard<mutex> lck2(latch);
-      if (cur->localDepth > globalDepth) {
+    lock_guard<mutex> lck2(latch);
+    Directory *dir = directory.load(memory_order_relaxed);
+    if (cur->localDepth > dir->depth) {
+      Resize(dir->depth + 1);
+      dir = directory.load(memory_order_relaxed);
+    }
+    unique_lock<mutex> lck3;
+    Bucket *newBuc = NewBucket(cur->localDepth, cur->bits | mask, lck3);
 
-        size_t length = buckets.size();
-        for (size_t i = 0; i < length; i++) {
-          buckets.push_back(buckets[i]);
+    // one pass: entries with the new bit set move out, the rest close up
+    size_t kept = 0;
+    for (size_t i = 0; i < cur->entries.size(); i++) {
+      if (HashKey(cur->entries[i].first) & mask) {
+        newBuc->fingerprints[newBuc->entries.size()] = cur->fingerprints[i];
+        newBuc->entries.push_back(std::move(cur->entries[i]));
+      } else {
+        if (kept != i) {
+          cur->fingerprints[kept] = cur->fingerprints[i];
+          cur->entries[kept] = std::move(cur->entries[i]);
         }
-        globalDepth++;
-
-      }
-      bucketNum++;
-      auto newBuc = make_shared<Bucket>(cur->localDepth);
-
-      typename map<K, V>::iterator it;
-      for (it = cur->kmap.begin(); it != cur->kmap.end(); ) {
-        if (HashKey(it->first) & mask) {
-          newBuc->kmap[it->first] = it->second;
-          it = cur->kmap.erase(it);
-        } else it++;
-      }
-      for (size_t i = 0; i < buckets.size(); i++) {
-        if (buckets[i] == cur && (i & mask))
-          buckets[i] = newBuc;
+        kept++;
       }
     }
-    idx = getIdx(key);
-    cur = buckets[idx];
+    cur->entries.erase(cur->entries.begin() + kept, cur->entries.end());
+    for (size_t i = newBuc->bits; i < dir->Size(); i += mask << 1) {
+      dir->slots[i].store(newBuc, memory_order_release);
+    }
   }
 }
 
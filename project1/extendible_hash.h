@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
 #include <vector>
 #include <string>
@@ -25,12 +27,39 @@ namespace cmudb {
 
 template <typename K, typename V>
 class ExtendibleHash : public HashTable<K, V> {
+  // fingerprints are compared 16 at a time
+  static const size_t FINGERPRINT_GROUP = 16;
+  /*
+   * Entries sit in one array reserved for the bucket size, packed at the
+   * front, each with one byte of its hash alongside so a lookup only compares
+   * the keys whose fingerprint matches.
+   */
   struct Bucket {
-    Bucket(int depth) : localDepth(depth) {};
+    Bucket(int depth, size_t bits, size_t size)
+        : localDepth(depth), bits(bits),
+          fingerprints((size + FINGERPRINT_GROUP - 1) & ~(FINGERPRINT_GROUP - 1)) {
+      entries.reserve(size);
+    };
     int localDepth;
-    map<K, V> kmap;
+    size_t bits;         // low localDepth bits of every hash it holds
+    bool merged = false; // emptied into its split image, out of the directory
+    vector<uint8_t> fingerprints; // valid for [0, entries.size())
+    vector<pair<K, V>> entries;
     mutex latch;
   };
+  /*
+   * The directory of one global depth. Lookups load it and a slot without
+   * latch and validate the bucket they reach under its own latch; splits and
+   * merges store into the slots, doubling or halving publishes the directory
+   * of the next depth.
+   */
+  struct Directory {
+    explicit Directory(int depth)
+        : depth(depth), slots(new atomic<Bucket *>[size_t(1) << depth]) {}
+    size_t Size() const { return size_t(1) << depth; }
+    int depth;
+    unique_ptr<atomic<Bucket *>[]> slots;
+  };
 public:
   // constructor
   ExtendibleHash(size_t size);
@@ -49,11 +78,24 @@ public:
   int getIdx(const K &key) const;
 
 private:
+  static uint8_t Fingerprint(size_t hash);
+  // slot of key in bucket, -1 if absent
+  int FindSlot(const Bucket &bucket, const K &key, uint8_t fingerprint) const;
+  Bucket *LockBucket(size_t hash, unique_lock<mutex> &lck);
+  Bucket *NewBucket(int depth, size_t bits, unique_lock<mutex> &lck);
+  void Merge(Bucket *cur);
+  void Resize(int depth);
+
   // add your own member variables here
-  int globalDepth;
   size_t bucketSize;
   int bucketNum;
-  vector<shared_ptr<Bucket>> buckets;
-  mutable mutex latch;
+  atomic<Directory *> directory;
+  // Lookups may still be on a bucket or directory that left the current
+  // directory, so none is freed before the table: merged buckets are reused
+  // by later splits, and there is one directory per depth ever reached
+  vector<unique_ptr<Bucket>> buckets;
+  vector<Bucket *> freeBuckets;
+  vector<unique_ptr<Directory>> directories;
+  mutable mutex latch; // directory writers
 };
 } // namespace cmudb
@@ -0,0 +1,101 @@
+/**
+ * Frame arena implementation
+ */
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <new>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "buffer/frame_arena.h"
+#include "common/logger.h"
+
+namespace cmudb {
+
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+// from numaif.h, libnuma is not required
+static const int MPOL_PREFERRED_POLICY = 1;
+
+static size_t RoundUp(size_t size, size_t unit) {
+  return (size + unit - 1) / unit * unit;
+}
+
+/*
+ * FrameArena Constructor
+ * Tries explicit huge pages first, falls back to a regular mapping with
+ * transparent huge pages requested, then to whatever madvise leaves us with
+ */
+FrameArena::FrameArena(size_t num_frames, size_t num_partitions) {
+  assert(num_frames > 0 && num_partitions > 0);
+  const size_t size = num_frames * PAGE_SIZE;
+  const int prot = PROT_READ | PROT_WRITE;
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+  mapped_size_ = RoundUp(size, HUGE_PAGE_SIZE);
+  void *region = mmap(nullptr, mapped_size_, prot, flags | MAP_HUGETLB, -1, 0);
+  backing_ = ArenaBacking::HUGETLB;
+  if (region == MAP_FAILED) {
+    // no huge pages reserved (vm.nr_hugepages), or not enough of them
+    mapped_size_ = RoundUp(size, sysconf(_SC_PAGESIZE));
+    region = mmap(nullptr, mapped_size_, prot, flags, -1, 0);
+    if (region == MAP_FAILED) {
+      LOG_DEBUG("mmap of the frame arena failed");
+      throw std::bad_alloc();
+    }
+    backing_ = madvise(region, mapped_size_, MADV_HUGEPAGE) == 0
+                       ? ArenaBacking::TRANSPARENT_HUGEPAGE
+                       : ArenaBacking::REGULAR;
+  }
+  region_ = static_cast<char *>(region);
+  if (num_partitions > 1) {
+    BindPartitions(num_frames, num_partitions);
+  }
+}
+
+FrameArena::~FrameArena() { munmap(region_, mapped_size_); }
+
+/*
+ * Number of NUMA nodes, from sysfs ("0" or "0-3"), 1 if unknown
+ */
+static int GetNumNodes() {
+  int first = 0, last = 0;
+  FILE *online = fopen("/sys/devices/system/node/online", "r");
+  if (online == nullptr) {
+    return 1;
+  }
+  int matched = fscanf(online, "%d-%d", &first, &last);
+  fclose(online);
+  return matched == 2 ? last + 1 : 1;
+}
+
+/*
+ * Prefer NUMA node i % (number of nodes) for partition i. Memory is placed
+ * when first touched, so this has to happen before the frames are used.
+ * Partitions are rounded to the page size backing the region, mbind failures
+ * (no NUMA support in the kernel) leave the default policy in place.
+ */
+void FrameArena::BindPartitions(size_t num_frames, size_t num_partitions) {
+  const int num_nodes = GetNumNodes();
+  if (num_nodes <= 1) {
+    return;
+  }
+  const size_t unit = backing_ == ArenaBacking::REGULAR
+                              ? sysconf(_SC_PAGESIZE)
+                              : HUGE_PAGE_SIZE;
+  const size_t partition_size = RoundUp(
+          (num_frames + num_partitions - 1) / num_partitions * PAGE_SIZE, unit);
+  for (size_t i = 0; i * partition_size < mapped_size_; ++i) {
+    unsigned long nodemask = 1ul << (i % num_nodes % 64);
+    size_t length = std::min(partition_size, mapped_size_ - i * partition_size);
+    if (syscall(SYS_mbind, region_ + i * partition_size, length,
+                MPOL_PREFERRED_POLICY, &nodemask, sizeof(nodemask) * 8 + 1,
+                0) != 0) {
+      LOG_DEBUG("mbind of frame arena partition %zu failed", i);
+      return;
+    }
+  }
+}
+
+} // namespace cmudb
@@ -0,0 +1,50 @@
+/*
+ * frame_arena.h
+ *
+ * Functionality: One contiguous memory region holding the page data of all
+ * the frames of a buffer pool, so that a large pool is covered by few TLB
+ * entries. The region comes from mmap and is at least 4 KiB aligned. It is
+ * backed by explicit huge pages (MAP_HUGETLB) when the system has some
+ * reserved, otherwise transparent huge pages are requested with madvise, and
+ * if that is not supported either it stays on regular pages.
+ * The region can be split into partitions placed on different NUMA nodes.
+ */
+
+#pragma once
+#include <cstddef>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+// what the memory of a FrameArena ended up backed by
+enum class ArenaBacking { HUGETLB = 0, TRANSPARENT_HUGEPAGE, REGULAR };
+
+class FrameArena {
+public:
+  // num_partitions > 1 spreads the partitions over NUMA nodes round robin
+  FrameArena(size_t num_frames, size_t num_partitions = 1);
+
+  ~FrameArena();
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  // PAGE_SIZE bytes of frame frame_id
+  inline char *GetFrame(size_t frame_id) {
+    return region_ + frame_id * PAGE_SIZE;
+  }
+
+  inline ArenaBacking GetBacking() const { return backing_; }
+
+  // size of the mapping, rounded up to the page size backing it
+  inline size_t GetMappedSize() const { return mapped_size_; }
+
+private:
+  void BindPartitions(size_t num_frames, size_t num_partitions);
+  char *region_;
+  size_t mapped_size_;
+  ArenaBacking backing_;
+};
+
+} // namespace cmudb
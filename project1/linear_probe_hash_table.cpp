@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <functional>
+
+#include "hash/linear_probe_hash_table.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+// failed optimistic probes before a lookup takes latch_
+static const int FIND_RETRIES = 16;
+// slots of an outgrown table moved by each Insert or Remove: the move is over
+// long before the new table, twice as large, is half full
+static const size_t MIGRATE_SLOTS = 8;
+
+// reader counter stripe of the calling thread, handed out round robin
+static size_t ReaderStripe() {
+  static std::atomic<size_t> next_stripe(0);
+  static thread_local size_t stripe = next_stripe.fetch_add(1);
+  return stripe;
+}
+
+template <typename K, typename V>
+LinearProbeHashTable<K, V>::Table::Table(size_t capacity, const K &empty_key)
+    : mask(capacity - 1), slots(new Slot[capacity]),
+      versions(new std::atomic<uint64_t>[std::max<size_t>(
+              capacity >> STRIPE_BITS, 1)]) {
+  for (size_t i = 0; i < capacity; ++i) {
+    slots[i].key.store(empty_key, std::memory_order_relaxed);
+    slots[i].value.store(V(), std::memory_order_relaxed);
+  }
+  for (size_t i = 0; i < std::max<size_t>(capacity >> STRIPE_BITS, 1); ++i) {
+    versions[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+/*
+ * constructor
+ * the table is at most half full, it starts with the next power of 2 slots
+ * above 2 * capacity
+ */
+template <typename K, typename V>
+LinearProbeHashTable<K, V>::LinearProbeHashTable(size_t capacity,
+                                                 const K &empty_key)
+    : empty_key_(empty_key) {
+  size_t slots = 2;
+  while (slots < 2 * capacity) {
+    slots <<= 1;
+  }
+  current_.reset(new Table(slots, empty_key_));
+  table_.store(current_.get(), std::memory_order_release);
+}
+
+/*
+ * helper function to calculate the home slot of a key, page ids are
+ * consecutive so the hash is mixed (murmur3 finalizer) before masking
+ */
+template <typename K, typename V>
+size_t LinearProbeHashTable<K, V>::HashKey(const K &key) const {
+  uint64_t h = std::hash<K>{}(key);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return static_cast<size_t>(h);
+}
+
+template <typename K, typename V>
+size_t LinearProbeHashTable<K, V>::GetSize() {
+  std::lock_guard<std::mutex> lck(latch_);
+  return size_;
+}
+
+template <typename K, typename V>
+size_t LinearProbeHashTable<K, V>::GetCapacity() {
+  std::lock_guard<std::mutex> lck(latch_);
+  return (current_->mask + 1) / 2;
+}
+
+/*
+ * Probe from the home slot of key up to key or an empty slot. The version of
+ * every stripe of slots read is taken before reading it and checked again at
+ * the end, like Page::Validate does for a page: a removal shifting entries
+ * in the meantime changes one of them.
+ * return false if the result can not be trusted
+ */
+template <typename K, typename V>
+bool LinearProbeHashTable<K, V>::TryFind(Table *t, const K &key, V &value,
+                                         bool &found) const {
+  // enough for any probe sequence of a table at most half full, in practice
+  const int max_stripes = 8;
+  size_t stripes[max_stripes];
+  uint64_t seen[max_stripes];
+  int num_stripes = 0;
+  found = false;
+  size_t i = HashKey(key) & t->mask;
+  for (size_t probed = 0; probed <= t->mask; ++probed, i = (i + 1) & t->mask) {
+    const size_t stripe = i >> STRIPE_BITS;
+    if (num_stripes == 0 || stripes[num_stripes - 1] != stripe) {
+      if (num_stripes == max_stripes) {
+        return false;
+      }
+      uint64_t version = t->versions[stripe].load(std::memory_order_acquire);
+      if (version & 1) {
+        return false;
+      }
+      stripes[num_stripes] = stripe;
+      seen[num_stripes++] = version;
+    }
+    const K k = t->slots[i].key.load(std::memory_order_acquire);
+    if (k == empty_key_) {
+      break;
+    }
+    if (k == key) {
+      value = t->slots[i].value.load(std::memory_order_relaxed);
+      found = true;
+      break;
+    }
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  for (int j = 0; j < num_stripes; ++j) {
+    if (t->versions[stripes[j]].load(std::memory_order_relaxed) != seen[j]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * lookup function to find value associate with input key, without any lock
+ * unless writers keep getting in the way
+ * The reader count goes up before table_ is read (both sequentially
+ * consistent, against the store of table_ and the check of the counts in
+ * Reclaim): either Reclaim sees this lookup, or this lookup sees the new
+ * table. The same goes for the outgrown table of a migration.
+ * A key missing from the table may not have moved from the outgrown one yet,
+ * where it is looked up next. That answer only holds if the migration was
+ * still going on, until when removals keep the outgrown table up to date.
+ */
+template <typename K, typename V>
+bool LinearProbeHashTable<K, V>::Find(const K &key, V &value) {
+  std::atomic<size_t> &readers =
+          readers_[ReaderStripe() % READER_STRIPES].count;
+  readers.fetch_add(1);
+  bool found;
+  for (int i = 0; i < FIND_RETRIES; ++i) {
+    Table *t = table_.load();
+    Table *outgrown = t->outgrown.load();
+    if (!TryFind(t, key, value, found)) {
+      continue;
+    }
+    if (!found && outgrown != nullptr &&
+        (!TryFind(outgrown, key, value, found) ||
+         t->outgrown.load() != outgrown)) {
+      continue;
+    }
+    readers.fetch_sub(1, std::memory_order_release);
+    return found;
+  }
+  readers.fetch_sub(1, std::memory_order_release);
+  std::lock_guard<std::mutex> lck(latch_);
+  return Lookup(current_.get(), key, value) ||
+         (migrating_ != nullptr && Lookup(migrating_.get(), key, value));
+}
+
+template <typename K, typename V>
+bool LinearProbeHashTable<K, V>::Lookup(Table *t, const K &key,
+                                        V &value) const {
+  for (size_t i = HashKey(key) & t->mask;; i = (i + 1) & t->mask) {
+    const K k = t->slots[i].key.load(std::memory_order_relaxed);
+    if (k == empty_key_) {
+      return false;
+    }
+    if (k == key) {
+      value = t->slots[i].value.load(std::memory_order_relaxed);
+      return true;
+    }
+  }
+}
+
+/*
+ * delete <key,value> entry in hash table
+ * While a migration goes on the key goes out of the outgrown table first: a
+ * lookup that misses it in the new table then misses it in the outgrown one
+ * too, instead of finding a value the new table has replaced.
+ */
+template <typename K, typename V>
+bool LinearProbeHashTable<K, V>::Remove(const K &key) {
+  std::lock_guard<std::mutex> lck(latch_);
+  bool found = migrating_ != nullptr &&
+               Erase(migrating_.get(), key, current_.get());
+  if (Erase(current_.get(), key, nullptr)) {
+    found = true;
+  }
+  if (found) {
+    size_--;
+  }
+  if (migrating_ != nullptr) {
+    Migrate();
+  }
+  return found;
+}
+
+/*
+ * Delete key from t. The entries after it move back into the hole when their
+ * home slot allows it, so no tombstone is left and probes stay short however
+ * many keys come and go (page ids only ever grow). An entry moved back may
+ * land behind the migration cursor, so every entry moved is put in keep
+ * first, unless keep has it already.
+ */
+template <typename K, typename V>
+bool LinearProbeHashTable<K, V>::Erase(Table *t, const K &key, Table *keep) {
+  size_t i = HashKey(key) & t->mask;
+  while (true) {
+    const K k = t->slots[i].key.load(std::memory_order_relaxed);
+    if (k == empty_key_) {
+      return false;
+    }
+    if (k == key) {
+      break;
+    }
+    i = (i + 1) & t->mask;
+  }
+  // make the stripe of a slot odd before its first change
+  std::vector<size_t> touched;
+  auto begin_write = [&](size_t slot) {
+    const size_t stripe = slot >> STRIPE_BITS;
+    if (std::find(touched.begin(), touched.end(), stripe) == touched.end()) {
+      touched.push_back(stripe);
+      t->versions[stripe].fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+  };
+  begin_write(i);
+  for (size_t j = (i + 1) & t->mask;; j = (j + 1) & t->mask) {
+    const K k = t->slots[j].key.load(std::memory_order_relaxed);
+    if (k == empty_key_) {
+      break;
+    }
+    // k stays if its home slot lies in (i, j], cyclically
+    const size_t home = HashKey(k) & t->mask;
+    if (i <= j ? (i < home && home <= j) : (i < home || home <= j)) {
+      continue;
+    }
+    const V v = t->slots[j].value.load(std::memory_order_relaxed);
+    if (keep != nullptr) {
+      Put(keep, k, v, false);
+    }
+    begin_write(j);
+    t->slots[i].value.store(v, std::memory_order_relaxed);
+    t->slots[i].key.store(k, std::memory_order_relaxed);
+    i = j;
+  }
+  t->slots[i].key.store(empty_key_, std::memory_order_relaxed);
+  for (size_t stripe : touched) {
+    t->versions[stripe].fetch_add(1, std::memory_order_release);
+  }
+  return true;
+}
+
+/*
+ * insert <key,value> entry in hash table, or update the value of key
+ * New entries only go to the newest table; a key still in the outgrown one
+ * is counted already.
+ */
+template <typename K, typename V>
+void LinearProbeHashTable<K, V>::Insert(const K &key, const V &value) {
+  std::lock_guard<std::mutex> lck(latch_);
+  if (!retired_.empty()) {
+    Reclaim();
+  }
+  if (2 * (size_ + 1) > current_->mask + 1) {
+    // never happens with MIGRATE_SLOTS slots moved per write, but one
+    // migration must be over before the next one starts
+    while (migrating_ != nullptr) {
+      Migrate();
+    }
+    Grow();
+  }
+  V old_value;
+  if (Put(current_.get(), key, value, true) &&
+      (migrating_ == nullptr || !Lookup(migrating_.get(), key, old_value))) {
+    size_++;
+  }
+  if (migrating_ != nullptr) {
+    Migrate();
+  }
+}
+
+/*
+ * Put <key,value> in t, or update the value of key when update is set.
+ * return true if key was not in t
+ * The value of a new entry is stored before its key is published, which is
+ * all a lookup needs: nothing moves.
+ */
+template <typename K, typename V>
+bool LinearProbeHashTable<K, V>::Put(Table *t, const K &key, const V &value,
+                                     bool update) {
+  for (size_t i = HashKey(key) & t->mask;; i = (i + 1) & t->mask) {
+    const K k = t->slots[i].key.load(std::memory_order_relaxed);
+    if (k == key) {
+      if (update) {
+        t->slots[i].value.store(value, std::memory_order_release);
+      }
+      return false;
+    }
+    if (k == empty_key_) {
+      t->slots[i].value.store(value, std::memory_order_relaxed);
+      t->slots[i].key.store(key, std::memory_order_release);
+      return true;
+    }
+  }
+}
+
+/*
+ * Called with latch_ held: publish an empty table twice as large. Its
+ * entries move in a few slots at a time, by Migrate, so no single Insert
+ * pays for rehashing the whole table. The outgrown table is set before the
+ * new one is published, lookups never see the new table without it.
+ */
+template <typename K, typename V>
+void LinearProbeHashTable<K, V>::Grow() {
+  Table *t = new Table(2 * (current_->mask + 1), empty_key_);
+  t->outgrown.store(current_.get(), std::memory_order_relaxed);
+  migrating_ = std::move(current_);
+  migrated_ = 0;
+  current_.reset(t);
+  table_.store(t);
+}
+
+/*
+ * Put the entries of the next MIGRATE_SLOTS slots of migrating_ in the new
+ * table, unless it has them already with a newer value. The outgrown table
+ * keeps them, lookups may be in it. Once every slot is done it is retired.
+ */
+template <typename K, typename V>
+void LinearProbeHashTable<K, V>::Migrate() {
+  Table *old = migrating_.get();
+  for (size_t n = 0; n < MIGRATE_SLOTS && migrated_ <= old->mask;
+       ++n, ++migrated_) {
+    const K k = old->slots[migrated_].key.load(std::memory_order_relaxed);
+    if (k != empty_key_) {
+      Put(current_.get(), k,
+          old->slots[migrated_].value.load(std::memory_order_relaxed), false);
+    }
+  }
+  if (migrated_ > old->mask) {
+    current_->outgrown.store(nullptr);
+    retired_.push_back(std::move(migrating_));
+    Reclaim();
+  }
+}
+
+template <typename K, typename V>
+void LinearProbeHashTable<K, V>::Reclaim() {
+  for (size_t i = 0; i < READER_STRIPES; ++i) {
+    if (readers_[i].count.load() != 0) {
+      return;
+    }
+  }
+  retired_.clear();
+}
+
+template class LinearProbeHashTable<page_id_t, Page *>;
+// test purpose
+template class LinearProbeHashTable<int, int>;
+} // namespace cmudb
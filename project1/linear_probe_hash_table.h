@@ -0,0 +1,96 @@
+/*
+ * linear_probe_hash_table.h : concurrent open addressing hash table
+ *
+ * Functionality: Same job as ExtendibleHash for the page table of the buffer
+ * pool manager, but lookups take no lock. Keys and values live in atomic
+ * slots of one flat array probed linearly. Writers are serialized by a mutex;
+ * a removal shifts the following entries back instead of leaving a
+ * tombstone, and bumps the version of every stripe of slots it touches, so a
+ * concurrent lookup that might have missed a moving entry notices and probes
+ * again. A lookup that keeps losing that race 16 times takes the mutex.
+ * Lookups still write shared memory: they count themselves in one of a few
+ * striped reader counters (one cache line each, shared by the threads that
+ * hash to it) while they probe, so an outgrown table is only freed by a
+ * writer that finds all of them at zero.
+ * Growing is incremental: a table twice as large is published at once, and
+ * every following Insert or Remove moves a few slots of the outgrown table
+ * into it. Until the last one moved, a key missing from the new table is
+ * looked up in the outgrown one, which removals keep up to date.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "hash/hash_table.h"
+
+namespace cmudb {
+
+template <typename K, typename V>
+class LinearProbeHashTable : public HashTable<K, V> {
+  static_assert(std::is_trivially_copyable<K>::value &&
+                        std::is_trivially_copyable<V>::value,
+                "keys and values are kept in atomic slots");
+  // slots per stripe version
+  static const size_t STRIPE_BITS = 6;
+  // reader counters, a lookup only touches the one of its thread
+  static const size_t READER_STRIPES = 16;
+  struct ReaderCount {
+    std::atomic<size_t> count{0};
+    char padding[64 - sizeof(std::atomic<size_t>)]; // one per cache line
+  };
+  struct Slot {
+    std::atomic<K> key;
+    std::atomic<V> value;
+  };
+  struct Table {
+    Table(size_t capacity, const K &empty_key);
+    size_t mask; // capacity - 1, capacity is a power of 2
+    std::unique_ptr<Slot[]> slots;
+    std::unique_ptr<std::atomic<uint64_t>[]> versions; // odd while written
+    std::atomic<Table *> outgrown{nullptr}; // moving in, null once it's over
+  };
+
+public:
+  // room for capacity entries before growing, empty_key is never inserted
+  LinearProbeHashTable(size_t capacity, const K &empty_key);
+
+  // lookup and modifier
+  bool Find(const K &key, V &value) override;
+  bool Remove(const K &key) override;
+  void Insert(const K &key, const V &value) override;
+
+  size_t GetSize();
+  size_t GetCapacity();
+
+private:
+  size_t HashKey(const K &key) const;
+  // probe t once, return false if a writer got in the way
+  bool TryFind(Table *t, const K &key, V &value, bool &found) const;
+  // called with latch_ held: probe, insert or delete in one table
+  bool Lookup(Table *t, const K &key, V &value) const;
+  bool Put(Table *t, const K &key, const V &value, bool update);
+  bool Erase(Table *t, const K &key, Table *keep);
+  void Grow();
+  // called with latch_ held: move the next few slots of migrating_
+  void Migrate();
+  // called with latch_ held: free the outgrown tables no lookup is in
+  void Reclaim();
+
+  const K empty_key_;
+  std::atomic<Table *> table_;
+  std::unique_ptr<Table> current_;
+  std::unique_ptr<Table> migrating_; // outgrown, not moved out entirely yet
+  size_t migrated_ = 0;              // slots of migrating_ moved
+  std::vector<std::unique_ptr<Table>> retired_; // outgrown, maybe still read
+  ReaderCount readers_[READER_STRIPES];         // lookups without latch_
+  std::mutex latch_;                            // writers
+  size_t size_ = 0;
+};
+
+} // namespace cmudb
@@ -0,0 +1,91 @@
+/**
+ * LRU-K implementation
+ */
+#include <cassert>
+
+#include "buffer/lru_k_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T> LRUKReplacer<T>::LRUKReplacer(size_t k) : k_(k) {
+  assert(k_ > 0);
+}
+
+template <typename T> LRUKReplacer<T>::~LRUKReplacer() {}
+
+/*
+ * Insert value into the replacer, counts as one access
+ */
+template <typename T> void LRUKReplacer<T>::Insert(const T &value) {
+  lock_guard<mutex> lck(latch);
+  History &history = histories_[value];
+  if (history.evictable) {
+    evictable_.erase(GetKey(history));
+  }
+  history.accesses.push_back(current_timestamp_++);
+  if (history.accesses.size() > k_) {
+    history.accesses.pop_front();
+  }
+  history.evictable = true;
+  evictable_[GetKey(history)] = value;
+}
+
+/* If there is an evictable value, pop the one with the largest backward
+ * K-distance to argument "value", and return true. Otherwise return false
+ */
+template <typename T> bool LRUKReplacer<T>::Victim(T &value) {
+  lock_guard<mutex> lck(latch);
+  if (evictable_.empty()) {
+    return false;
+  }
+  value = evictable_.begin()->second;
+  evictable_.erase(evictable_.begin());
+  histories_.erase(value);
+  return true;
+}
+
+/*
+ * Remove value and its access history, a frame erased this way comes back
+ * holding another page. If it was evictable, return true, otherwise return
+ * false
+ */
+template <typename T> bool LRUKReplacer<T>::Erase(const T &value) {
+  lock_guard<mutex> lck(latch);
+  auto it = histories_.find(value);
+  if (it == histories_.end()) {
+    return false;
+  }
+  const bool evictable = it->second.evictable;
+  if (evictable) {
+    evictable_.erase(GetKey(it->second));
+  }
+  histories_.erase(it);
+  return evictable;
+}
+
+/*
+ * Remove value from the evictable set, its history counts on the next
+ * Insert. If it was evictable, return true, otherwise return false
+ */
+template <typename T> bool LRUKReplacer<T>::Pin(const T &value) {
+  lock_guard<mutex> lck(latch);
+  auto it = histories_.find(value);
+  if (it == histories_.end() || !it->second.evictable) {
+    return false;
+  }
+  evictable_.erase(GetKey(it->second));
+  it->second.evictable = false;
+  return true;
+}
+
+template <typename T> size_t LRUKReplacer<T>::Size() {
+  lock_guard<mutex> lck(latch);
+  return evictable_.size();
+}
+
+template class LRUKReplacer<Page *>;
+// test only
+template class LRUKReplacer<int>;
+
+} // namespace cmudb
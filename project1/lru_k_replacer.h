@@ -0,0 +1,64 @@
+/**
+ * lru_k_replacer.h
+ *
+ * Functionality: LRU-K replacement policy. The replacer remembers the last K
+ * times each value was inserted (unpinned), and evicts the value whose K-th
+ * most recent access is the oldest, i.e. with the largest backward K-distance.
+ * Values accessed less than K times have an infinite K-distance and are
+ * evicted first, oldest access first. A page read once by a sequential scan
+ * therefore never pushes out a page that is used over and over.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include "buffer/replacer.h"
+
+using namespace std;
+namespace cmudb {
+
+template <typename T> class LRUKReplacer : public Replacer<T> {
+  // eviction order: values with less than K accesses first, then by the
+  // timestamp of the K-th most recent (or the oldest known) access
+  typedef pair<bool, uint64_t> Key;
+  struct History {
+    deque<uint64_t> accesses; // at most K timestamps, oldest first
+    bool evictable = false;
+  };
+
+public:
+  explicit LRUKReplacer(size_t k = 2);
+
+  ~LRUKReplacer();
+
+  // record an access, value becomes evictable
+  void Insert(const T &value);
+
+  // evict and forget the value with the largest backward K-distance
+  bool Victim(T &value);
+
+  // value is not evictable and its history is forgotten
+  bool Erase(const T &value);
+
+  // value is not evictable anymore, its history is kept
+  bool Pin(const T &value);
+
+  size_t Size();
+
+private:
+  Key GetKey(const History &history) const {
+    return Key(history.accesses.size() >= k_, history.accesses.front());
+  }
+  const size_t k_;
+  uint64_t current_timestamp_ = 0;
+  unordered_map<T, History> histories_;
+  map<Key, T> evictable_;
+  mutable mutex latch;
+};
+
+} // namespace cmudb
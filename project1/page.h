@@ -0,0 +1,94 @@
+/**
+ * page.h
+ *
+ * Wrapper around actual data page in main memory and also contains bookkeeping
+ * information used by buffer pool manager like pin_count/dirty_flag/page_id.
+ * Use page as a basic unit within the database system
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "common/config.h"
+#include "common/rwmutex.h"
+
+namespace cmudb {
+
+class Page {
+  friend class BufferPoolManager;
+
+public:
+  ~Page(){};
+  // get actual data page content
+  inline char *GetData() { return data_; }
+  // get page id
+  inline page_id_t GetPageId() { return page_id_; }
+  // get page pin count
+  inline int GetPinCount() { return pin_count_; }
+  // method use to latch/unlatch page content, the version is odd while the
+  // page is write latched
+  inline void WUnlatch() {
+    EndWrite();
+    rwlatch_.WUnlock();
+  }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    BeginWrite();
+  }
+  inline void RUnlatch() { rwlatch_.RUnlock(); }
+  inline void RLatch() { rwlatch_.RLock(); }
+  // optimistic read, see BufferPoolManager::FetchPageOptimistic: whatever was
+  // read without a latch after GetVersion() is only consistent if
+  // Validate(version) holds afterwards
+  inline uint64_t GetVersion() {
+    return version_.load(std::memory_order_acquire);
+  }
+  inline bool Validate(uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
+  inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + 4); }
+  inline void SetLSN(lsn_t lsn) { memcpy(GetData() + 4, &lsn, 4); }
+
+private:
+  // only the buffer pool manager creates pages, an array of them pointed to
+  // their frames right away, so that data_ is never read while null
+  Page() {}
+  // method used by buffer pool manager
+  inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
+  // make the version odd before writing, even again once done. A swizzle
+  // takes the version without the latch (see BufferPoolManager::Swizzle), so
+  // wait for an even version.
+  inline void BeginWrite() {
+    while (!TryBeginWrite()) {
+      std::this_thread::yield();
+    }
+  }
+  inline bool TryBeginWrite() {
+    uint64_t version = version_.load(std::memory_order_relaxed);
+    if ((version & 1) ||
+        !version_.compare_exchange_strong(version, version + 1,
+                                          std::memory_order_acquire)) {
+      return false;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+  }
+  inline void EndWrite() { version_.fetch_add(1, std::memory_order_release); }
+  // members
+  char *data_ = nullptr; // actual data, PAGE_SIZE bytes of a FrameArena
+  page_id_t page_id_ = INVALID_PAGE_ID;
+  int pin_count_ = 0;
+  bool is_dirty_ = false;
+  RWMutex rwlatch_;
+  std::atomic<uint64_t> version_{0}; // bumped by every writer of the frame
+  int swizzled_ = 0; // child page ids swizzled inside this page
+};
+
+} // namespace cmudb
@@ -0,0 +1,66 @@
+/**
+ * Page guard implementation
+ */
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/page_guard.h"
+
+namespace cmudb {
+
+ReadPageGuard::ReadPageGuard(ReadPageGuard &&other) noexcept
+    : buffer_pool_manager_(other.buffer_pool_manager_), page_(other.page_) {
+  other.page_ = nullptr;
+}
+
+/*
+ * The page held so far is released first, after other's page was latched:
+ * moving the guard of a child into the guard of its parent crabs down
+ */
+ReadPageGuard &ReadPageGuard::operator=(ReadPageGuard &&other) noexcept {
+  if (this != &other) {
+    Release();
+    buffer_pool_manager_ = other.buffer_pool_manager_;
+    page_ = other.page_;
+    other.page_ = nullptr;
+  }
+  return *this;
+}
+
+void ReadPageGuard::Release() {
+  if (page_ == nullptr) {
+    return;
+  }
+  page_->RUnlatch();
+  buffer_pool_manager_->UnpinFrame(page_, false);
+  page_ = nullptr;
+}
+
+WritePageGuard::WritePageGuard(WritePageGuard &&other) noexcept
+    : buffer_pool_manager_(other.buffer_pool_manager_), page_(other.page_),
+      is_dirty_(other.is_dirty_) {
+  other.page_ = nullptr;
+}
+
+WritePageGuard &WritePageGuard::operator=(WritePageGuard &&other) noexcept {
+  if (this != &other) {
+    Release();
+    buffer_pool_manager_ = other.buffer_pool_manager_;
+    page_ = other.page_;
+    is_dirty_ = other.is_dirty_;
+    other.page_ = nullptr;
+  }
+  return *this;
+}
+
+void WritePageGuard::Release() {
+  if (page_ == nullptr) {
+    return;
+  }
+  page_->WUnlatch();
+  buffer_pool_manager_->UnpinFrame(page_, is_dirty_);
+  page_ = nullptr;
+  is_dirty_ = false;
+}
+
+} // namespace cmudb
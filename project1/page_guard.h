@@ -0,0 +1,77 @@
+/**
+ * page_guard.h
+ *
+ * Handles of a page pinned and latched through the buffer pool manager (see
+ * BufferPoolManager::FetchPageRead/FetchPageWrite/NewPageGuarded). A guard
+ * owns both the pin and the latch and gives them back together, straight to
+ * the frame, when it is destroyed or released. Guards are move only.
+ */
+
+#pragma once
+
+#include "page/page.h"
+
+namespace cmudb {
+class BufferPoolManager;
+
+class ReadPageGuard {
+public:
+  ReadPageGuard() = default;
+  // page is pinned and read latched already
+  ReadPageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : buffer_pool_manager_(buffer_pool_manager), page_(page) {}
+  ReadPageGuard(ReadPageGuard &&other) noexcept;
+  ReadPageGuard &operator=(ReadPageGuard &&other) noexcept;
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  ReadPageGuard &operator=(const ReadPageGuard &) = delete;
+  ~ReadPageGuard() { Release(); }
+
+  // unlatch and unpin now, the guard is empty afterwards
+  void Release();
+
+  inline bool IsEmpty() const { return page_ == nullptr; }
+  inline Page *GetPage() const { return page_; }
+  inline page_id_t GetPageId() const { return page_->GetPageId(); }
+  inline const char *GetData() const { return page_->GetData(); }
+  // the content of the page seen as a T, e.g. a B+ tree page
+  template <typename T> inline T *As() const {
+    return reinterpret_cast<T *>(page_->GetData());
+  }
+
+private:
+  BufferPoolManager *buffer_pool_manager_ = nullptr;
+  Page *page_ = nullptr;
+};
+
+class WritePageGuard {
+public:
+  WritePageGuard() = default;
+  // page is pinned and write latched already
+  WritePageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : buffer_pool_manager_(buffer_pool_manager), page_(page) {}
+  WritePageGuard(WritePageGuard &&other) noexcept;
+  WritePageGuard &operator=(WritePageGuard &&other) noexcept;
+  WritePageGuard(const WritePageGuard &) = delete;
+  WritePageGuard &operator=(const WritePageGuard &) = delete;
+  ~WritePageGuard() { Release(); }
+
+  // unlatch and unpin now, dirty if MarkDirty was called, the guard is empty
+  // afterwards
+  void Release();
+  inline void MarkDirty() { is_dirty_ = true; }
+
+  inline bool IsEmpty() const { return page_ == nullptr; }
+  inline Page *GetPage() const { return page_; }
+  inline page_id_t GetPageId() const { return page_->GetPageId(); }
+  inline char *GetData() const { return page_->GetData(); }
+  template <typename T> inline T *As() const {
+    return reinterpret_cast<T *>(page_->GetData());
+  }
+
+private:
+  BufferPoolManager *buffer_pool_manager_ = nullptr;
+  Page *page_ = nullptr;
+  bool is_dirty_ = false;
+};
+
+} // namespace cmudb
@@ -0,0 +1,245 @@
+#include <algorithm>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+namespace cmudb {
+
+/*
+ * ParallelBufferPoolManager Constructor
+ * Creates num_instances buffer pools with pool_size frames each
+ */
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances,
+                                                     size_t pool_size,
+                                                     DiskManager *disk_manager,
+                                                     LogManager *log_manager,
+                                                     ReplacerType replacer_type)
+    : BufferPoolManager(disk_manager, log_manager),
+      num_instances_(num_instances), disk_manager_(disk_manager),
+      spare_ids_(num_instances) {
+  assert(num_instances_ > 0);
+  for (size_t i = 0; i < num_instances_; ++i) {
+    instances_.push_back(
+            new BufferPoolManager(pool_size, disk_manager, log_manager,
+                                  replacer_type));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // the dumper calls GetStats() of the instances
+  StopStatsDumper();
+  StopPageCleaner();
+  for (auto instance : instances_) {
+    delete instance;
+  }
+}
+
+/*
+ * A page is owned by exactly one instance, picked by its page id
+ */
+BufferPoolManager *ParallelBufferPoolManager::GetInstance(page_id_t page_id) {
+  assert(page_id >= 0);
+  return instances_[page_id % num_instances_];
+}
+
+/*
+ * An instance only sees every num_instances_-th page of a scan, so sequential
+ * scans are detected here, on the page ids of the whole pool
+ */
+Page *ParallelBufferPoolManager::FetchPage(page_id_t page_id) {
+  page_id_t first;
+  size_t count;
+  bool sequential = false;
+  if (read_ahead_window_ > 0) {
+    lock_guard<mutex> lck(scan_latch_);
+    sequential = SequentialFetch(page_id, first, count);
+  }
+  if (sequential) {
+    Prefetch(first, count);
+  }
+  return GetInstance(page_id)->FetchPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::FetchPageOptimistic(page_id_t page_id,
+                                                    uint64_t &version) {
+  return GetInstance(page_id)->FetchPageOptimistic(page_id, version);
+}
+
+/*
+ * Not supported: the parent and the child of a swizzled id may belong to
+ * different instances, so it would need the latches of both
+ */
+void ParallelBufferPoolManager::SetSwizzling(size_t) {}
+
+bool ParallelBufferPoolManager::Swizzle(Page *, uint64_t, page_id_t *,
+                                        Page *) {
+  return false;
+}
+
+void ParallelBufferPoolManager::Unswizzle(Page *) {}
+
+bool ParallelBufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::UnpinFrame(Page *page, bool is_dirty) {
+  return GetInstance(page->GetPageId())->UnpinFrame(page, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetInstance(page_id)->FlushPage(page_id);
+}
+
+bool ParallelBufferPoolManager::DeletePage(page_id_t page_id) {
+  return GetInstance(page_id)->DeletePage(page_id);
+}
+
+/*
+ * The page id decides the owning instance. Instances are tried in turn, each
+ * with a page id of its own: one that instance could not take before, or a
+ * fresh one. If all of its frames are pinned the id is kept for the next try
+ * of that instance, so no id is lost and no hole left in the file, and a
+ * single full instance does not make the whole pool look full.
+ * return nullptr if no instance could take the page
+ */
+Page *ParallelBufferPoolManager::NewPage(page_id_t &page_id) {
+  size_t first;
+  {
+    lock_guard<mutex> lck(alloc_latch_);
+    first = next_instance_++ % num_instances_;
+  }
+  for (size_t i = 0; i < num_instances_; ++i) {
+    const size_t instance = (first + i) % num_instances_;
+    page_id_t tar_id = TakePageId(instance);
+    Page *tar = instances_[instance]->NewPageWithId(tar_id);
+    if (tar != nullptr) {
+      page_id = tar_id;
+      return tar;
+    }
+    lock_guard<mutex> lck(alloc_latch_);
+    spare_ids_[instance].push_front(tar_id);
+  }
+  return nullptr;
+}
+
+/*
+ * A page id owned by instance: a spare one, or fresh ones allocated until one
+ * is, the others kept as spares of their instances
+ */
+page_id_t ParallelBufferPoolManager::TakePageId(size_t instance) {
+  lock_guard<mutex> lck(alloc_latch_);
+  while (spare_ids_[instance].empty()) {
+    page_id_t page_id = disk_manager_->AllocatePage();
+    spare_ids_[page_id % num_instances_].push_back(page_id);
+  }
+  page_id_t page_id = spare_ids_[instance].front();
+  spare_ids_[instance].pop_front();
+  return page_id;
+}
+
+/*
+ * Consecutive page ids live in different instances, so flushing instance by
+ * instance would never coalesce anything. Claim dirty pages from every
+ * instance, write them in a single sorted pass and release them afterwards.
+ * batch is split evenly among the instances.
+ */
+FlushStats ParallelBufferPoolManager::FlushDirtyPages(size_t batch) {
+  FlushStats stats;
+  const size_t per_instance =
+          batch / num_instances_ + (batch % num_instances_ != 0);
+  std::vector<std::vector<FlushTarget>> claimed(num_instances_);
+  std::vector<FlushTarget> targets;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    instances_[i]->ClaimDirtyPages(per_instance, claimed[i]);
+    targets.insert(targets.end(), claimed[i].begin(), claimed[i].end());
+  }
+  std::sort(targets.begin(), targets.end(),
+            [](const FlushTarget &a, const FlushTarget &b) {
+              return a.page_id < b.page_id;
+            });
+  WriteDirtyPages(targets, stats);
+  for (size_t i = 0; i < num_instances_; ++i) {
+    instances_[i]->ReleaseDirtyPages(claimed[i]);
+  }
+  return stats;
+}
+
+void ParallelBufferPoolManager::Prefetch(page_id_t page_id, size_t count) {
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < count; ++i) {
+    page_ids.push_back(page_id + i);
+  }
+  Prefetch(page_ids);
+}
+
+void ParallelBufferPoolManager::Prefetch(
+        const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> owned(num_instances_);
+  for (auto page_id : page_ids) {
+    if (page_id != INVALID_PAGE_ID) {
+      owned[page_id % num_instances_].push_back(page_id);
+    }
+  }
+  for (size_t i = 0; i < num_instances_; ++i) {
+    if (!owned[i].empty()) {
+      instances_[i]->Prefetch(owned[i]);
+    }
+  }
+}
+
+void ParallelBufferPoolManager::WaitForPrefetch() {
+  for (auto instance : instances_) {
+    instance->WaitForPrefetch();
+  }
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStats() {
+  BufferPoolStats stats;
+  for (auto instance : instances_) {
+    BufferPoolStats instance_stats = instance->GetStats();
+    stats.hits += instance_stats.hits;
+    stats.misses += instance_stats.misses;
+    stats.evictions += instance_stats.evictions;
+    stats.dirty_write_backs += instance_stats.dirty_write_backs;
+    stats.cleaner_writes += instance_stats.cleaner_writes;
+    stats.wal_flushes += instance_stats.wal_flushes;
+    stats.pin_waits += instance_stats.pin_waits;
+    stats.all_pinned += instance_stats.all_pinned;
+    stats.prefetched += instance_stats.prefetched;
+    stats.swizzles += instance_stats.swizzles;
+    stats.unswizzles += instance_stats.unswizzles;
+    stats.b1_ghost_hits += instance_stats.b1_ghost_hits;
+    stats.b2_ghost_hits += instance_stats.b2_ghost_hits;
+    stats.target_t1 += instance_stats.target_t1;
+    for (size_t i = 0; i < BufferPoolStats::HISTOGRAM_SIZE; ++i) {
+      stats.latch_wait[i] += instance_stats.latch_wait[i];
+    }
+  }
+  return stats;
+}
+
+void ParallelBufferPoolManager::RunPageCleaner(double high_watermark,
+                                               double low_watermark) {
+  for (auto instance : instances_) {
+    instance->RunPageCleaner(high_watermark, low_watermark);
+  }
+}
+
+void ParallelBufferPoolManager::StopPageCleaner() {
+  for (auto instance : instances_) {
+    instance->StopPageCleaner();
+  }
+}
+
+//DEBUG
+bool ParallelBufferPoolManager::CheckAllUnpined() {
+  bool res = true;
+  for (auto instance : instances_) {
+    res = instance->CheckAllUnpined() && res;
+  }
+  return res;
+}
+
+} // namespace cmudb
@@ -0,0 +1,77 @@
+/*
+ * parallel_buffer_pool_manager.h
+ *
+ * Functionality: Same interface as BufferPoolManager, but the frames are split
+ * into several independent BufferPoolManager instances. Each instance owns its
+ * own frame array, page table, replacer, free list and latch, and a page
+ * always lives in instance (page_id % num_instances). Threads working on
+ * different pages therefore rarely contend on the same latch.
+ */
+
+#pragma once
+#include <deque>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace cmudb {
+class ParallelBufferPoolManager : public BufferPoolManager {
+public:
+  // pool_size is the number of frames of every instance
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                            DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU);
+
+  ~ParallelBufferPoolManager();
+
+  Page *FetchPage(page_id_t page_id) override;
+  Page *FetchPageOptimistic(page_id_t page_id, uint64_t &version) override;
+  // pages are never swizzled
+  void SetSwizzling(size_t max_pins) override;
+  bool Swizzle(Page *parent, uint64_t version, page_id_t *slot,
+               Page *child) override;
+  void Unswizzle(Page *page) override;
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+  bool UnpinFrame(Page *page, bool is_dirty) override;
+
+  bool FlushPage(page_id_t page_id) override;
+
+  Page *NewPage(page_id_t &page_id) override;
+
+  bool DeletePage(page_id_t page_id) override;
+
+  bool CheckAllUnpined() override;
+
+  // pages of all instances are sorted and coalesced together
+  FlushStats FlushDirtyPages(size_t batch) override;
+
+  // requests are split among the owning instances
+  void Prefetch(page_id_t page_id, size_t count) override;
+  void Prefetch(const std::vector<page_id_t> &page_ids) override;
+  void WaitForPrefetch() override;
+
+  // sum of the counters of all instances
+  BufferPoolStats GetStats() override;
+
+  // every instance runs its own page cleaner
+  void RunPageCleaner(double high_watermark = 0.5,
+                      double low_watermark = 0.25) override;
+  void StopPageCleaner() override;
+
+private:
+  BufferPoolManager *GetInstance(page_id_t page_id);
+  page_id_t TakePageId(size_t instance);
+
+  size_t num_instances_;
+  DiskManager *disk_manager_;
+  std::vector<BufferPoolManager *> instances_;
+  // scan detection state of the whole pool, taken when read-ahead is on only
+  std::mutex scan_latch_;
+  // page ids allocated but not used yet, by owning instance, see NewPage
+  std::mutex alloc_latch_;
+  std::vector<std::deque<page_id_t>> spare_ids_;
+  size_t next_instance_ = 0;
+};
+} // namespace cmudb
@@ -0,0 +1,26 @@
+/**
+ * replacer.h
+ *
+ * Abstract class for replacer, your LRU should implement those methods
+ */
+#pragma once
+
+#include <cstdlib>
+
+namespace cmudb {
+
+template <typename T> class Replacer {
+public:
+  Replacer() {}
+  virtual ~Replacer() {}
+  virtual void Insert(const T &value) = 0;
+  virtual bool Victim(T &value) = 0;
+  // value is gone (e.g. its page was deleted): forget everything about it
+  virtual bool Erase(const T &value) = 0;
+  // value is in use and not evictable until inserted again. Policies keeping
+  // an access history (LRU-K, ARC) keep it, the others just erase value.
+  virtual bool Pin(const T &value) { return Erase(value); }
+  virtual size_t Size() = 0;
+};
+
+} // namespace cmudb
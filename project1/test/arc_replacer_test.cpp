@@ -0,0 +1,212 @@
+/**
+ * arc_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ARCReplacerTest, SampleTest) {
+  ARCReplacer<int> arc_replacer(4);
+
+  // 1 and 2 are accessed twice and move to T2
+  arc_replacer.Insert(1);
+  arc_replacer.Insert(2);
+  arc_replacer.Insert(3);
+  arc_replacer.Insert(4);
+  arc_replacer.Insert(1);
+  arc_replacer.Insert(2);
+  EXPECT_EQ(4, arc_replacer.Size());
+  ARCStats stats = arc_replacer.GetStats();
+  EXPECT_EQ(2, stats.hits);
+  EXPECT_EQ(4, stats.misses);
+  EXPECT_EQ(2, stats.t1_size);
+  EXPECT_EQ(2, stats.t2_size);
+
+  // p = 0, T1 goes first
+  int value;
+  arc_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  // pinned pages stay resident but are skipped
+  EXPECT_EQ(true, arc_replacer.Pin(4));
+  EXPECT_EQ(false, arc_replacer.Pin(4));
+  arc_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+
+  // 3 comes back from B1: T1 was too small
+  arc_replacer.Insert(3);
+  stats = arc_replacer.GetStats();
+  EXPECT_EQ(1, stats.b1_ghost_hits);
+  EXPECT_EQ(1, stats.target_t1);
+  EXPECT_EQ(1, stats.t1_size);
+  EXPECT_EQ(2, stats.t2_size);
+
+  // 1 comes back from B2: shrink T1 again
+  arc_replacer.Insert(4);
+  arc_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  arc_replacer.Insert(1);
+  stats = arc_replacer.GetStats();
+  EXPECT_EQ(1, stats.b2_ghost_hits);
+  EXPECT_EQ(0, stats.target_t1);
+  EXPECT_EQ(3, arc_replacer.Size());
+
+  // erased pages are dropped without becoming ghosts
+  EXPECT_EQ(true, arc_replacer.Erase(1));
+  EXPECT_EQ(false, arc_replacer.Erase(1));
+  EXPECT_EQ(2, arc_replacer.Size());
+  arc_replacer.Insert(1);
+  stats = arc_replacer.GetStats();
+  EXPECT_EQ(1, stats.b2_ghost_hits);
+  EXPECT_EQ(1, stats.t1_size);
+}
+
+TEST(ARCReplacerTest, BufferPoolTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager, nullptr, ReplacerType::ARC);
+
+  for (int i = 0; i < 30; ++i) {
+    page_id_t page_id;
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  // 25-29 move to T2, 0-4 then evict 20-24 from T1 as B1 ghosts, which are
+  // hit when 20-24 come back
+  for (int start : {25, 0, 20}) {
+    for (int i = start; i < start + 5; ++i) {
+      ASSERT_NE(nullptr, bpm.FetchPage(i));
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+  }
+  BufferPoolStats stats = bpm.GetStats();
+  EXPECT_EQ(5, stats.hits);
+  EXPECT_EQ(10, stats.misses);
+  EXPECT_EQ(5, stats.b1_ghost_hits);
+  EXPECT_EQ(5, stats.target_t1);
+
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 30; i += round + 1) {
+      char expect[PAGE_SIZE];
+      snprintf(expect, PAGE_SIZE, "page %d", i);
+      Page *page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, strcmp(page->GetData(), expect));
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+  }
+  stats = bpm.GetStats();
+  EXPECT_EQ(15 + 30 + 15 + 10, stats.hits + stats.misses);
+
+  // a deleted page leaves the replacer, its frame is free again
+  Page *page = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+  EXPECT_EQ(true, bpm.DeletePage(0));
+  for (int i = 1; i < 11; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+  }
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm.NewPage(page_id));
+  for (int i = 1; i < 11; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(true, bpm.CheckAllUnpined());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+/*
+ * A buffer pool of num_frames frames driving its replacer the way
+ * BufferPoolManager does: Pin when a page is pinned, Insert when it is
+ * unpinned, Victim on a miss once the pool is full. Page ids are used as the
+ * replacer values, so that ARC keys its ghosts by page.
+ */
+struct PoolSimulator {
+  PoolSimulator(Replacer<int> *replacer, size_t num_frames)
+      : replacer_(replacer), num_frames_(num_frames) {}
+  // return the number of hits
+  size_t Run(const std::vector<int> &accesses) {
+    size_t hits = 0;
+    for (int page : accesses) {
+      if (resident_.count(page)) {
+        replacer_->Pin(page);
+        hits++;
+      } else {
+        if (resident_.size() == num_frames_) {
+          int victim;
+          EXPECT_EQ(true, replacer_->Victim(victim));
+          resident_.erase(victim);
+        }
+        resident_.insert(page);
+      }
+      replacer_->Insert(page);
+    }
+    return hits;
+  }
+  Replacer<int> *replacer_;
+  size_t num_frames_;
+  std::unordered_set<int> resident_;
+};
+
+/*
+ * Alternate phases of skewed point lookups with phases mixing a hot set and
+ * repeated scans of a range a bit larger than the pool. ARC adapts its target
+ * size of T1 to both and has the higher hit rate over all the phases.
+ */
+TEST(ARCReplacerTest, AdaptiveTest) {
+  const int num_frames = 128;
+  const size_t phase_length = 20000;
+
+  std::mt19937 engine(0);
+  std::uniform_int_distribution<int> hot(0, 63);
+  std::uniform_int_distribution<int> cold(64, 1087);
+  std::uniform_int_distribution<int> coin(0, 9);
+  std::vector<std::vector<int>> phases;
+  for (int phase = 0; phase < 6; ++phase) {
+    std::vector<int> accesses;
+    while (accesses.size() < phase_length) {
+      if (phase % 2 == 0) {
+        // lookups, 80% of them on 64 pages, the rest on 1024 pages
+        accesses.push_back(coin(engine) < 8 ? hot(engine) : cold(engine));
+        continue;
+      }
+      // hot set, then a scan of 160 pages, over and over
+      for (int i = 0; i < 200; ++i) {
+        accesses.push_back(hot(engine));
+      }
+      for (int page = 2000; page < 2160; ++page) {
+        accesses.push_back(page);
+      }
+    }
+    phases.push_back(accesses);
+  }
+
+  LRUReplacer<int> lru_replacer;
+  ARCReplacer<int> arc_replacer(num_frames);
+  PoolSimulator lru(&lru_replacer, num_frames);
+  PoolSimulator arc(&arc_replacer, num_frames);
+  double lru_total = 0, arc_total = 0;
+  for (size_t phase = 0; phase < phases.size(); ++phase) {
+    double lru_hit_rate = 1.0 * lru.Run(phases[phase]) / phases[phase].size();
+    double arc_hit_rate = 1.0 * arc.Run(phases[phase]) / phases[phase].size();
+    lru_total += lru_hit_rate;
+    arc_total += arc_hit_rate;
+  }
+  EXPECT_LT(lru_total, arc_total);
+  ARCStats stats = arc_replacer.GetStats();
+  EXPECT_LT(0, stats.b1_ghost_hits);
+  EXPECT_LT(0, stats.b2_ghost_hits);
+}
+
+} // namespace cmudb
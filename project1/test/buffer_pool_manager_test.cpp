@@ -2,7 +2,13 @@
  * buffer_pool_manager_test.cpp
  */
 
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
@@ -98,5 +104,408 @@ TEST(BufferPoolManagerTest, SampleTest2) {
   remove("test.db");
 }
 
+// pages are evicted (and written back) while other threads fetch them again
+TEST(BufferPoolManagerTest, ConcurrentMissTest) {
+  const int num_pages = 50;
+  const int num_threads = 8;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager);
+
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.push_back(std::thread([&bpm, tid] {
+      std::mt19937 engine(tid);
+      std::uniform_int_distribution<int> distribution(0, num_pages - 1);
+      for (int i = 0; i < 500; ++i) {
+        page_id_t page_id = distribution(engine);
+        Page *page = bpm.FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(page_id, page->GetPageId());
+        char expect[PAGE_SIZE];
+        snprintf(expect, PAGE_SIZE, "page %d", page_id);
+        EXPECT_EQ(0, strcmp(page->GetData(), expect));
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, i % 2 == 0));
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(true, bpm.CheckAllUnpined());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+// dirty unpinned pages are written back by the page cleaner, not by eviction
+TEST(BufferPoolManagerTest, PageCleanerTest) {
+  const int pool_size = 10;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  // the destructor of bpm stops the page cleaner, before the disk manager goes
+  {
+    BufferPoolManager bpm(pool_size, disk_manager);
+    bpm.RunPageCleaner(0.5, 0.2);
+
+    for (int i = 0; i < pool_size; ++i) {
+      page_id_t page_id;
+      Page *page = bpm.NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    }
+    // pinned pages are never cleaned
+    for (int i = 0; i < pool_size; ++i) {
+      EXPECT_EQ(true, bpm.UnpinPage(i, true));
+    }
+
+    // wait until the cleaner brings the dirty frames down to the low watermark
+    char data[PAGE_SIZE];
+    int written = 0;
+    for (int round = 0; round < 50 && written < pool_size * 0.8; ++round) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      written = 0;
+      for (int i = 0; i < pool_size; ++i) {
+        char expect[PAGE_SIZE];
+        snprintf(expect, PAGE_SIZE, "page %d", i);
+        disk_manager->ReadPage(i, data);
+        written += strcmp(data, expect) == 0;
+      }
+    }
+    EXPECT_LE(pool_size * 0.8, written);
+
+    // pages are still served from the buffer pool
+    for (int i = 0; i < pool_size; ++i) {
+      char expect[PAGE_SIZE];
+      snprintf(expect, PAGE_SIZE, "page %d", i);
+      Page *page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, strcmp(page->GetData(), expect));
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+  }
+  delete disk_manager;
+  remove("test.db");
+}
+
+// dirty pages are written in page id order, consecutive ones in one write
+TEST(BufferPoolManagerTest, FlushDirtyPagesTest) {
+  const int pool_size = 10;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(pool_size, disk_manager);
+
+  for (int i = 0; i < pool_size; ++i) {
+    page_id_t page_id;
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+  }
+  // pages 3 and 7 stay pinned and clean, page 8 stays pinned and dirty
+  for (int i = 0; i < pool_size; ++i) {
+    if (i != 3 && i != 7 && i != 8) {
+      EXPECT_EQ(true, bpm.UnpinPage(i, true));
+    }
+  }
+  EXPECT_EQ(true, bpm.UnpinPage(8, true));
+  EXPECT_EQ(8, bpm.FetchPage(8)->GetPageId());
+
+  // 0 1 2
+  FlushStats stats = bpm.FlushDirtyPages(3);
+  EXPECT_EQ(3, stats.pages_written);
+  EXPECT_EQ(1, stats.write_calls);
+  EXPECT_EQ(0, stats.pages_copied);
+  // 4 5 6, 8 9
+  stats = bpm.FlushAllPages();
+  EXPECT_EQ(5, stats.pages_written);
+  EXPECT_EQ(2, stats.write_calls);
+  EXPECT_EQ(1, stats.pages_copied);
+  EXPECT_EQ(false, stats.log_flushed);
+  stats = bpm.FlushAllPages();
+  EXPECT_EQ(0, stats.pages_written);
+  EXPECT_EQ(0, stats.write_calls);
+
+  char data[PAGE_SIZE];
+  for (int i = 0; i < pool_size; ++i) {
+    if (i == 3 || i == 7) {
+      continue;
+    }
+    char expect[PAGE_SIZE];
+    snprintf(expect, PAGE_SIZE, "page %d", i);
+    disk_manager->ReadPage(i, data);
+    EXPECT_EQ(0, strcmp(data, expect));
+  }
+
+  // a writer holding pinned page 8 latches its way to unpinned page 9 while
+  // both are being flushed
+  Page *page = bpm.FetchPage(9);
+  EXPECT_EQ(true, bpm.UnpinPage(9, true));
+  page = bpm.FetchPage(8);
+  page->WLatch();
+  EXPECT_EQ(true, bpm.UnpinPage(8, true));
+  std::thread flusher([&] { stats = bpm.FlushAllPages(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  Page *next = bpm.FetchPage(9);
+  next->WLatch();
+  next->WUnlatch();
+  page->WUnlatch();
+  flusher.join();
+  EXPECT_EQ(2, stats.pages_written);
+  EXPECT_EQ(true, bpm.UnpinPage(9, false));
+  EXPECT_EQ(true, bpm.UnpinPage(3, false));
+  EXPECT_EQ(true, bpm.UnpinPage(7, false));
+  EXPECT_EQ(true, bpm.UnpinPage(8, false));
+  EXPECT_EQ(true, bpm.CheckAllUnpined());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+// prefetched pages are served from memory: overwrite them on disk afterwards
+// and the buffered content is what FetchPage returns
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const int pool_size = 10;
+  const int num_pages = 20;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(pool_size, disk_manager);
+
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  bpm.FlushAllPages();
+  // pages 0-9 have been evicted by now
+  bpm.Prefetch(0, 3);
+  bpm.Prefetch({5});
+  // never allocated, ignored
+  bpm.Prefetch(num_pages + 5, 1);
+  bpm.WaitForPrefetch();
+
+  char data[PAGE_SIZE] = "changed";
+  for (int i = 0; i < num_pages; ++i) {
+    disk_manager->WritePage(i, data);
+  }
+  for (int i : {0, 1, 2, 5}) {
+    char expect[PAGE_SIZE];
+    snprintf(expect, PAGE_SIZE, "page %d", i);
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), expect));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  Page *page = bpm.FetchPage(3);
+  EXPECT_EQ(0, strcmp(page->GetData(), "changed"));
+  EXPECT_EQ(true, bpm.UnpinPage(3, false));
+
+  // a scan of 10, 11, 12 reads 13-16 ahead
+  bpm.SetReadAhead(4);
+  for (int i = 0; i < num_pages; ++i) {
+    snprintf(data, PAGE_SIZE, "page %d", i);
+    disk_manager->WritePage(i, data);
+  }
+  for (int i = 10; i <= 12; ++i) {
+    EXPECT_NE(nullptr, bpm.FetchPage(i));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  bpm.WaitForPrefetch();
+  strcpy(data, "changed");
+  for (int i = 0; i < num_pages; ++i) {
+    disk_manager->WritePage(i, data);
+  }
+  for (int i = 13; i <= 16; ++i) {
+    char expect[PAGE_SIZE];
+    snprintf(expect, PAGE_SIZE, "page %d", i);
+    page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), expect));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(true, bpm.CheckAllUnpined());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(3, disk_manager);
+
+  page_id_t page_id;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(page_id));
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(page_id));
+  EXPECT_EQ(nullptr, bpm.FetchPage(5));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, i == 0));
+  }
+  // hit
+  EXPECT_NE(nullptr, bpm.FetchPage(2));
+  EXPECT_EQ(true, bpm.UnpinPage(2, false));
+  // evicts page 0 (dirty), then page 1, by reading page 0 again
+  EXPECT_NE(nullptr, bpm.NewPage(page_id));
+  EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  EXPECT_NE(nullptr, bpm.FetchPage(0));
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+
+  BufferPoolStats stats = bpm.GetStats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(2, stats.misses);
+  EXPECT_EQ(2, stats.all_pinned);
+  EXPECT_EQ(2, stats.evictions);
+  EXPECT_EQ(1, stats.dirty_write_backs);
+  EXPECT_EQ(0, stats.wal_flushes);
+  size_t latch_acquisitions = 0;
+  for (auto count : stats.latch_wait) {
+    latch_acquisitions += count;
+  }
+  EXPECT_LE(13, latch_acquisitions);
+  EXPECT_NE(std::string::npos, stats.ToString().find("hits: 1\n"));
+
+  std::atomic<int> dumps(0);
+  bpm.RunStatsDumper([&](const BufferPoolStats &stats) {
+    EXPECT_EQ(1, stats.hits);
+    dumps++;
+  }, std::chrono::milliseconds(10));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  bpm.StopStatsDumper();
+  EXPECT_LT(0, dumps);
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, OptimisticReadTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(3, disk_manager);
+
+  page_id_t page_id;
+  Page *page = bpm.NewPage(page_id);
+  ASSERT_NE(nullptr, page);
+  strcpy(page->GetData(), "Hello");
+  EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+
+  uint64_t version;
+  EXPECT_EQ(page, bpm.FetchPageOptimistic(page_id, version));
+  EXPECT_EQ(0, strcmp(page->GetData(), "Hello"));
+  EXPECT_EQ(true, page->Validate(version));
+  // nothing pinned
+  EXPECT_EQ(true, bpm.CheckAllUnpined());
+
+  // a writer in between
+  page->WLatch();
+  uint64_t latched;
+  EXPECT_EQ(nullptr, bpm.FetchPageOptimistic(page_id, latched));
+  page->WUnlatch();
+  EXPECT_EQ(false, page->Validate(version));
+  EXPECT_EQ(page, bpm.FetchPageOptimistic(page_id, version));
+
+  // evicted: the frame now holds another page
+  for (int i = 0; i < 3; ++i) {
+    page_id_t new_page_id;
+    EXPECT_NE(nullptr, bpm.NewPage(new_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(new_page_id, false));
+  }
+  EXPECT_EQ(false, page->Validate(version));
+  EXPECT_EQ(nullptr, bpm.FetchPageOptimistic(page_id, version));
+  EXPECT_EQ(nullptr, bpm.FetchPageOptimistic(100, version));
+
+  // version of a page written by one thread, while others keep reading it
+  page = bpm.FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  memset(page->GetData(), 0, PAGE_SIZE);
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; ++tid) {
+    readers.push_back(std::thread([&] {
+      while (!done) {
+        uint64_t seen;
+        Page *page = bpm.FetchPageOptimistic(page_id, seen);
+        if (page == nullptr) continue;
+        // both halves are written together
+        int first, second;
+        memcpy(&first, page->GetData(), sizeof(int));
+        memcpy(&second, page->GetData() + PAGE_SIZE - sizeof(int),
+               sizeof(int));
+        if (page->Validate(seen)) {
+          EXPECT_EQ(first, second);
+        }
+      }
+    }));
+  }
+  for (int i = 0; i < 10000; ++i) {
+    page->WLatch();
+    memcpy(page->GetData(), &i, sizeof(int));
+    memcpy(page->GetData() + PAGE_SIZE - sizeof(int), &i, sizeof(int));
+    page->WUnlatch();
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PageGuardTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(3, disk_manager);
+
+  page_id_t page_id;
+  {
+    WritePageGuard guard = bpm.NewPageGuarded(page_id);
+    ASSERT_EQ(false, guard.IsEmpty());
+    snprintf(guard.GetData(), PAGE_SIZE, "Hello");
+    EXPECT_EQ(1, guard.GetPage()->GetPinCount());
+  }
+  EXPECT_EQ(true, bpm.CheckAllUnpined());
+
+  // moved, released once
+  ReadPageGuard guard = bpm.FetchPageRead(page_id);
+  ReadPageGuard other = bpm.FetchPageRead(page_id);
+  Page *page = guard.GetPage();
+  EXPECT_EQ(2, page->GetPinCount());
+  EXPECT_EQ(0, strcmp(guard.GetData(), "Hello"));
+  guard = std::move(other);
+  EXPECT_EQ(true, other.IsEmpty());
+  EXPECT_EQ(1, page->GetPinCount());
+  ReadPageGuard moved(std::move(guard));
+  EXPECT_EQ(true, guard.IsEmpty());
+  moved.Release();
+  moved.Release();
+  EXPECT_EQ(0, page->GetPinCount());
+
+  // the write latch is given back with the pin, and the page written back
+  // when evicted if marked dirty
+  {
+    WritePageGuard writer = bpm.FetchPageWrite(page_id);
+    snprintf(writer.GetData(), PAGE_SIZE, "World");
+    writer.MarkDirty();
+  }
+  EXPECT_EQ(true, bpm.CheckAllUnpined());
+  for (int i = 0; i < 3; ++i) {
+    page_id_t new_page_id;
+    EXPECT_EQ(false, bpm.NewPageGuarded(new_page_id).IsEmpty());
+  }
+  EXPECT_EQ(0, strcmp(bpm.FetchPageRead(page_id).GetData(), "World"));
+  EXPECT_EQ(true, bpm.CheckAllUnpined());
+
+  delete disk_manager;
+  remove("test.db");
+}
 
 } // namespace cmudb
@@ -0,0 +1,125 @@
+/**
+ * clock_replacer_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ClockReplacerTest, SampleTest) {
+  ClockReplacer<int> clock_replacer(7, 0);
+
+  clock_replacer.Insert(1);
+  clock_replacer.Insert(2);
+  clock_replacer.Insert(3);
+  clock_replacer.Insert(4);
+  clock_replacer.Insert(5);
+  clock_replacer.Insert(6);
+  clock_replacer.Insert(1);
+  EXPECT_EQ(6, clock_replacer.Size());
+
+  // first sweep clears all the reference bits, then frames go in clock order
+  int value;
+  clock_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  clock_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  // 3 is referenced again and gets a second chance
+  clock_replacer.Insert(3);
+  clock_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  EXPECT_EQ(false, clock_replacer.Erase(4));
+  EXPECT_EQ(true, clock_replacer.Erase(6));
+  EXPECT_EQ(2, clock_replacer.Size());
+
+  clock_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  clock_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(false, clock_replacer.Victim(value));
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+TEST(ClockReplacerTest, BufferPoolTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager, nullptr, ReplacerType::CLOCK);
+
+  for (int i = 0; i < 30; ++i) {
+    page_id_t page_id;
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  for (int i = 0; i < 30; ++i) {
+    char expect[PAGE_SIZE];
+    snprintf(expect, PAGE_SIZE, "page %d", i);
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), expect));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(true, bpm.CheckAllUnpined());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+/*
+ * Pin/unpin traffic (Erase + Insert of random frames) with an eviction every
+ * 64 operations, from 1, 8 and 32 threads. Only reports numbers, run it with
+ * --gtest_also_run_disabled_tests.
+ */
+TEST(ClockReplacerTest, DISABLED_ContentionBenchmark) {
+  const int num_frames = 1024;
+  const int total_ops = 1 << 20;
+
+  for (int clock = 0; clock <= 1; ++clock) {
+    for (int num_threads : {1, 8, 32}) {
+      Replacer<int> *replacer =
+              clock ? static_cast<Replacer<int> *>(
+                              new ClockReplacer<int>(num_frames, 0))
+                    : new LRUReplacer<int>;
+      for (int i = 0; i < num_frames; ++i) {
+        replacer->Insert(i);
+      }
+      std::vector<std::thread> threads;
+      auto start = std::chrono::steady_clock::now();
+      for (int tid = 0; tid < num_threads; ++tid) {
+        threads.push_back(std::thread([&, tid] {
+          std::mt19937 engine(tid);
+          std::uniform_int_distribution<int> distribution(0, num_frames - 1);
+          for (int i = 0; i < total_ops / num_threads; ++i) {
+            int frame = distribution(engine);
+            replacer->Erase(frame);
+            replacer->Insert(frame);
+            if (i % 64 == 0 && replacer->Victim(frame)) {
+              replacer->Insert(frame);
+            }
+          }
+        }));
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> elapsed =
+              std::chrono::steady_clock::now() - start;
+      printf("%-5s threads: %2d  %10.0f ops/s\n", clock ? "clock" : "lru",
+             num_threads, total_ops / elapsed.count());
+      EXPECT_EQ(num_frames, replacer->Size());
+      delete replacer;
+    }
+  }
+}
+
+} // namespace cmudb
@@ -2,6 +2,10 @@
  * extendible_hash_test.cpp
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <thread>
 #include <random>
 
@@ -281,7 +285,8 @@ TEST(ExtendibleHashTest, ConcurrentRemoveTest) {
     for (int i = 0; i < num_threads; i++) {
       threads[i].join();
     }
-    EXPECT_EQ(test->GetGlobalDepth(), 6);
+    // removals may merge buckets and halve the directory
+    EXPECT_LE(test->GetGlobalDepth(), 6);
     int val;
     EXPECT_EQ(0, test->Find(0, val));
     EXPECT_EQ(1, test->Find(8, val));
@@ -291,4 +296,160 @@ TEST(ExtendibleHashTest, ConcurrentRemoveTest) {
   }
 }
 
-} // namespace cmudb
\ No newline at end of file
+TEST(ExtendibleHashTest, ShrinkTest) {
+  ExtendibleHash<int, int> *test = new ExtendibleHash<int, int>(4);
+  for (int i = 0; i < 1000; i++) {
+    test->Insert(i, i);
+  }
+  EXPECT_LE(8, test->GetGlobalDepth());
+  // keep 16 keys, buckets merge while their split images run empty
+  for (int i = 16; i < 1000; i++) {
+    EXPECT_EQ(1, test->Remove(i));
+  }
+  EXPECT_GE(4, test->GetGlobalDepth());
+  for (int i = 0; i < 1000; i++) {
+    int value;
+    EXPECT_EQ(i < 16, test->Find(i, value));
+  }
+  for (int i = 0; i < 16; i++) {
+    EXPECT_EQ(1, test->Remove(i));
+  }
+  EXPECT_EQ(0, test->GetGlobalDepth());
+  EXPECT_EQ(1, test->GetNumBuckets());
+
+  // grows again
+  for (int i = 0; i < 1000; i++) {
+    test->Insert(i, i + 1);
+  }
+  for (int i = 0; i < 1000; i++) {
+    int value;
+    EXPECT_EQ(true, test->Find(i, value));
+    EXPECT_EQ(i + 1, value);
+  }
+  delete test;
+}
+
+// splits and merges under way never hide a key that stays
+TEST(ExtendibleHashTest, ConcurrentShrinkTest) {
+  std::shared_ptr<ExtendibleHash<int, int>> test{new ExtendibleHash<int, int>(4)};
+  const int num_keys = 2000;
+  // even keys stay, odd ones come and go
+  for (int i = 0; i < num_keys; i += 2) {
+    test->Insert(i, i);
+  }
+  std::atomic<bool> done(false);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 3; tid++) {
+    threads.push_back(std::thread([tid, &test, &done]() {
+      std::mt19937 engine(tid);
+      std::uniform_int_distribution<int> distribution(0, num_keys / 2 - 1);
+      while (!done) {
+        int key = distribution(engine) * 2;
+        int value;
+        EXPECT_TRUE(test->Find(key, value));
+        EXPECT_EQ(key, value);
+      }
+    }));
+  }
+  for (int tid = 0; tid < 2; tid++) {
+    threads.push_back(std::thread([tid, &test]() {
+      for (int run = 0; run < 20; run++) {
+        for (int i = 2 * tid + 1; i < num_keys; i += 4) {
+          test->Insert(i, i);
+        }
+        for (int i = 2 * tid + 1; i < num_keys; i += 4) {
+          EXPECT_EQ(1, test->Remove(i));
+        }
+      }
+    }));
+  }
+  for (size_t i = 3; i < threads.size(); i++) {
+    threads[i].join();
+  }
+  done = true;
+  for (int i = 0; i < 3; i++) {
+    threads[i].join();
+  }
+  for (int i = 0; i < num_keys; i++) {
+    int value;
+    EXPECT_EQ(i % 2 == 0, test->Find(i, value));
+  }
+}
+
+/*
+ * Single threaded Insert and Find throughput over 65536 random keys, for the
+ * bucket sizes the buffer pool and the tests use. Only reports numbers, run
+ * it with --gtest_also_run_disabled_tests.
+ */
+TEST(ExtendibleHashTest, DISABLED_ThroughputBenchmark) {
+  const int num_keys = 1 << 16;
+  for (size_t bucket_size : {10, 64}) {
+    ExtendibleHash<int, int> *test = new ExtendibleHash<int, int>(bucket_size);
+    std::vector<int> keys(num_keys);
+    std::mt19937 engine(0);
+    for (auto &key : keys) {
+      key = static_cast<int>(engine());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int key : keys) {
+      test->Insert(key, key);
+    }
+    std::chrono::duration<double> insert_time =
+            std::chrono::steady_clock::now() - start;
+
+    std::shuffle(keys.begin(), keys.end(), engine);
+    int found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int key : keys) {
+      int value;
+      found += test->Find(key, value);
+    }
+    std::chrono::duration<double> find_time =
+            std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(num_keys, found);
+
+    printf("bucket size %2zu  insert %10.0f ops/s  find %10.0f ops/s\n",
+           bucket_size, num_keys / insert_time.count(),
+           num_keys / find_time.count());
+    delete test;
+  }
+}
+
+/*
+ * Find throughput from 1 to 64 threads over a table of 65536 keys, every
+ * thread looking up random keys. Only reports numbers, run it with
+ * --gtest_also_run_disabled_tests.
+ */
+TEST(ExtendibleHashTest, DISABLED_FindScalabilityBenchmark) {
+  const int num_keys = 1 << 16;
+  const int total_ops = 1 << 22;
+  ExtendibleHash<int, int> *test = new ExtendibleHash<int, int>(64);
+  for (int i = 0; i < num_keys; i++) {
+    test->Insert(i, i);
+  }
+  for (int num_threads : {1, 4, 16, 64}) {
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.push_back(std::thread([tid, num_threads, test]() {
+        std::mt19937 engine(tid);
+        std::uniform_int_distribution<int> distribution(0, num_keys - 1);
+        for (int i = 0; i < total_ops / num_threads; i++) {
+          int value;
+          test->Find(distribution(engine), value);
+        }
+      }));
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+    printf("find threads: %2d  %10.0f ops/s\n", num_threads,
+           total_ops / elapsed.count());
+  }
+  delete test;
+}
+
+} // namespace cmudb
@@ -0,0 +1,121 @@
+/**
+ * frame_arena_test.cpp
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/frame_arena.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(FrameArenaTest, SampleTest) {
+  for (size_t num_partitions : {1, 4}) {
+    FrameArena arena(1000, num_partitions);
+    EXPECT_LE(1000 * PAGE_SIZE, arena.GetMappedSize());
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(arena.GetFrame(0)) % 4096);
+    for (size_t i = 0; i < 1000; ++i) {
+      EXPECT_EQ(arena.GetFrame(0) + i * PAGE_SIZE, arena.GetFrame(i));
+      // frames start zeroed and are writable
+      EXPECT_EQ(0, arena.GetFrame(i)[PAGE_SIZE - 1]);
+      memset(arena.GetFrame(i), i % 128, PAGE_SIZE);
+    }
+    for (size_t i = 0; i < 1000; ++i) {
+      EXPECT_EQ(static_cast<char>(i % 128), arena.GetFrame(i)[0]);
+      EXPECT_EQ(static_cast<char>(i % 128), arena.GetFrame(i)[PAGE_SIZE - 1]);
+    }
+  }
+}
+
+TEST(FrameArenaTest, BufferPoolTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager, nullptr, ReplacerType::LRU, 2);
+
+  page_id_t page_id;
+  std::vector<Page *> pages;
+  for (int i = 0; i < 10; ++i) {
+    pages.push_back(bpm.NewPage(page_id));
+    ASSERT_NE(nullptr, pages.back());
+    snprintf(pages.back()->GetData(), PAGE_SIZE, "page %d", i);
+  }
+  // all the frames lie in one region, PAGE_SIZE apart
+  char *low = pages[0]->GetData();
+  for (auto page : pages) {
+    low = std::min(low, page->GetData());
+  }
+  for (auto page : pages) {
+    EXPECT_EQ(0, (page->GetData() - low) % PAGE_SIZE);
+    EXPECT_GT(10 * PAGE_SIZE, page->GetData() - low);
+  }
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+  for (int i = 10; i < 20; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  }
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+/*
+ * Random 8 byte reads over 1 GiB of frames, one access per frame touched, so
+ * the time is dominated by TLB misses: frames allocated one by one (as
+ * before the arena) against the arena. Set FRAME_ARENA_BENCH_GB to run it on
+ * a larger pool, e.g. 16. Only reports numbers and the arena backing, run it
+ * with --gtest_also_run_disabled_tests.
+ */
+TEST(FrameArenaTest, DISABLED_TLBBenchmark) {
+  const char *env = getenv("FRAME_ARENA_BENCH_GB");
+  const size_t gigabytes = env == nullptr ? 1 : strtoul(env, nullptr, 10);
+  const size_t num_frames = (gigabytes << 30) / PAGE_SIZE;
+  const size_t total_reads = 1 << 24;
+  const char *names[] = {"hugetlb", "transparent hugepage", "regular"};
+
+  std::vector<char *> scattered(num_frames);
+  for (auto &frame : scattered) {
+    frame = new char[PAGE_SIZE]();
+  }
+  FrameArena arena(num_frames);
+  for (size_t i = 0; i < num_frames; ++i) {
+    // fault everything in before measuring
+    arena.GetFrame(i)[0] = 1;
+  }
+
+  for (int use_arena = 0; use_arena <= 1; ++use_arena) {
+    std::mt19937_64 engine(0);
+    std::uniform_int_distribution<size_t> distribution(0, num_frames - 1);
+    uint64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < total_reads; ++i) {
+      size_t frame_id = distribution(engine);
+      char *frame = use_arena ? arena.GetFrame(frame_id) : scattered[frame_id];
+      sum += *reinterpret_cast<uint64_t *>(frame + (i * 64) % PAGE_SIZE);
+    }
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+    printf("%-9s %zu GiB  %6.1f ns/read  (%llu)\n",
+           use_arena ? "arena" : "scattered", gigabytes,
+           elapsed.count() * 1e9 / total_reads, (unsigned long long)sum);
+  }
+  printf("arena backing: %s\n", names[static_cast<int>(arena.GetBacking())]);
+
+  for (auto frame : scattered) {
+    delete[] frame;
+  }
+}
+
+} // namespace cmudb
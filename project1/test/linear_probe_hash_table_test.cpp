@@ -0,0 +1,243 @@
+/**
+ * linear_probe_hash_table_test.cpp
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common/config.h"
+#include "hash/extendible_hash.h"
+#include "hash/linear_probe_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(LinearProbeHashTableTest, SampleTest) {
+  LinearProbeHashTable<int, int> table(4, -1);
+  EXPECT_EQ(4, table.GetCapacity());
+
+  for (int i = 0; i < 4; ++i) {
+    table.Insert(i, i * 10);
+  }
+  int value;
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(true, table.Find(i, value));
+    EXPECT_EQ(i * 10, value);
+  }
+  EXPECT_EQ(false, table.Find(4, value));
+  // update in place
+  table.Insert(2, 200);
+  EXPECT_EQ(true, table.Find(2, value));
+  EXPECT_EQ(200, value);
+  EXPECT_EQ(4, table.GetSize());
+
+  // grows past its capacity
+  for (int i = 4; i < 100; ++i) {
+    table.Insert(i, i * 10);
+  }
+  EXPECT_EQ(100, table.GetSize());
+  EXPECT_LE(100, table.GetCapacity());
+
+  EXPECT_EQ(true, table.Remove(2));
+  EXPECT_EQ(false, table.Remove(2));
+  EXPECT_EQ(false, table.Find(2, value));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i != 2, table.Find(i, value));
+    if (i != 2) {
+      EXPECT_EQ(i * 10, value);
+    }
+  }
+}
+
+// removals shift entries back, no key may get lost behind a hole
+TEST(LinearProbeHashTableTest, RandomInsertAndDeleteTest) {
+  LinearProbeHashTable<int, int> table(64, -1);
+  std::vector<bool> present(2000);
+  std::mt19937 engine(0);
+  std::uniform_int_distribution<int> distribution(0, 1999);
+  for (int i = 0; i < 100000; ++i) {
+    int key = distribution(engine);
+    if (present[key]) {
+      EXPECT_EQ(true, table.Remove(key));
+    } else {
+      table.Insert(key, key + 1);
+    }
+    present[key] = !present[key];
+  }
+  size_t size = 0;
+  for (int key = 0; key < 2000; ++key) {
+    int value;
+    EXPECT_EQ(present[key], table.Find(key, value));
+    if (present[key]) {
+      EXPECT_EQ(key + 1, value);
+      size++;
+    }
+  }
+  EXPECT_EQ(size, table.GetSize());
+}
+
+// a table grown moves its entries over the next writes: removals, updates
+// and inserts in the meantime are all seen, before and after the move is over
+TEST(LinearProbeHashTableTest, IncrementalGrowTest) {
+  LinearProbeHashTable<int, int> table(64, -1);
+  std::map<int, int> expected;
+  std::mt19937 engine(1);
+  std::uniform_int_distribution<int> distribution(0, 511);
+  for (int i = 0; i < 2000; ++i) {
+    int key = distribution(engine);
+    if (i % 3 == 0 && expected.count(key) != 0) {
+      EXPECT_EQ(true, table.Remove(key));
+      expected.erase(key);
+    } else {
+      table.Insert(key, i);
+      expected[key] = i;
+    }
+    EXPECT_EQ(expected.size(), table.GetSize());
+    for (int k = 0; k < 512; ++k) {
+      int value;
+      bool found = table.Find(k, value);
+      EXPECT_EQ(expected.count(k) != 0, found);
+      if (found) {
+        EXPECT_EQ(expected[k], value);
+      }
+    }
+  }
+}
+
+// readers never see a key with the wrong value, nor miss a key that stays
+TEST(LinearProbeHashTableTest, ConcurrentReadWriteTest) {
+  const int num_keys = 1000;
+  LinearProbeHashTable<int, int> table(num_keys, -1);
+  // even keys stay, odd ones come and go
+  for (int key = 0; key < num_keys; key += 2) {
+    table.Insert(key, key * 3);
+  }
+  std::atomic<bool> done(false);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 4; ++tid) {
+    threads.push_back(std::thread([&, tid] {
+      std::mt19937 engine(tid);
+      std::uniform_int_distribution<int> distribution(0, num_keys - 1);
+      while (!done) {
+        int key = distribution(engine);
+        int value;
+        bool found = table.Find(key, value);
+        if (key % 2 == 0) {
+          EXPECT_EQ(true, found);
+        }
+        if (found) {
+          EXPECT_EQ(key * 3, value);
+        }
+      }
+    }));
+  }
+  std::mt19937 engine(100);
+  std::uniform_int_distribution<int> distribution(0, num_keys / 2 - 1);
+  for (int i = 0; i < 200000; ++i) {
+    int key = distribution(engine) * 2 + 1;
+    if (!table.Remove(key)) {
+      table.Insert(key, key * 3);
+    }
+  }
+  done = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+// the table grows many times under readers, which keep finding the keys
+// inserted before they started
+TEST(LinearProbeHashTableTest, ConcurrentGrowTest) {
+  const int num_keys = 1 << 16;
+  LinearProbeHashTable<int, int> table(4, -1);
+  for (int key = 0; key < 64; ++key) {
+    table.Insert(key, key * 3);
+  }
+  std::atomic<bool> done(false);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 4; ++tid) {
+    threads.push_back(std::thread([&, tid] {
+      std::mt19937 engine(tid);
+      std::uniform_int_distribution<int> distribution(0, 63);
+      while (!done) {
+        int key = distribution(engine);
+        int value;
+        EXPECT_EQ(true, table.Find(key, value));
+        EXPECT_EQ(key * 3, value);
+      }
+    }));
+  }
+  for (int key = 64; key < num_keys; ++key) {
+    table.Insert(key, key * 3);
+  }
+  done = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_keys, table.GetSize());
+  EXPECT_LE(num_keys, table.GetCapacity());
+}
+
+/*
+ * Page table traffic: 4096 buffered pages, random lookups and every 16th
+ * operation an eviction (a page removed and another one inserted), from 1 to
+ * 64 threads, against ExtendibleHash. Only reports numbers, run it with
+ * --gtest_also_run_disabled_tests. The lookups only win when they run in
+ * parallel, on a single core ExtendibleHash is ahead by 10-15%.
+ */
+TEST(LinearProbeHashTableTest, DISABLED_ContentionBenchmark) {
+  const int num_pages = 4096;
+  const int total_ops = 1 << 20;
+
+  for (int linear = 0; linear <= 1; ++linear) {
+    for (int num_threads : {1, 4, 16, 64}) {
+      HashTable<int, int> *table =
+              linear ? static_cast<HashTable<int, int> *>(
+                               new LinearProbeHashTable<int, int>(num_pages,
+                                                                  -1))
+                     : new ExtendibleHash<int, int>(BUCKET_SIZE);
+      for (int i = 0; i < num_pages; ++i) {
+        table->Insert(i, i);
+      }
+      std::vector<std::thread> threads;
+      auto start = std::chrono::steady_clock::now();
+      for (int tid = 0; tid < num_threads; ++tid) {
+        threads.push_back(std::thread([&, tid] {
+          std::mt19937 engine(tid);
+          std::uniform_int_distribution<int> distribution(0, num_pages - 1);
+          for (int i = 0; i < total_ops / num_threads; ++i) {
+            int key = distribution(engine);
+            int value;
+            if (i % 16 == 0) {
+              // stays at num_pages entries, keys of other threads differ
+              int moved = key + num_pages * (tid + 1);
+              if (table->Remove(key)) {
+                table->Insert(moved, key);
+                table->Remove(moved);
+                table->Insert(key, key);
+              }
+            } else {
+              table->Find(key, value);
+            }
+          }
+        }));
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> elapsed =
+              std::chrono::steady_clock::now() - start;
+      printf("%-10s threads: %2d  %10.0f ops/s\n",
+             linear ? "linear" : "extendible", num_threads,
+             total_ops / elapsed.count());
+      delete table;
+    }
+  }
+}
+
+} // namespace cmudb
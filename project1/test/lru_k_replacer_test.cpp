@@ -0,0 +1,173 @@
+/**
+ * lru_k_replacer_test.cpp
+ */
+
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer<int> lru_k_replacer(2);
+
+  // 1 and 2 are accessed twice, the others once
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Insert(4);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(5);
+  lru_k_replacer.Insert(2);
+  EXPECT_EQ(5, lru_k_replacer.Size());
+
+  // infinite backward 2-distance first, oldest access first
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  // pinned, but its history is kept
+  EXPECT_EQ(true, lru_k_replacer.Pin(5));
+  EXPECT_EQ(false, lru_k_replacer.Pin(5));
+  EXPECT_EQ(false, lru_k_replacer.Pin(3));
+  EXPECT_EQ(2, lru_k_replacer.Size());
+  lru_k_replacer.Insert(5);
+
+  // 1 has the oldest second to last access
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(false, lru_k_replacer.Victim(value));
+  EXPECT_EQ(0, lru_k_replacer.Size());
+
+  // victims are forgotten, 3 starts over with a single access
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Insert(6);
+  lru_k_replacer.Insert(6);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+
+  // erased values are forgotten as well, pinned or not
+  lru_k_replacer.Insert(8);
+  lru_k_replacer.Insert(8);
+  lru_k_replacer.Insert(7);
+  lru_k_replacer.Insert(7);
+  EXPECT_EQ(true, lru_k_replacer.Pin(7));
+  EXPECT_EQ(false, lru_k_replacer.Erase(7));
+  EXPECT_EQ(true, lru_k_replacer.Erase(6));
+  EXPECT_EQ(false, lru_k_replacer.Erase(6));
+  EXPECT_EQ(1, lru_k_replacer.Size());
+  // 7 starts over with a single access, 8 has two
+  lru_k_replacer.Insert(7);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(7, value);
+}
+
+TEST(LRUKReplacerTest, BufferPoolTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(3, disk_manager, nullptr, ReplacerType::LRU_K);
+
+  page_id_t page_id;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(page_id));
+    bpm.UnpinPage(page_id, false);
+  }
+  // 0 and 1 are used twice
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+    bpm.UnpinPage(i, false);
+  }
+  // evicts 2, then 3 itself as the single use page
+  ASSERT_NE(nullptr, bpm.NewPage(page_id));
+  EXPECT_EQ(3, page_id);
+  bpm.UnpinPage(page_id, true);
+  ASSERT_NE(nullptr, bpm.NewPage(page_id));
+  bpm.UnpinPage(page_id, false);
+  Page *page = bpm.FetchPage(3);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(3, page->GetPageId());
+  bpm.UnpinPage(3, false);
+  EXPECT_EQ(true, bpm.CheckAllUnpined());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+/*
+ * Replay page accesses on num_frames frames the way BufferPoolManager drives
+ * its replacer: Pin when a page is pinned, Insert when it is unpinned, and
+ * Victim on a miss once the free frames are used up.
+ * return the number of hits among the accesses counted
+ */
+static size_t Replay(Replacer<int> *replacer, int num_frames,
+                     const std::vector<std::pair<int, bool>> &accesses) {
+  std::vector<int> frame_page(num_frames, -1);
+  std::unordered_map<int, int> page_frame;
+  int free_frames = num_frames;
+  size_t hits = 0;
+  for (auto &access : accesses) {
+    int page = access.first;
+    int frame;
+    auto it = page_frame.find(page);
+    if (it != page_frame.end()) {
+      frame = it->second;
+      replacer->Pin(frame);
+      hits += access.second;
+    } else {
+      if (free_frames > 0) {
+        frame = --free_frames;
+      } else {
+        EXPECT_EQ(true, replacer->Victim(frame));
+        page_frame.erase(frame_page[frame]);
+      }
+      frame_page[frame] = page;
+      page_frame[page] = frame;
+    }
+    replacer->Insert(frame);
+  }
+  return hits;
+}
+
+/*
+ * Point lookups on a hot set fitting in the pool, interleaved with a full scan
+ * of a table ten times the pool every 1000 lookups. LRU loses the hot set on
+ * every scan, LRU-K keeps it and has the higher hit rate on the lookups.
+ */
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  const int num_frames = 64;
+  const int hot_pages = 48;
+  const int table_pages = 640;
+  const int lookups = 100000;
+
+  std::mt19937 engine(0);
+  std::uniform_int_distribution<int> distribution(0, hot_pages - 1);
+  std::vector<std::pair<int, bool>> accesses;
+  for (int i = 0; i < lookups; ++i) {
+    accesses.push_back({distribution(engine), true});
+    if (i % 1000 == 999) {
+      for (int page = hot_pages; page < hot_pages + table_pages; ++page) {
+        accesses.push_back({page, false});
+      }
+    }
+  }
+
+  LRUReplacer<int> lru_replacer;
+  LRUKReplacer<int> lru_k_replacer(2);
+  double lru_hit_rate =
+          1.0 * Replay(&lru_replacer, num_frames, accesses) / lookups;
+  double lru_k_hit_rate =
+          1.0 * Replay(&lru_k_replacer, num_frames, accesses) / lookups;
+  EXPECT_LT(lru_hit_rate, lru_k_hit_rate);
+}
+
+} // namespace cmudb
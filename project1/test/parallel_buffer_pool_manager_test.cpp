@@ -0,0 +1,199 @@
+/**
+ * parallel_buffer_pool_manager_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  // 5 instances with 2 frames each
+  ParallelBufferPoolManager bpm(5, 2, disk_manager);
+
+  auto page_zero = bpm.NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, temp_page_id);
+  strcpy(page_zero->GetData(), "Hello");
+
+  for (int i = 1; i < 10; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(i, temp_page_id);
+  }
+  // all the pages are pinned, every instance is full
+  for (int i = 10; i < 15; ++i) {
+    EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+  }
+  // unpin page zero only, its instance is the only one with a victim
+  EXPECT_EQ(true, bpm.UnpinPage(0, true));
+  auto page = bpm.NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, temp_page_id % 5);
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+
+  // fetch page zero again, it was written back on eviction
+  page_zero = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+
+  for (int i = 1; i < 10; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  // the ids the full instances could not take go to the next pages, no hole
+  EXPECT_EQ(10, temp_page_id);
+  for (int i = 11; i < 15; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(i, temp_page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+  EXPECT_EQ(true, bpm.CheckAllUnpined());
+  EXPECT_EQ(false, bpm.FlushPage(INVALID_PAGE_ID));
+  EXPECT_EQ(true, bpm.DeletePage(3));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(ParallelBufferPoolManagerTest, ConcurrencyTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 50;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  ParallelBufferPoolManager bpm(4, 10, disk_manager);
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.push_back(std::thread([&bpm, tid] {
+      std::vector<page_id_t> page_ids;
+      for (int i = 0; i < pages_per_thread; ++i) {
+        page_id_t page_id;
+        Page *page = bpm.NewPage(page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), PAGE_SIZE, "%d-%d", tid, page_id);
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+        page_ids.push_back(page_id);
+      }
+      for (auto page_id : page_ids) {
+        Page *page = bpm.FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        char expect[PAGE_SIZE];
+        snprintf(expect, PAGE_SIZE, "%d-%d", tid, page_id);
+        EXPECT_EQ(0, strcmp(page->GetData(), expect));
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(true, bpm.CheckAllUnpined());
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// pages of different instances are still coalesced into one write
+TEST(ParallelBufferPoolManagerTest, FlushAllPagesTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  ParallelBufferPoolManager bpm(4, 4, disk_manager);
+
+  for (int i = 0; i < 16; ++i) {
+    page_id_t page_id;
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  FlushStats stats = bpm.FlushDirtyPages(8);
+  EXPECT_EQ(8, stats.pages_written);
+  EXPECT_EQ(1, stats.write_calls);
+  stats = bpm.FlushAllPages();
+  EXPECT_EQ(8, stats.pages_written);
+  EXPECT_EQ(1, stats.write_calls);
+
+  char data[PAGE_SIZE];
+  for (int i = 0; i < 16; ++i) {
+    char expect[PAGE_SIZE];
+    snprintf(expect, PAGE_SIZE, "page %d", i);
+    disk_manager->ReadPage(i, data);
+    EXPECT_EQ(0, strcmp(data, expect));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * Throughput of fetch + unpin on a resident working set, single latch versus
+ * 16 instances, from 1 to 64 threads. Only reports numbers, the speedup
+ * depends on the number of cores of the machine running the test: run it
+ * with --gtest_also_run_disabled_tests.
+ */
+TEST(ParallelBufferPoolManagerTest, DISABLED_ScalingBenchmark) {
+  const int num_instances = 16;
+  const int pool_size = 1024;
+  const int working_set = 512;
+  const int total_ops = 1 << 16;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  for (int parallel = 0; parallel <= 1; ++parallel) {
+    BufferPoolManager *bpm = parallel
+            ? new ParallelBufferPoolManager(num_instances,
+                                            pool_size / num_instances,
+                                            disk_manager)
+            : new BufferPoolManager(pool_size, disk_manager);
+    std::vector<page_id_t> page_ids;
+    for (int i = 0; i < working_set; ++i) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm->NewPage(page_id));
+      bpm->UnpinPage(page_id, true);
+      page_ids.push_back(page_id);
+    }
+
+    for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+      std::vector<std::thread> threads;
+      auto start = std::chrono::steady_clock::now();
+      for (int tid = 0; tid < num_threads; ++tid) {
+        threads.push_back(std::thread([&, tid] {
+          std::mt19937 engine(tid);
+          std::uniform_int_distribution<int> distribution(0, working_set - 1);
+          for (int i = 0; i < total_ops / num_threads; ++i) {
+            page_id_t page_id = page_ids[distribution(engine)];
+            Page *page = bpm->FetchPage(page_id);
+            ASSERT_NE(nullptr, page);
+            bpm->UnpinPage(page_id, false);
+          }
+        }));
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> elapsed =
+              std::chrono::steady_clock::now() - start;
+      printf("%-8s threads: %2d  %10.0f ops/s\n",
+             parallel ? "parallel" : "single", num_threads,
+             total_ops / elapsed.count());
+    }
+    EXPECT_EQ(true, bpm->CheckAllUnpined());
+    delete bpm;
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb
@@ -353,12 +353,12 @@ std::string BPLUSTREE_TYPE::ToString(bool verbose) {
   }
   std::queue<BPlusTreePage *> todo, tmp;
   std::stringstream tree;
-  auto node = reinterpret_cast<BPlusTreePage *>(
-          buffer_pool_manager_->FetchPage(root_page_id_));
-  if (node == nullptr) {
+  Page *root = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (root == nullptr) {
     throw Exception(EXCEPTION_TYPE_INDEX,
                     "all page are pinned while printing");
   }
+  auto node = reinterpret_cast<BPlusTreePage *>(root->GetData());
   todo.push(node);
   bool first = true;
   while (!todo.empty()) {
@@ -447,12 +447,12 @@ std::string BPLUSTREE_TYPE::ToString(bool verbose) {
   }
   std::queue<BPlusTreePage *> todo, tmp;
   std::stringstream tree;
-  auto node = reinterpret_cast<BPlusTreePage *>(
-          buffer_pool_manager_->FetchPage(root_page_id_));
-  if (node == nullptr) {
+  Page *root = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (root == nullptr) {
     throw Exception(EXCEPTION_TYPE_INDEX,
                     "all page are pinned while printing");
   }
+  auto node = reinterpret_cast<BPlusTreePage *>(root->GetData());
   todo.push(node);
   bool first = true;
   while (!todo.empty()) {
@@ -525,10 +525,11 @@ void BPLUSTREE_TYPE::RemoveFromFile(const std::string &file_name,
 INDEX_TEMPLATE_ARGUMENTS
 int BPLUSTREE_TYPE::isBalanced(page_id_t pid) {
   if (IsEmpty()) return true;
-  auto node = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(pid));
-  if (node == nullptr) {
+  Page *raw = buffer_pool_manager_->FetchPage(pid);
+  if (raw == nullptr) {
     throw Exception(EXCEPTION_TYPE_INDEX,"all page are pinned while isBalanced");
   }
+  auto node = reinterpret_cast<BPlusTreePage *>(raw->GetData());
   int ret = 0;
   if (!node->IsLeafPage())  {
     auto page = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(node);
@@ -551,10 +552,11 @@ int BPLUSTREE_TYPE::isBalanced(page_id_t pid) {
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::isPageCorr(page_id_t pid,pair<KeyType,KeyType> &out) {
   if (IsEmpty()) return true;
-  auto node = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(pid));
-  if (node == nullptr) {
+  Page *raw = buffer_pool_manager_->FetchPage(pid);
+  if (raw == nullptr) {
     throw Exception(EXCEPTION_TYPE_INDEX,"all page are pinned while isPageCorr");
   }
+  auto node = reinterpret_cast<BPlusTreePage *>(raw->GetData());
   bool ret = true;
   if (node->IsLeafPage())  {
     auto page = reinterpret_cast<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *>(node);
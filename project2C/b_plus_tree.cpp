@@ -1,8 +1,14 @@
 /**
  * b_plus_tree.cpp
  */
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <queue>
 #include <string>
+#include <utility>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -12,13 +18,31 @@
 
 namespace cmudb {
 
+// optimistic descents a reader tries before taking mutex_ and crabbing down
+static const int OPTIMISTIC_RETRIES = 3;
+
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(const std::string &name,
                           BufferPoolManager *buffer_pool_manager,
                           const KeyComparator &comparator,
-                          page_id_t root_page_id)
+                          page_id_t root_page_id, bool blink, int key_size,
+                          bool compress)
         : index_name_(name), root_page_id_(root_page_id),
-          buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
+          buffer_pool_manager_(buffer_pool_manager), comparator_(comparator),
+          blink_(blink), key_size_(key_size),
+          integer_keys_(!compress &&
+                        key_size == static_cast<int>(sizeof(int64_t)) &&
+                        OrdersAsInt64<KeyType>(comparator)),
+          compress_(compress) {
+  if (key_size <= 0 || key_size > static_cast<int>(sizeof(KeyType))) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "invalid key size");
+  }
+  // B-link pages are never merged or redistributed: keys only come in by
+  // insert, which splits a page first if its layout can not take the key
+  if (compress && !blink) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "compression needs B-link mode");
+  }
+}
 
 /*
  * Helper function to decide whether current b+tree is empty
@@ -41,17 +65,12 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
                               std::vector<ValueType> &result,
                               Transaction *transaction) {
   //step 1. find page
-  B_PLUS_TREE_LEAF_PAGE_TYPE *tar = FindLeafPage(key,false,OpType::READ,transaction);
-  if (tar == nullptr)
+  ReadPageGuard guard = FindLeafPageRead(key,false);
+  if (guard.IsEmpty())
     return false;
-  //step 2. find value
+  //step 2. find value, the guard unlatches and unpins the leaf
   result.resize(1);
-  auto ret = tar->Lookup(key,result[0],comparator_);
-  //step 3. unPin buffer pool
-  FreePagesInTransaction(false,transaction,tar->GetPageId());
-  //buffer_pool_manager_->UnpinPage(tar->GetPageId(), false);
-  //assert(buffer_pool_manager_->CheckAllUnpined());
-  return ret;
+  return guard.As<B_PLUS_TREE_LEAF_PAGE_TYPE>()->Lookup(key,result[0],comparator_);
 }
 
 /*****************************************************************************
@@ -67,17 +86,38 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
                             Transaction *transaction) {
-  LockRootPageId(true);
+  CheckKeySize(key);
+  // writers only meet on mutex_ to start the tree
   if (IsEmpty()) {
-    StartNewTree(key,value);
+    LockRootPageId(true);
+    if (IsEmpty()) {
+      StartNewTree(key,value);
+      TryUnlockRootPageId(true);
+      return true;
+    }
     TryUnlockRootPageId(true);
-    return true;
   }
-  TryUnlockRootPageId(true);
+  if (blink_) {
+    return InsertBLink(key,value);
+  }
   bool res = InsertIntoLeaf(key,value,transaction);
   //assert(Check());
   return res;
 }
+/*
+ * Keys are truncated to key_size_ bytes in pages, the bytes cut off must be
+ * zero or the key would come back as another one
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CheckKeySize(const KeyType &key) const {
+  const char *bytes = reinterpret_cast<const char *>(&key);
+  for (size_t i = key_size_; i < sizeof(KeyType); i++) {
+    if (bytes[i] != 0) {
+      throw Exception(EXCEPTION_TYPE_INDEX, "key is longer than key size");
+    }
+  }
+}
+
 /*
  * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
@@ -88,19 +128,18 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
   //step 1. ask for new page from buffer pool manager
   page_id_t newPageId;
-  Page *rootPage = buffer_pool_manager_->NewPage(newPageId);
-  assert(rootPage != nullptr);
+  WritePageGuard rootPage = buffer_pool_manager_->NewPageGuarded(newPageId);
+  assert(!rootPage.IsEmpty());
 
-  B_PLUS_TREE_LEAF_PAGE_TYPE *root = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(rootPage->GetData());
+  B_PLUS_TREE_LEAF_PAGE_TYPE *root = rootPage.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
 
-  //step 2. update b+ tree's root page id
-  root->Init(newPageId,INVALID_PAGE_ID);
+  //step 2. insert entry directly into leaf page.
+  root->Init(newPageId,INVALID_PAGE_ID,key_size_,integer_keys_,compress_);
+  root->Insert(key,value,comparator_);
+  //step 3. update b+ tree's root page id, optimistic readers may follow it
+  // right away
   root_page_id_ = newPageId;
   UpdateRootPageId(true);
-  //step 3. insert entry directly into leaf page.
-  root->Insert(key,value,comparator_);
-
-  buffer_pool_manager_->UnpinPage(newPageId,true);
 }
 
 /*
@@ -115,6 +154,10 @@ INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
                                     Transaction *transaction) {
   B_PLUS_TREE_LEAF_PAGE_TYPE *leafPage = FindLeafPage(key,false,OpType::INSERT,transaction);
+  if (leafPage == nullptr) {
+    // emptied since Insert looked
+    return Insert(key,value,transaction);
+  }
   ValueType v;
   bool exist = leafPage->Lookup(key,v,comparator_);
   if (exist) {
@@ -149,7 +192,8 @@ template <typename N> N *BPLUSTREE_TYPE::Split(N *node, Transaction *transaction
   transaction->AddIntoPageSet(newPage);
   //step 2 move half of key & value pairs from input page to newly created page
   N *newNode = reinterpret_cast<N *>(newPage->GetData());
-  newNode->Init(newPageId, node->GetParentPageId());
+  newNode->Init(newPageId, node->GetParentPageId(), key_size_, integer_keys_,
+                compress_);
   node->MoveHalfTo(newNode, buffer_pool_manager_);
   //fetch page and new page need to unpin page(do it outside)
   return newNode;
@@ -170,14 +214,18 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
                                       BPlusTreePage *new_node,
                                       Transaction *transaction) {
   if (old_node->IsRootPage()) {
-    Page* const newPage = buffer_pool_manager_->NewPage(root_page_id_);
+    page_id_t newRootId;
+    Page* const newPage = buffer_pool_manager_->NewPage(newRootId);
     assert(newPage != nullptr);
     assert(newPage->GetPinCount() == 1);
     B_PLUS_TREE_INTERNAL_PAGE *newRoot = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(newPage->GetData());
-    newRoot->Init(root_page_id_);
+    newRoot->Init(newRootId, INVALID_PAGE_ID, key_size_, integer_keys_,
+                  compress_);
     newRoot->PopulateNewRoot(old_node->GetPageId(),key,new_node->GetPageId());
-    old_node->SetParentPageId(root_page_id_);
-    new_node->SetParentPageId(root_page_id_);
+    old_node->SetParentPageId(newRootId);
+    new_node->SetParentPageId(newRootId);
+    // published once populated, optimistic readers do not take mutex_
+    root_page_id_ = newRootId;
     UpdateRootPageId();
     //fetch page and new page need to unpin page
     //buffer_pool_manager_->UnpinPage(new_node->GetPageId(),true);
@@ -200,6 +248,527 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
   buffer_pool_manager_->UnpinPage(parentId,true);
 }
 
+/*
+ * Insert in B-link mode: only the leaf is write latched on the way down, see
+ * FindLeafPageWriteBLink. A full leaf splits while nothing else is latched,
+ * the new page linked right of it, then InsertIntoParentBLink goes up. A
+ * compressed leaf whose layout can not take key splits first, and the insert
+ * starts over.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::InsertBLink(const KeyType &key, const ValueType &value) {
+  WritePageGuard leafGuard = FindLeafPageWriteBLink(key);
+  if (leafGuard.IsEmpty()) {
+    return Insert(key, value);
+  }
+  auto leaf = leafGuard.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
+  ValueType v;
+  if (leaf->Lookup(key, v, comparator_)) {
+    return false;
+  }
+  if (!leaf->Admits(key)) {
+    SplitBLink<B_PLUS_TREE_LEAF_PAGE_TYPE>(leafGuard);
+    return InsertBLink(key, value);
+  }
+  leaf->Insert(key, value, comparator_);
+  leafGuard.MarkDirty();
+  if (leaf->GetSize() > leaf->GetMaxSize()) {
+    SplitBLink<B_PLUS_TREE_LEAF_PAGE_TYPE>(leafGuard);
+  }
+  return true;
+}
+
+/*
+ * Split the write latched page of node into itself and a new page right of
+ * it, then insert the key bounding them into the parent; both latches are
+ * released on return.
+ * The key bounding them is the high key node gets, the first key of the new
+ * page, or for a compressed leaf the shortest key between both pages.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+template <typename N>
+void BPLUSTREE_TYPE::SplitBLink(WritePageGuard &node) {
+  page_id_t newPageId;
+  WritePageGuard newGuard = buffer_pool_manager_->NewPageGuarded(newPageId);
+  if (newGuard.IsEmpty()) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  }
+  auto oldNode = node.As<N>();
+  auto newNode = newGuard.As<N>();
+  newNode->Init(newPageId, oldNode->GetParentPageId(), key_size_,
+                integer_keys_, compress_);
+  oldNode->MoveHalfTo(newNode, buffer_pool_manager_);
+  if (compress_ && oldNode->IsLeafPage()) {
+    oldNode->SetHighKey(ShortestSeparator(
+            oldNode->KeyAt(oldNode->GetSize() - 1), newNode->KeyAt(0)));
+  }
+  node.MarkDirty();
+  newGuard.MarkDirty();
+  InsertIntoParentBLink(node, oldNode->GetHighKey(), newGuard);
+}
+
+/*
+ * The key s with left < s <= right which has the most trailing zero bytes:
+ * right, its bytes from the first one after where it differs from left on
+ * zeroed, as long as it stays above left.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+KeyType BPLUSTREE_TYPE::ShortestSeparator(const KeyType &left,
+                                          const KeyType &right) const {
+  const char *l = reinterpret_cast<const char *>(&left);
+  const char *r = reinterpret_cast<const char *>(&right);
+  size_t size = 0;
+  while (size < sizeof(KeyType) && l[size] == r[size]) {
+    size++;
+  }
+  KeyType separator;
+  for (size++; size < sizeof(KeyType); size++) {
+    memcpy(&separator, &right, size);
+    memset(reinterpret_cast<char *>(&separator) + size, 0,
+           sizeof(KeyType) - size);
+    if (comparator_(left, separator) < 0 &&
+        comparator_(separator, right) <= 0) {
+      return separator;
+    }
+  }
+  return right;
+}
+
+/*
+ * node was split into itself and new_node, both write latched, key bounding
+ * them. new_node is reachable through the right link of node, so it is
+ * released first; the parent is latched before node is released. Latches are
+ * taken bottom up and left to right, in that order only, so this does not
+ * deadlock with other writers, while readers never hold two latches.
+ * The parent page id of node is a hint, the parent may have split since and
+ * the page on the right be the one to take key, which goes in by key: the
+ * page node was split from may not be in there yet either.
+ * A compressed parent whose layout can not take key splits first, and key
+ * goes into whichever half it then belongs to.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParentBLink(WritePageGuard &node,
+                                           const KeyType &key,
+                                           WritePageGuard &new_node) {
+  const KeyType separator = key;
+  auto oldNode = node.As<BPlusTreePage>();
+  auto newNode = new_node.As<BPlusTreePage>();
+  // only the latch of the root keeps it the root
+  if (oldNode->IsRootPage()) {
+    page_id_t newRootId;
+    WritePageGuard rootGuard = buffer_pool_manager_->NewPageGuarded(newRootId);
+    if (rootGuard.IsEmpty()) {
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    }
+    auto newRoot = rootGuard.As<B_PLUS_TREE_INTERNAL_PAGE>();
+    newRoot->Init(newRootId, INVALID_PAGE_ID, key_size_, integer_keys_,
+                  compress_);
+    newRoot->PopulateNewRoot(oldNode->GetPageId(), separator,
+                             newNode->GetPageId());
+    oldNode->SetParentPageId(newRootId);
+    newNode->SetParentPageId(newRootId);
+    root_page_id_ = newRootId;
+    UpdateRootPageId();
+    node.Release();
+    new_node.Release();
+    return;
+  }
+  const page_id_t newPageId = newNode->GetPageId();
+  const page_id_t parentId = oldNode->GetParentPageId();
+  new_node.Release();
+  WritePageGuard parentGuard = buffer_pool_manager_->FetchPageWrite(parentId);
+  node.Release();
+  for (;;) {
+    MoveRight(parentGuard, separator, &BufferPoolManager::FetchPageWrite);
+    // child pointers move, swizzled ones would get lost
+    buffer_pool_manager_->Unswizzle(parentGuard.GetPage());
+    if (parentGuard.As<B_PLUS_TREE_INTERNAL_PAGE>()->Admits(separator)) {
+      break;
+    }
+    const page_id_t splitId = parentGuard.GetPageId();
+    SplitBLink<B_PLUS_TREE_INTERNAL_PAGE>(parentGuard);
+    parentGuard = buffer_pool_manager_->FetchPageWrite(splitId);
+  }
+  parentGuard.MarkDirty();
+  auto parent = parentGuard.As<B_PLUS_TREE_INTERNAL_PAGE>();
+  parent->InsertNodeAfter(
+          parent->ValueAt(parent->LookupIndex(separator, comparator_)),
+          separator, newPageId);
+  if (parent->GetSize() > parent->GetMaxSize()) {
+    SplitBLink<B_PLUS_TREE_INTERNAL_PAGE>(parentGuard);
+  }
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+/*
+ * Page sizes for n entries split into pages of per entries: whatever is left
+ * below 2 * per goes to one last page, or two halves when it is more than
+ * max. Every page then holds at least per / 2 >= min size entries, but a
+ * single page, the root, may hold less.
+ */
+static std::vector<int> PackSizes(int n, int per, int max) {
+  std::vector<int> sizes;
+  while (n >= 2 * per) {
+    sizes.push_back(per);
+    n -= per;
+  }
+  if (n > max) {
+    sizes.push_back(n / 2);
+    n -= n / 2;
+  }
+  if (n > 0) {
+    sizes.push_back(n);
+  }
+  return sizes;
+}
+
+/*
+ * Entries per page for a fill factor, not below the min size of a page
+ */
+static int FillCount(int max_size, double fill_factor) {
+  int count = static_cast<int>(max_size * fill_factor);
+  return std::max(max_size / 2 + 1, std::min(max_size, count));
+}
+
+/*
+ * Build an empty tree bottom up from pairs in ascending key order, next
+ * returning false past the last one.
+ * A key equal to the previous one is skipped, since we only support unique
+ * key; a smaller one throws, the pages written so far are deleted and the
+ * tree stays empty.
+ * @return: false if the tree is not empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(const std::function<bool(MappingType &)> &next,
+                              double fill_factor) {
+  LockRootPageId(true);
+  if (!IsEmpty()) {
+    TryUnlockRootPageId(true);
+    return false;
+  }
+  page_id_t rootPageId;
+  try {
+    rootPageId = BuildBottomUp(next, fill_factor);
+  } catch (...) {
+    TryUnlockRootPageId(true);
+    throw;
+  }
+  if (rootPageId != INVALID_PAGE_ID) {
+    root_page_id_ = rootPageId;
+    UpdateRootPageId(true);
+  }
+  TryUnlockRootPageId(true);
+  return true;
+}
+
+/*
+ * Leaves are written left to right, each filled to fill_factor of its max
+ * size and linked to the next one. Every page written goes right away to the
+ * last node of the level above, which takes its first key and becomes its
+ * parent, so a child is never fetched again to set its parent page id. Pages
+ * are written once, no descent, no shift, no split.
+ * If anything throws, the pages allocated so far are deleted.
+ * @return: the root page id, INVALID_PAGE_ID without any pair
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREE_TYPE::BuildBottomUp(
+        const std::function<bool(MappingType &)> &next, double fill_factor) {
+  // as Init of each page sets them
+  const int leafMax = B_PLUS_TREE_LEAF_PAGE_TYPE::MaxSizeFor(key_size_);
+  const int internalMax = B_PLUS_TREE_INTERNAL_PAGE::MaxSizeFor(key_size_);
+  const int leafPer = FillCount(leafMax, fill_factor);
+  const int internalPer = FillCount(internalMax, fill_factor);
+
+  std::vector<page_id_t> allocated;
+  auto newPage = [&](page_id_t &pageId) {
+    WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(pageId);
+    if (guard.IsEmpty()) {
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    }
+    allocated.push_back(pageId);
+    return guard;
+  };
+  // per internal level, bottom up: the node being filled and the one before
+  // it, which is only handed to its parent once the level goes on beyond the
+  // node being filled, so that the last two can be balanced at the end
+  std::vector<std::pair<WritePageGuard, WritePageGuard>> levels;
+  // the leaf written last waits for the page id of the next one
+  WritePageGuard prevLeaf;
+
+  // child, first key, goes to the end of the node being filled at level
+  std::function<void(size_t, WritePageGuard, const KeyType &)> addChild =
+          [&](size_t level, WritePageGuard child, const KeyType &key) {
+    if (levels.size() == level) {
+      levels.emplace_back();
+    }
+    if (levels[level].second.IsEmpty() ||
+        levels[level].second.As<B_PLUS_TREE_INTERNAL_PAGE>()->GetSize() ==
+                internalPer) {
+      page_id_t pageId;
+      WritePageGuard guard = newPage(pageId);
+      guard.As<B_PLUS_TREE_INTERNAL_PAGE>()->Init(
+              pageId, INVALID_PAGE_ID, key_size_, integer_keys_, compress_);
+      if (!levels[level].second.IsEmpty()) {
+        auto full = levels[level].second.As<B_PLUS_TREE_INTERNAL_PAGE>();
+        full->SetNextPageId(pageId);
+        full->SetHighKey(key);
+        if (!levels[level].first.IsEmpty()) {
+          WritePageGuard prev = std::move(levels[level].first);
+          const KeyType prevKey =
+                  prev.As<B_PLUS_TREE_INTERNAL_PAGE>()->KeyAt(0);
+          addChild(level + 1, std::move(prev), prevKey);
+        }
+        levels[level].first = std::move(levels[level].second);
+      }
+      levels[level].second = std::move(guard);
+    }
+    auto node = levels[level].second.As<B_PLUS_TREE_INTERNAL_PAGE>();
+    // as after a split, the first key is the least one below
+    node->IncreaseSize(1);
+    node->SetKeyAt(node->GetSize() - 1, key);
+    *node->ValuePointerAt(node->GetSize() - 1) = child.GetPageId();
+    child.As<BPlusTreePage>()->SetParentPageId(node->GetPageId());
+  };
+
+  // prev then node, the last two nodes of a level: if node is below its min
+  // size, their children are split evenly, or all go to prev when they fit
+  auto balance = [&](WritePageGuard &prev, WritePageGuard &node) {
+    auto left = prev.As<B_PLUS_TREE_INTERNAL_PAGE>();
+    auto right = node.As<B_PLUS_TREE_INTERNAL_PAGE>();
+    // node has no parent yet, GetMinSize would take it for the root
+    if (right->GetSize() >= right->GetMaxSize() / 2) {
+      return;
+    }
+    const int total = left->GetSize() + right->GetSize();
+    // children that change node, all of them now below parentId
+    std::vector<page_id_t> moved;
+    page_id_t parentId;
+    if (total <= internalMax) {
+      for (int i = 0; i < right->GetSize(); i++) {
+        left->IncreaseSize(1);
+        left->SetKeyAt(left->GetSize() - 1, right->KeyAt(i));
+        *left->ValuePointerAt(left->GetSize() - 1) = right->ValueAt(i);
+        moved.push_back(right->ValueAt(i));
+      }
+      // the last node of the level has no next page, so no high key
+      left->SetNextPageId(INVALID_PAGE_ID);
+      parentId = prev.GetPageId();
+      const page_id_t dropped = node.GetPageId();
+      node.Release();
+      buffer_pool_manager_->DeletePage(dropped);
+      allocated.erase(std::find(allocated.begin(), allocated.end(), dropped));
+    } else {
+      const int leftSize = total / 2;
+      std::vector<std::pair<KeyType, page_id_t>> items;
+      for (int i = leftSize; i < left->GetSize(); i++) {
+        items.emplace_back(left->KeyAt(i), left->ValueAt(i));
+        moved.push_back(left->ValueAt(i));
+      }
+      for (int i = 0; i < right->GetSize(); i++) {
+        items.emplace_back(right->KeyAt(i), right->ValueAt(i));
+      }
+      left->SetSize(leftSize);
+      left->SetHighKey(items[0].first);
+      right->SetSize(static_cast<int>(items.size()));
+      for (size_t i = 0; i < items.size(); i++) {
+        right->SetKeyAt(i, items[i].first);
+        *right->ValuePointerAt(i) = items[i].second;
+      }
+      parentId = node.GetPageId();
+    }
+    for (page_id_t childId : moved) {
+      WritePageGuard child = buffer_pool_manager_->FetchPageWrite(childId);
+      if (child.IsEmpty()) {
+        throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+      }
+      child.As<BPlusTreePage>()->SetParentPageId(parentId);
+      child.MarkDirty();
+    }
+  };
+  auto writeLeaf = [&](const MappingType *items, int size) {
+    page_id_t pageId;
+    WritePageGuard guard = newPage(pageId);
+    auto leaf = guard.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
+    leaf->Init(pageId, INVALID_PAGE_ID, key_size_, integer_keys_, compress_);
+    for (int i = 0; i < size; i++) {
+      // appended at the end, nothing to shift
+      leaf->Insert(items[i].first, items[i].second, comparator_);
+    }
+    if (!prevLeaf.IsEmpty()) {
+      auto prev = prevLeaf.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
+      prev->SetNextPageId(pageId);
+      prev->SetHighKey(items[0].first);
+      const KeyType prevKey = prev->KeyAt(0);
+      addChild(0, std::move(prevLeaf), prevKey);
+    }
+    prevLeaf = std::move(guard);
+  };
+
+  try {
+    // at most two leaves of pairs ahead, so the last ones can be balanced
+    std::vector<MappingType> pending;
+    MappingType item;
+    while (next(item)) {
+      CheckKeySize(item.first);
+      // a leaf is only written with pairs left behind it in pending
+      if (!pending.empty()) {
+        int cmp = comparator_(pending.back().first, item.first);
+        if (cmp == 0) {
+          continue;
+        }
+        if (cmp > 0) {
+          throw Exception(EXCEPTION_TYPE_INDEX,
+                          "bulk load input is not sorted");
+        }
+      }
+      pending.push_back(item);
+      if (pending.size() == static_cast<size_t>(2 * leafPer)) {
+        writeLeaf(pending.data(), leafPer);
+        pending.erase(pending.begin(), pending.begin() + leafPer);
+      }
+    }
+    int written = 0;
+    for (int size : PackSizes(pending.size(), leafPer, leafMax)) {
+      writeLeaf(pending.data() + written, size);
+      written += size;
+    }
+    if (prevLeaf.IsEmpty()) {
+      return INVALID_PAGE_ID;
+    }
+    if (levels.empty()) {
+      return prevLeaf.GetPageId();
+    }
+    const KeyType lastKey =
+            prevLeaf.As<B_PLUS_TREE_LEAF_PAGE_TYPE>()->KeyAt(0);
+    addChild(0, std::move(prevLeaf), lastKey);
+    // the last nodes of every level go to their parents, bottom up; a level
+    // with a single node is the root
+    for (size_t level = 0;; level++) {
+      WritePageGuard prev = std::move(levels[level].first);
+      WritePageGuard node = std::move(levels[level].second);
+      if (prev.IsEmpty()) {
+        return node.GetPageId();
+      }
+      balance(prev, node);
+      if (node.IsEmpty() && levels.size() == level + 1) {
+        // merged, and nothing was handed to a parent before
+        return prev.GetPageId();
+      }
+      const KeyType prevKey = prev.As<B_PLUS_TREE_INTERNAL_PAGE>()->KeyAt(0);
+      addChild(level + 1, std::move(prev), prevKey);
+      if (!node.IsEmpty()) {
+        const KeyType key = node.As<B_PLUS_TREE_INTERNAL_PAGE>()->KeyAt(0);
+        addChild(level + 1, std::move(node), key);
+      }
+    }
+  } catch (...) {
+    prevLeaf.Release();
+    levels.clear();
+    for (page_id_t pageId : allocated) {
+      buffer_pool_manager_->DeletePage(pageId);
+    }
+    throw;
+  }
+}
+
+/*
+ * Bulk load the int64 keys of a file (see InsertFromFile), in any order.
+ * Keys are sorted in memory by runs of run_size; when there is more than one
+ * run, each is written sorted next to the file and the runs are merged while
+ * the tree is built.
+ * return false, leaving the tree as it was, if the file can not be opened,
+ * holds anything else than keys or run_size is 0
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoadFromFile(const std::string &file_name,
+                                      double fill_factor, size_t run_size) {
+  std::vector<int64_t> run;
+  std::vector<std::string> runFiles;
+  auto spill = [&]() {
+    std::sort(run.begin(), run.end());
+    runFiles.push_back(file_name + ".run" + std::to_string(runFiles.size()));
+    std::ofstream output(runFiles.back(), std::ios::binary);
+    output.write(reinterpret_cast<const char *>(run.data()),
+                 run.size() * sizeof(int64_t));
+    run.clear();
+  };
+  auto removeRuns = [&]() {
+    for (auto &runFile : runFiles) {
+      remove(runFile.c_str());
+    }
+  };
+  if (run_size == 0) {
+    return false;
+  }
+  int64_t key;
+  std::ifstream input(file_name);
+  if (!input.is_open()) {
+    return false;
+  }
+  while (input >> key) {
+    run.push_back(key);
+    if (run.size() == run_size) {
+      spill();
+    }
+  }
+  // stopped before the end of the file: not an int64 key
+  if (!input.eof()) {
+    removeRuns();
+    return false;
+  }
+  if (!runFiles.empty() && !run.empty()) {
+    spill();
+  }
+  std::sort(run.begin(), run.end());
+
+  // smallest next key of every run
+  std::vector<std::ifstream> runs;
+  typedef std::pair<int64_t, size_t> RunHead;
+  std::priority_queue<RunHead, std::vector<RunHead>, std::greater<RunHead>> heads;
+  for (size_t i = 0; i < runFiles.size(); i++) {
+    runs.emplace_back(runFiles[i], std::ios::binary);
+    if (runs[i].read(reinterpret_cast<char *>(&key), sizeof(int64_t))) {
+      heads.emplace(key, i);
+    }
+  }
+  size_t index = 0;
+  auto next = [&](MappingType &item) {
+    if (runFiles.empty()) {
+      if (index == run.size()) {
+        return false;
+      }
+      key = run[index++];
+    } else {
+      if (heads.empty()) {
+        return false;
+      }
+      RunHead head = heads.top();
+      heads.pop();
+      key = head.first;
+      int64_t following;
+      if (runs[head.second].read(reinterpret_cast<char *>(&following),
+                                 sizeof(int64_t))) {
+        heads.emplace(following, head.second);
+      }
+    }
+    item.first.SetFromInteger(key);
+    item.second = ValueType(key);
+    return true;
+  };
+
+  bool res;
+  try {
+    res = BulkLoad(next, fill_factor);
+  } catch (...) {
+    removeRuns();
+    throw;
+  }
+  removeRuns();
+  return res;
+}
+
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
@@ -213,7 +782,12 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
   if (IsEmpty()) return;
+  if (blink_) {
+    RemoveBLink(key);
+    return;
+  }
   B_PLUS_TREE_LEAF_PAGE_TYPE *delTar = FindLeafPage(key,false,OpType::DELETE,transaction);
+  if (delTar == nullptr) return;
   int curSize = delTar->RemoveAndDeleteRecord(key,comparator_);
   if (curSize < delTar->GetMinSize()) {
     CoalesceOrRedistribute(delTar,transaction);
@@ -222,6 +796,24 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
   //assert(Check());
 }
 
+/*
+ * Remove in B-link mode: only the leaf is write latched, and it stays however
+ * small it gets. Merging would delete pages which readers may be about to
+ * latch, they hold no latch of the parent.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemoveBLink(const KeyType &key) {
+  WritePageGuard leafGuard = FindLeafPageWriteBLink(key);
+  if (leafGuard.IsEmpty()) {
+    return;
+  }
+  auto leaf = leafGuard.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
+  int size = leaf->GetSize();
+  if (leaf->RemoveAndDeleteRecord(key, comparator_) != size) {
+    leafGuard.MarkDirty();
+  }
+}
+
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
  * page's size > page's max size, then redistribute. Otherwise, merge.
@@ -369,9 +961,8 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
   KeyType useless;
-  auto start_leaf = FindLeafPage(useless, true);
-  TryUnlockRootPageId(false);
-  return INDEXITERATOR_TYPE(start_leaf, 0, buffer_pool_manager_);
+  return INDEXITERATOR_TYPE(FindLeafPageRead(useless, true), 0,
+                            buffer_pool_manager_);
 }
 
 /*
@@ -381,13 +972,12 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
-  auto start_leaf = FindLeafPage(key);
-  TryUnlockRootPageId(false);
-  if (start_leaf == nullptr) {
-    return INDEXITERATOR_TYPE(start_leaf, 0, buffer_pool_manager_);
+  ReadPageGuard start_leaf = FindLeafPageRead(key, false);
+  int idx = 0;
+  if (!start_leaf.IsEmpty()) {
+    idx = start_leaf.As<B_PLUS_TREE_LEAF_PAGE_TYPE>()->KeyIndex(key,comparator_);
   }
-  int idx = start_leaf->KeyIndex(key,comparator_);
-  return INDEXITERATOR_TYPE(start_leaf, idx, buffer_pool_manager_);
+  return INDEXITERATOR_TYPE(std::move(start_leaf), idx, buffer_pool_manager_);
 }
 
 /*****************************************************************************
@@ -396,12 +986,24 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
+ * The pages latched on the way are collected in transaction, which releases
+ * them, see FreePagesInTransaction. GetValue and iterators use
+ * FindLeafPageRead instead.
+ * Writers first try FindLeafPageOptimisticWrite, and only crab down with
+ * write latches, from mutex_ on, when the leaf may split or merge.
  */
 INDEX_TEMPLATE_ARGUMENTS
 B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
                                                          bool leftMost,OpType op,
                                                          Transaction *transaction) {
+  assert(transaction != nullptr);
   bool exclusive = (op != OpType::READ);
+  if (exclusive) {
+    auto leaf = FindLeafPageOptimisticWrite(key, leftMost, op, transaction);
+    if (leaf != nullptr) {
+      return leaf;
+    }
+  }
   LockRootPageId(exclusive);
   if (IsEmpty()) {
     TryUnlockRootPageId(exclusive);
@@ -415,13 +1017,275 @@ B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
           CrabingProtocalFetchPage(next,op,cur,transaction),cur = next) {
     B_PLUS_TREE_INTERNAL_PAGE *internalPage = static_cast<B_PLUS_TREE_INTERNAL_PAGE *>(pointer);
     if (leftMost) {
-      next = internalPage->ValueAt(0);
+      next = ChildPageId(internalPage->ValueAt(0));
     }else {
-      next = internalPage->Lookup(key,comparator_);
+      next = ChildPageId(internalPage->Lookup(key,comparator_));
     }
   }
   return static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(pointer);
 }
+
+/*
+ * Writers descend as readers do, read latch coupling, and only write latch
+ * the leaf: a leaf which is safe for op does not split or merge, so none of
+ * its ancestors is written. A leaf is read latched first, we can not tell it
+ * from an internal page before; it is then write latched while its parent is
+ * still read latched, which keeps its key range as it is. The root is a leaf
+ * while it is the only page, and mutex_ held shared keeps it the root until it
+ * is write latched.
+ * return the leaf, write latched, pinned and in the page set of transaction
+ * like FindLeafPage does, or nullptr if the tree is empty or the leaf is not
+ * safe: the caller then crabs down with write latches.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPageOptimisticWrite(
+        const KeyType &key, bool leftMost, OpType op, Transaction *transaction) {
+  LockRootPageId(false);
+  page_id_t cur = root_page_id_;
+  if (cur == INVALID_PAGE_ID) {
+    TryUnlockRootPageId(false);
+    return nullptr;
+  }
+  ReadPageGuard parent;
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(cur);
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+    auto internalPage = guard.As<B_PLUS_TREE_INTERNAL_PAGE>();
+    cur = ChildPageId(leftMost ? internalPage->ValueAt(0)
+                               : internalPage->Lookup(key, comparator_));
+    parent = std::move(guard);
+    // the root can not change while it is latched
+    TryUnlockRootPageId(false);
+    guard = buffer_pool_manager_->FetchPageRead(cur);
+  }
+  guard.Release();
+  Page *page = buffer_pool_manager_->FetchPage(cur);
+  Lock(true, page);
+  parent.Release();
+  TryUnlockRootPageId(false);
+  auto leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  if (!leaf->IsSafe(op)) {
+    Unlock(true, page);
+    buffer_pool_manager_->UnpinFrame(page, false);
+    return nullptr;
+  }
+  transaction->AddIntoPageSet(page);
+  return leaf;
+}
+
+/*
+ * Find the leaf page containing key (the left most leaf page if leftMost) for
+ * reading, read latched and pinned by the returned guard, which is empty if
+ * the tree is empty. Optimistic descents first, then crabbing down: the guard
+ * of a child replaces the guard of its parent once the child is latched.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ReadPageGuard BPLUSTREE_TYPE::FindLeafPageRead(const KeyType &key,
+                                               bool leftMost) {
+  // a compressed page changes layout in place, a torn read of it could take
+  // any offset for one of its keys
+  for (int i = 0; !compress_ && i < OPTIMISTIC_RETRIES; ++i) {
+    ReadPageGuard leaf = FindLeafPageOptimistic(key, leftMost);
+    if (!leaf.IsEmpty()) {
+      return leaf;
+    }
+  }
+  if (blink_) {
+    return FindLeafPageBLink(key, leftMost);
+  }
+  LockRootPageId(false);
+  if (IsEmpty()) {
+    TryUnlockRootPageId(false);
+    return ReadPageGuard();
+  }
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(root_page_id_);
+  // the root can not change while it is latched
+  TryUnlockRootPageId(false);
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+    auto internalPage = guard.As<B_PLUS_TREE_INTERNAL_PAGE>();
+    page_id_t next = ChildPageId(leftMost ? internalPage->ValueAt(0)
+                                          : internalPage->Lookup(key, comparator_));
+    guard = buffer_pool_manager_->FetchPageRead(next);
+  }
+  return guard;
+}
+
+/*
+ * Readers first try to reach the leaf this way: internal pages are read
+ * without pin, latch or mutex_ (see BufferPoolManager::FetchPageOptimistic),
+ * so the descent writes no shared memory. A child is only followed once the
+ * version of its parent proves that it was read from a consistent page, and
+ * the leaf is fetched, read latched, and kept only if the version of its
+ * parent still holds afterwards.
+ * With swizzling on, a swizzled child pointer leads to its frame without
+ * asking the page table, and pointers to internal pages found through the
+ * page table get swizzled on the way.
+ * return an empty guard on conflict with a writer, on an empty tree, or when
+ * a page is not buffered: the caller falls back to crabbing.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ReadPageGuard BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key,
+                                                     bool leftMost) {
+  // the largest size an internal page can have, a torn read may see anything
+  const int max_size = B_PLUS_TREE_INTERNAL_PAGE::MaxSizeFor(key_size_) + 1;
+  page_id_t cur = root_page_id_;
+  if (cur == INVALID_PAGE_ID) {
+    return ReadPageGuard();
+  }
+  uint64_t version, parent_version = 0;
+  Page *parent = nullptr;
+  page_id_t *parent_slot = nullptr; // to swizzle, if page is internal
+  Page *page = buffer_pool_manager_->FetchPageOptimistic(cur, version);
+  while (page != nullptr) {
+    auto node = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(page->GetData());
+    if (node->IsLeafPage()) {
+      if (!page->Validate(version)) {
+        return ReadPageGuard();
+      }
+      break;
+    }
+    const int size = node->GetSize();
+    if (size < 2 || size > max_size || node->GetKeySize() != key_size_) {
+      return ReadPageGuard(); // being written, or a page which is not part of a tree
+    }
+    if (!leftMost && node->IsPastHighKey(key, comparator_)) {
+      return ReadPageGuard(); // split after its parent was read
+    }
+    page_id_t *slot = node->ValuePointerAt(
+            leftMost ? 0 : node->LookupIndex(key, comparator_));
+    const page_id_t next_value = *slot;
+    if (!page->Validate(version)) {
+      return ReadPageGuard();
+    }
+    if (parent == nullptr && root_page_id_ != cur) {
+      return ReadPageGuard(); // not the root any more
+    }
+    if (parent_slot != nullptr) {
+      buffer_pool_manager_->Swizzle(parent, parent_version, parent_slot, page);
+    }
+    uint64_t next_version;
+    page_id_t next = next_value;
+    Page *child;
+    if (BufferPoolManager::IsSwizzled(next_value)) {
+      // pinned as long as the parent holds the swizzled pointer
+      child = buffer_pool_manager_->GetSwizzledPage(next_value);
+      next_version = child->GetVersion();
+      next = child->GetPageId();
+      parent_slot = nullptr;
+      if (next_version & 1) {
+        child = nullptr; // being written
+      }
+    } else {
+      child = buffer_pool_manager_->FetchPageOptimistic(next, next_version);
+      parent_slot = slot;
+    }
+    // the child was split or merged before its version was taken
+    if (!page->Validate(version)) {
+      return ReadPageGuard();
+    }
+    parent = page;
+    parent_version = version;
+    page = child;
+    version = next_version;
+    cur = next;
+  }
+  if (page == nullptr) {
+    return ReadPageGuard();
+  }
+  ReadPageGuard leaf = buffer_pool_manager_->FetchPageRead(cur);
+  const bool valid = parent == nullptr ? root_page_id_ == cur
+                                       : parent->Validate(parent_version);
+  if (!valid || leaf.IsEmpty() || !leaf.As<BPlusTreePage>()->IsLeafPage()) {
+    return ReadPageGuard();
+  }
+  // in B-link mode leaves split without their parent being written
+  if (!leftMost) {
+    MoveRight(leaf, key, &BufferPoolManager::FetchPageRead);
+  }
+  return leaf;
+}
+
+/*
+ * The page right of node if key is past its high key, INVALID_PAGE_ID if key
+ * belongs to node
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREE_TYPE::RightPageId(BPlusTreePage *node, const KeyType &key) {
+  if (node->IsLeafPage()) {
+    auto leaf = static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node);
+    return leaf->IsPastHighKey(key, comparator_) ? leaf->GetNextPageId()
+                                                 : INVALID_PAGE_ID;
+  }
+  auto internalPage = static_cast<B_PLUS_TREE_INTERNAL_PAGE *>(node);
+  return internalPage->IsPastHighKey(key, comparator_)
+                 ? internalPage->GetNextPageId()
+                 : INVALID_PAGE_ID;
+}
+
+/*
+ * Follow right links from the page of guard while key is past its high key:
+ * the page it was looked for in split after we learnt its page id. The page
+ * on the right is latched before the one on its left is released, so a merge
+ * can not get in between.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+template <typename Guard>
+void BPLUSTREE_TYPE::MoveRight(Guard &guard, const KeyType &key,
+                               Guard (BufferPoolManager::*fetch)(page_id_t)) {
+  for (page_id_t next = RightPageId(guard.template As<BPlusTreePage>(), key);
+       next != INVALID_PAGE_ID;
+       next = RightPageId(guard.template As<BPlusTreePage>(), key)) {
+    guard = (buffer_pool_manager_->*fetch)(next);
+  }
+}
+
+/*
+ * B-link mode descent: one read latch at a time, the parent is released
+ * before the child is latched, and a child split meanwhile is caught up with
+ * by moving right. Pages are never deleted in B-link mode, so the page id
+ * read from the parent stays a page of the tree.
+ * return the leaf, read latched, empty if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ReadPageGuard BPLUSTREE_TYPE::FindLeafPageBLink(const KeyType &key,
+                                                bool leftMost) {
+  // a former root is as good a start, the new one is above it
+  page_id_t cur = root_page_id_;
+  if (cur == INVALID_PAGE_ID) {
+    return ReadPageGuard();
+  }
+  ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(cur);
+  for (;;) {
+    if (!leftMost) {
+      MoveRight(guard, key, &BufferPoolManager::FetchPageRead);
+    }
+    if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+      return guard;
+    }
+    auto internalPage = guard.As<B_PLUS_TREE_INTERNAL_PAGE>();
+    cur = ChildPageId(leftMost ? internalPage->ValueAt(0)
+                               : internalPage->Lookup(key, comparator_));
+    guard.Release();
+    guard = buffer_pool_manager_->FetchPageRead(cur);
+  }
+}
+
+/*
+ * Same for writers, the leaf is then write latched; until it is, it may
+ * split, so move right again
+ */
+INDEX_TEMPLATE_ARGUMENTS
+WritePageGuard BPLUSTREE_TYPE::FindLeafPageWriteBLink(const KeyType &key) {
+  ReadPageGuard guard = FindLeafPageBLink(key, false);
+  if (guard.IsEmpty()) {
+    return WritePageGuard();
+  }
+  page_id_t leafPageId = guard.GetPageId();
+  guard.Release();
+  WritePageGuard leaf = buffer_pool_manager_->FetchPageWrite(leafPageId);
+  MoveRight(leaf, key, &BufferPoolManager::FetchPageWrite);
+  return leaf;
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 BPlusTreePage *BPLUSTREE_TYPE::FetchPage(page_id_t page_id) {
   auto page = buffer_pool_manager_->FetchPage(page_id);
@@ -432,28 +1296,26 @@ BPlusTreePage *BPLUSTREE_TYPE::CrabingProtocalFetchPage(page_id_t page_id,OpType
   bool exclusive = op != OpType::READ;
   auto page = buffer_pool_manager_->FetchPage(page_id);
   Lock(exclusive,page);
+  if (exclusive) {
+    // writers move child pointers around, swizzled ones would get lost
+    buffer_pool_manager_->Unswizzle(page);
+  }
   auto treePage = reinterpret_cast<BPlusTreePage *>(page->GetData());
   if (previous > 0 && (!exclusive || treePage->IsSafe(op))) {
-    FreePagesInTransaction(exclusive,transaction,previous);
+    FreePagesInTransaction(exclusive,transaction);
   }
-  if (transaction != nullptr)
-    transaction->AddIntoPageSet(page);
+  transaction->AddIntoPageSet(page);
   return treePage;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::FreePagesInTransaction(bool exclusive, Transaction *transaction, page_id_t cur) {
+void BPLUSTREE_TYPE::FreePagesInTransaction(bool exclusive, Transaction *transaction) {
   TryUnlockRootPageId(exclusive);
-  if (transaction == nullptr) {
-    assert(!exclusive && cur >= 0);
-    Unlock(false,cur);
-    buffer_pool_manager_->UnpinPage(cur,false);
-    return;
-  }
   for (Page *page : *transaction->GetPageSet()) {
     int curPid = page->GetPageId();
     Unlock(exclusive,page);
-    buffer_pool_manager_->UnpinPage(curPid,exclusive);
+    // pinned by the transaction, no need to look the frame up
+    buffer_pool_manager_->UnpinFrame(page,exclusive);
     if (transaction->GetDeletedPageSet()->find(curPid) != transaction->GetDeletedPageSet()->end()) {
       buffer_pool_manager_->DeletePage(curPid);
       transaction->GetDeletedPageSet()->erase(curPid);
@@ -473,15 +1335,15 @@ void BPLUSTREE_TYPE::FreePagesInTransaction(bool exclusive, Transaction *transac
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = static_cast<HeaderPage *>(
-          buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+  HeaderPage *header_page = static_cast<HeaderPage *>(guard.GetPage());
+  guard.MarkDirty();
   if (insert_record)
     // create a new record<index_name + root_page_id> in header_page
     header_page->InsertRecord(index_name_, root_page_id_);
   else
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
@@ -495,12 +1357,12 @@ std::string BPLUSTREE_TYPE::ToString(bool verbose) {
   }
   std::queue<BPlusTreePage *> todo, tmp;
   std::stringstream tree;
-  auto node = reinterpret_cast<BPlusTreePage *>(
-          buffer_pool_manager_->FetchPage(root_page_id_));
-  if (node == nullptr) {
+  Page *root = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (root == nullptr) {
     throw Exception(EXCEPTION_TYPE_INDEX,
                     "all page are pinned while printing");
   }
+  auto node = reinterpret_cast<BPlusTreePage *>(root->GetData());
   todo.push(node);
   bool first = true;
   while (!todo.empty()) {
@@ -573,16 +1435,17 @@ void BPLUSTREE_TYPE::RemoveFromFile(const std::string &file_name,
 INDEX_TEMPLATE_ARGUMENTS
 int BPLUSTREE_TYPE::isBalanced(page_id_t pid) {
   if (IsEmpty()) return true;
-  auto node = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(pid));
-  if (node == nullptr) {
+  Page *raw = buffer_pool_manager_->FetchPage(pid);
+  if (raw == nullptr) {
     throw Exception(EXCEPTION_TYPE_INDEX,"all page are pinned while isBalanced");
   }
+  auto node = reinterpret_cast<BPlusTreePage *>(raw->GetData());
   int ret = 0;
   if (!node->IsLeafPage())  {
     auto page = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(node);
     int last = -2;
     for (int i = 0; i < page->GetSize(); i++) {
-      int cur = isBalanced(page->ValueAt(i));
+      int cur = isBalanced(ChildPageId(page->ValueAt(i)));
       if (cur >= 0 && last == -2) {
         last = cur;
         ret = last + 1;
@@ -596,41 +1459,60 @@ int BPLUSTREE_TYPE::isBalanced(page_id_t pid) {
   return ret;
 }
 
+/*
+ * Every key below page pid is in [low, high), a null bound being open, keys
+ * are in order, the page links to next with high as its high key, and its
+ * parent page id is parent. In B-link mode pages are not merged, so they may be below min size.
+ */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::isPageCorr(page_id_t pid,pair<KeyType,KeyType> &out) {
+bool BPLUSTREE_TYPE::isPageCorr(page_id_t pid, const KeyType *low,
+                                const KeyType *high, page_id_t next,
+                                page_id_t parent) {
   if (IsEmpty()) return true;
-  auto node = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(pid));
-  if (node == nullptr) {
+  Page *raw = buffer_pool_manager_->FetchPage(pid);
+  if (raw == nullptr) {
     throw Exception(EXCEPTION_TYPE_INDEX,"all page are pinned while isPageCorr");
   }
-  bool ret = true;
+  auto node = reinterpret_cast<BPlusTreePage *>(raw->GetData());
+  int size = node->GetSize();
+  bool ret = (blink_ || size >= node->GetMinSize()) && size <= node->GetMaxSize() &&
+             node->GetParentPageId() == parent;
+  auto inRange = [&](const KeyType &key) {
+    return (low == nullptr || comparator_(*low, key) <= 0) &&
+           (high == nullptr || comparator_(key, *high) < 0);
+  };
   if (node->IsLeafPage())  {
     auto page = reinterpret_cast<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *>(node);
-    int size = page->GetSize();
-    ret = ret && (size >= node->GetMinSize() && size <= node->GetMaxSize());
-    for (int i = 1; i < size; i++) {
-      if (comparator_(page->KeyAt(i-1), page->KeyAt(i)) > 0) {
-        ret = false;
-        break;
-      }
+    ret = ret && page->GetNextPageId() == next &&
+          (high == nullptr || comparator_(page->GetHighKey(), *high) == 0);
+    for (int i = 0; ret && i < size; i++) {
+      ret = inRange(page->KeyAt(i)) &&
+            (i == 0 || comparator_(page->KeyAt(i-1), page->KeyAt(i)) < 0);
     }
-    out = pair<KeyType,KeyType>{page->KeyAt(0),page->KeyAt(size-1)};
   } else {
     auto page = reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
-    int size = page->GetSize();
-    ret = ret && (size >= node->GetMinSize() && size <= node->GetMaxSize());
-    pair<KeyType,KeyType> left,right;
-    for (int i = 1; i < size; i++) {
-      if (i == 1) {
-        ret = ret && isPageCorr(page->ValueAt(0),left);
-      }
-      ret = ret && isPageCorr(page->ValueAt(i),right);
-      ret = ret && (comparator_(page->KeyAt(i) ,left.second)>0 && comparator_(page->KeyAt(i), right.first)<=0);
-      ret = ret && (i == 1 || comparator_(page->KeyAt(i-1) , page->KeyAt(i)) < 0);
-      if (!ret) break;
-      left = right;
+    ret = ret && page->GetNextPageId() == next &&
+          (high == nullptr || comparator_(page->GetHighKey(), *high) == 0);
+    std::vector<KeyType> keys;
+    for (int i = 0; i < size; i++) {
+      keys.push_back(page->KeyAt(i));
+    }
+    for (int i = 1; ret && i < size; i++) {
+      ret = inRange(keys[i]) && (i == 1 || comparator_(keys[i-1], keys[i]) < 0);
+    }
+    // the last child links to the first child of the next page
+    page_id_t lastNext = INVALID_PAGE_ID;
+    if (ret && next != INVALID_PAGE_ID) {
+      auto nextPage = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(FetchPage(next));
+      lastNext = ChildPageId(nextPage->ValueAt(0));
+      buffer_pool_manager_->UnpinPage(next, false);
+    }
+    for (int i = 0; ret && i < size; i++) {
+      bool last = (i == size - 1);
+      ret = isPageCorr(ChildPageId(page->ValueAt(i)), i == 0 ? low : &keys[i],
+                       last ? high : &keys[i+1],
+                       last ? lastNext : ChildPageId(page->ValueAt(i+1)), pid);
     }
-    out = pair<KeyType,KeyType>{page->KeyAt(0),page->KeyAt(size-1)};
   }
   buffer_pool_manager_->UnpinPage(pid,false);
   return ret;
@@ -641,8 +1523,9 @@ bool BPLUSTREE_TYPE::Check(bool forceCheck) {
   if (!forceCheck && !openCheck) {
     return true;
   }
-  pair<KeyType,KeyType> in;
-  bool isPageInOrderAndSizeCorr = isPageCorr(root_page_id_, in);
+  bool isPageInOrderAndSizeCorr =
+          isPageCorr(root_page_id_, nullptr, nullptr, INVALID_PAGE_ID,
+                     INVALID_PAGE_ID);
   bool isBal = (isBalanced(root_page_id_) >= 0);
   bool isAllUnpin = buffer_pool_manager_->CheckAllUnpined();
   if (!isPageInOrderAndSizeCorr) cout<<"problem in page order or page size"<<endl;
@@ -656,4 +1539,6 @@ template class BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTree<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTree<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
+template class BPlusTree<IntegerKey<int32_t>, RID, IntegerComparator<int32_t>>;
+template class BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>>;
 } // namespace cmudb
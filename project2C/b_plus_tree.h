@@ -7,9 +7,35 @@
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ * (5) Every page links to the page right of it on its level and knows its
+ * high key, the first key of that page; a search past the high key of a page
+ * moves right (Lehman and Yao). In B-link mode a split holds the latch of one
+ * page per level at a time, readers never hold two, and a remove leaves pages
+ * as small as they get instead of merging them.
+ * (6) Pages may store only the first key_size bytes of each key, for keys
+ * shorter than KeyType, zero padded; more keys fit a page and the tree gets
+ * shallower and smaller. Every key must have zeros past key_size, and a tree
+ * must always be opened with the key_size it was built with.
+ * (7) When the stored keys are 8 bytes and the comparator orders them as
+ * int64_t values (a single BIGINT column), pages are searched without it.
+ * (8) In B-link mode pages may be compressed: a page stores the prefix its
+ * keys share once and of each key only the bytes after it, up to its last
+ * nonzero byte; a key is rebuilt before it is compared. A leaf split pushes
+ * up the shortest separator, the first key of the new page with its trailing
+ * bytes zeroed, so every key must still order as it did with those bytes
+ * zeroed, as keys of fixed size columns do.
+ * Compression is B-link only: there a page only takes keys by insert, which
+ * splits it first when its layout can not take one more. The crabbing tree
+ * also merges and redistributes pages, moving raw slots into a page with
+ * another prefix, where they may not fit once re-encoded.
+ * A compressed tree does not read optimistically, as a page may change
+ * layout in place under a reader, nor use the integer search of (7), as its
+ * keys are not stored whole.
  */
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <queue>
 #include <vector>
 
@@ -25,10 +51,14 @@ namespace cmudb {
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
 public:
+  // blink: see (5); key_size: see (6); compress: see (8), throws unless blink
+  // is set too
   explicit BPlusTree(const std::string &name,
                      BufferPoolManager *buffer_pool_manager,
                      const KeyComparator &comparator,
-                     page_id_t root_page_id = INVALID_PAGE_ID);
+                     page_id_t root_page_id = INVALID_PAGE_ID,
+                     bool blink = false, int key_size = sizeof(KeyType),
+                     bool compress = false);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
@@ -44,6 +74,18 @@ public:
   bool GetValue(const KeyType &key, std::vector<ValueType> &result,
                 Transaction *transaction = nullptr);
 
+  // Build this B+ tree, which must be empty, bottom up from pairs in
+  // ascending key order; next returns false past the last pair. Pages are
+  // filled to fill_factor of their max size.
+  bool BulkLoad(const std::function<bool(MappingType &)> &next,
+                double fill_factor = 1.0);
+
+  // read keys from file, in any order, and bulk load them; more than run_size
+  // keys are sorted through runs written to disk. false if the file can not
+  // be read whole or run_size is 0
+  bool BulkLoadFromFile(const std::string &file_name, double fill_factor = 1.0,
+                        size_t run_size = 1 << 20);
+
   // index iterator
   INDEXITERATOR_TYPE Begin();
   INDEXITERATOR_TYPE Begin(const KeyType &key);
@@ -69,8 +111,43 @@ public:
 private:
   BPlusTreePage *FetchPage(page_id_t page_id);
 
+  ReadPageGuard FindLeafPageRead(const KeyType &key, bool leftMost);
+
+  ReadPageGuard FindLeafPageOptimistic(const KeyType &key, bool leftMost);
+
+  B_PLUS_TREE_LEAF_PAGE_TYPE *FindLeafPageOptimisticWrite(
+          const KeyType &key, bool leftMost, OpType op,
+          Transaction *transaction);
+
+  page_id_t RightPageId(BPlusTreePage *node, const KeyType &key);
+
+  template <typename Guard>
+  void MoveRight(Guard &guard, const KeyType &key,
+                 Guard (BufferPoolManager::*fetch)(page_id_t));
+
+  ReadPageGuard FindLeafPageBLink(const KeyType &key, bool leftMost);
+
+  WritePageGuard FindLeafPageWriteBLink(const KeyType &key);
+
+  bool InsertBLink(const KeyType &key, const ValueType &value);
+
+  void InsertIntoParentBLink(WritePageGuard &node, const KeyType &key,
+                             WritePageGuard &new_node);
+
+  template <typename N> void SplitBLink(WritePageGuard &node);
+
+  KeyType ShortestSeparator(const KeyType &left, const KeyType &right) const;
+
+  void RemoveBLink(const KeyType &key);
+
+  // throws if key has bytes the pages do not store
+  void CheckKeySize(const KeyType &key) const;
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
+  page_id_t BuildBottomUp(const std::function<bool(MappingType &)> &next,
+                          double fill_factor);
+
   bool InsertIntoLeaf(const KeyType &key, const ValueType &value,
                       Transaction *transaction = nullptr);
 
@@ -100,7 +177,7 @@ private:
 
   BPlusTreePage *CrabingProtocalFetchPage(page_id_t page_id,OpType op, page_id_t previous, Transaction *transaction);
 
-  void FreePagesInTransaction(bool exclusive,  Transaction *transaction, page_id_t cur = -1);
+  void FreePagesInTransaction(bool exclusive,  Transaction *transaction);
 
   inline void Lock(bool exclusive,Page * page) {
     if (exclusive) {
@@ -117,10 +194,12 @@ private:
       page->RUnlatch();
     }
   }
-  inline void Unlock(bool exclusive,page_id_t pageId) {
-    auto page = buffer_pool_manager_->FetchPage(pageId);
-    Unlock(exclusive,page);
-    buffer_pool_manager_->UnpinPage(pageId,exclusive);
+  // page id of a child pointer read from a read latched internal page
+  inline page_id_t ChildPageId(page_id_t child) {
+    if (BufferPoolManager::IsSwizzled(child)) {
+      return buffer_pool_manager_->GetSwizzledPage(child)->GetPageId();
+    }
+    return child;
   }
   inline void LockRootPageId(bool exclusive) {
     if (exclusive) {
@@ -144,12 +223,21 @@ private:
 
 
   int isBalanced(page_id_t pid);
-  bool isPageCorr(page_id_t pid,pair<KeyType,KeyType> &out);
+  bool isPageCorr(page_id_t pid, const KeyType *low, const KeyType *high,
+                  page_id_t next, page_id_t parent);
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  // read without mutex_ by optimistic lookups, see FindLeafPageOptimistic
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
+  const bool blink_;
+  // bytes stored of each key, see (6)
+  const int key_size_;
+  // pages search keys as int64_t values, see CountInt64KeysBelow
+  const bool integer_keys_;
+  // pages are prefix compressed, see (8)
+  const bool compress_;
   RWMutex mutex_;
   static thread_local int rootLockedCnt;
 
@@ -1,8 +1,10 @@
 /**
  * b_plus_tree_internal_page.cpp
  */
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include "common/exception.h"
 #include "page/b_plus_tree_internal_page.h"
@@ -15,31 +17,252 @@ namespace cmudb {
  * Init method after creating a new internal page
  * Including set page type, set current size, set page id, set parent id and set
  * max page size
+ * A compressed page starts with the layout of an uncompressed one, see
+ * BPlusTreeLeafPage::Init
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
-                                          page_id_t parent_id) {
+                                          page_id_t parent_id, int key_size,
+                                          bool integer_keys, bool compressed) {
   SetPageType(IndexPageType::INTERNAL_PAGE);
   SetSize(0);
+  assert(key_size > 0 && key_size <= static_cast<int>(sizeof(KeyType)));
+  assert(!integer_keys || key_size == static_cast<int>(sizeof(int64_t)));
+  assert(!integer_keys || !compressed);
   SetPageId(page_id);
   SetParentPageId(parent_id);
-  SetMaxSize((PAGE_SIZE- sizeof(BPlusTreeInternalPage))/sizeof(MappingType) - 1); //minus 1 for first invalid key
+  SetNextPageId(INVALID_PAGE_ID);
+  key_size_ = static_cast<int16_t>(key_size);
+  integer_keys_ = integer_keys;
+  compressed_ = compressed;
+  prefix_size_ = 0;
+  key_width_ = key_size_;
+  SetMaxSize(MaxSizeFor(key_size));
 }
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::MaxSizeFor(int key_size) {
+  return MaxSizeForLayout(0, key_size);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::MaxSizeForLayout(int prefix_size,
+                                                     int key_width) {
+  return (PAGE_SIZE- sizeof(BPlusTreeInternalPage) - KeyStrideFor(prefix_size))/
+         (KeyStrideFor(key_width - prefix_size) + sizeof(ValueType)) - 1; //minus 1 for first invalid key
+}
+
+/*
+ * The stored bytes of a key, padded so that the page ids after the keys are
+ * aligned for ValuePointerAt
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyStrideFor(int key_size) {
+  const int align = alignof(ValueType);
+  return (key_size + align - 1) / align * align;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetItemAt(int index, const KeyType &key,
+                                               const ValueType &value) {
+  assert(Fits(key));
+  memcpy(KeySlotAt(index), reinterpret_cast<const char *>(&key) + prefix_size_,
+         key_width_ - prefix_size_);
+  *ValueSlotAt(index) = value;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveItems(BPlusTreeInternalPage *to,
+                                               int to_index, int index,
+                                               int count) {
+  assert(to->prefix_size_ == prefix_size_ && to->key_width_ == key_width_ &&
+         to->GetMaxSize() == GetMaxSize());
+  memmove(to->KeySlotAt(to_index), KeySlotAt(index),
+          static_cast<size_t>(count * KeyStride()));
+  memmove(to->ValueSlotAt(to_index), ValueSlotAt(index),
+          static_cast<size_t>(count) * sizeof(ValueType));
+}
+
+/*
+ * The key stored at index, see BPlusTreeLeafPage::ReadKey. Not checked
+ * against the size, which a torn optimistic read may see changing.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::ReadKey(int index, KeyType *key) const {
+  char *bytes = reinterpret_cast<char *>(key);
+  memcpy(bytes, array, prefix_size_);
+  memcpy(bytes + prefix_size_, KeySlotAt(index), key_width_ - prefix_size_);
+  memset(bytes + key_width_, 0, sizeof(KeyType) - key_width_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::Fits(const KeyType &key) const {
+  const char *bytes = reinterpret_cast<const char *>(&key);
+  return SignificantSize(bytes, key_size_) <= key_width_ &&
+         memcmp(bytes, array, prefix_size_) == 0;
+}
+
+/*
+ * The smallest layout of the keys of the page, but the first one, and key,
+ * see BPlusTreeLeafPage::LayoutFor
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::LayoutFor(const KeyType *key,
+                                              int *prefix_size,
+                                              int *key_width) const {
+  KeyType first, stored;
+  int prefix = key_size_, width = 0;
+  auto add = [&](const KeyType &k) {
+    const char *bytes = reinterpret_cast<const char *>(&k);
+    prefix = CommonPrefixSize(reinterpret_cast<const char *>(&first), bytes,
+                              prefix);
+    width = std::max(width, SignificantSize(bytes, key_size_));
+  };
+  if (key != nullptr) {
+    first = *key;
+    add(*key);
+  } else if (GetSize() > 1) {
+    ReadKey(1, &first);
+  }
+  for (int i = 1; i < GetSize(); i++) {
+    ReadKey(i, &stored);
+    add(stored);
+  }
+  prefix = std::min(prefix, width);
+  if (MaxSizeForLayout(prefix, width) <= MaxSizeForLayout(0, width)) {
+    prefix = 0;
+  }
+  *prefix_size = prefix;
+  *key_width = width;
+  return MaxSizeForLayout(prefix, width);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Relayout(int prefix_size, int key_width,
+                                              int max_size,
+                                              const KeyType &prefix_key) {
+  assert(GetSize() <= max_size + 1);
+  std::vector<MappingType> items;
+  items.reserve(GetSize());
+  for (int i = 0; i < GetSize(); i++) {
+    items.push_back(MappingType{KeyAt(i), ValueAt(i)});
+  }
+  prefix_size_ = static_cast<int16_t>(prefix_size);
+  key_width_ = static_cast<int16_t>(key_width);
+  SetMaxSize(max_size);
+  memcpy(array, &prefix_key, prefix_size_);
+  if (GetSize() > 0) {
+    memset(KeySlotAt(0), 0, KeyStride());
+    *ValueSlotAt(0) = items[0].second;
+  }
+  for (int i = 1; i < GetSize(); i++) {
+    SetItemAt(i, items[i].first, items[i].second);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::Admits(const KeyType &key) const {
+  if (!compressed_ || Fits(key)) {
+    return true;
+  }
+  int prefix, width;
+  return GetSize() + 1 <= LayoutFor(&key, &prefix, &width) + 1;
+}
+
+/*
+ * Whether key goes in, with extra more keys, switching to the layout it needs
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::AdmitKey(const KeyType &key, int extra) {
+  if (!compressed_ || Fits(key)) {
+    return true;
+  }
+  int prefix, width;
+  int max = LayoutFor(&key, &prefix, &width);
+  if (GetSize() + extra > max + 1) {
+    return false;
+  }
+  Relayout(prefix, width, max, key);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Compact() {
+  int prefix, width;
+  int max = LayoutFor(nullptr, &prefix, &width);
+  KeyType prefix_key;
+  if (GetSize() > 1) {
+    ReadKey(1, &prefix_key);
+  }
+  Relayout(prefix, width, max, prefix_key);
+}
+
+/*
+ * Helper methods to set/get next page id and high key, the high key is valid
+ * while there is a next page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetNextPageId() const {
+  return next_page_id_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
+  next_page_id_ = next_page_id;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetHighKey() const { return high_key_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetHighKey(const KeyType &high_key) {
+  high_key_ = high_key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsPastHighKey(
+    const KeyType &key, const KeyComparator &comparator) const {
+  return next_page_id_ != INVALID_PAGE_ID && comparator(key, high_key_) >= 0;
+}
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetKeySize() const { return key_size_; }
+
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
   assert(index >= 0 && index < GetSize());
-  return array[index].first;
+  if (InPlace()) {
+    return *reinterpret_cast<const KeyType *>(KeySlotAt(index));
+  }
+  KeyType key;
+  ReadKey(index, &key);
+  return key;
+}
+
+/*
+ * Not checked against the size either, see ReadKey
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::CompareAt(
+    int index, const KeyType &key, const KeyComparator &comparator) const {
+  if (InPlace()) {
+    return comparator(*reinterpret_cast<const KeyType *>(KeySlotAt(index)),
+                      key);
+  }
+  KeyType stored;
+  ReadKey(index, &stored);
+  return comparator(stored, key);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
   assert(index >= 0 && index < GetSize());
-  array[index].first = key;
+  assert(Fits(key));
+  memcpy(KeySlotAt(index), reinterpret_cast<const char *>(&key) + prefix_size_,
+         key_width_ - prefix_size_);
 }
 
 /*
@@ -62,7 +285,12 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const {
   assert(index >= 0 && index < GetSize());
-  return array[index].second;
+  return *ValueSlotAt(index);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+ValueType *B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValuePointerAt(int index) {
+  return ValueSlotAt(index);
 }
 
 /*****************************************************************************
@@ -77,14 +305,29 @@ INDEX_TEMPLATE_ARGUMENTS
 ValueType
 B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
                                        const KeyComparator &comparator) const {
+  return ValueAt(LookupIndex(key, comparator));
+}
+
+/*
+ * Same as Lookup, but return the index of the child pointer
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookupIndex(
+        const KeyType &key, const KeyComparator &comparator) const {
   assert(GetSize() > 1);
+  if (integer_keys_) {
+    // the keys not above key, but the first one which is invalid
+    int64_t value;
+    memcpy(&value, &key, sizeof(int64_t));
+    return CountInt64KeysBelow(KeySlotAt(1), GetSize() - 1, value, true);
+  }
   int st = 1, ed = GetSize() - 1;
   while (st <= ed) { //find the last key in array <= input
     int mid = (ed - st) / 2 + st;
-    if (comparator(array[mid].first,key) <= 0) st = mid + 1;
+    if (CompareAt(mid, key, comparator) <= 0) st = mid + 1;
     else ed = mid - 1;
   }
-  return array[st - 1].second;
+  return st - 1;
 }
 
 /*****************************************************************************
@@ -100,11 +343,9 @@ INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(
     const ValueType &old_value, const KeyType &new_key,
     const ValueType &new_value) {
-  array[0].second = old_value;
-  array[1].first = new_key;
-  array[1].second = new_value;
-
   SetSize(2);
+  *ValuePointerAt(0) = old_value;
+  SetItemAt(1, new_key, new_value);
 
 }
 /*
@@ -118,14 +359,14 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(
     const ValueType &new_value) {
   int idx = ValueIndex(old_value) + 1;
   assert(idx > 0);
+  // a new layout is written while the slots hold the keys of the page only
+  const bool admitted = AdmitKey(new_key, 1);
+  assert(admitted);
+  (void)admitted;
   IncreaseSize(1);
   int curSize = GetSize();
-  for (int i = curSize - 1; i > idx; i--) {
-    array[i].first = array[i - 1].first;
-    array[i].second = array[i - 1].second;
-  }
-  array[idx].first = new_key;
-  array[idx].second = new_value;
+  MoveItems(this, idx + 1, idx, curSize - 1 - idx);
+  SetItemAt(idx, new_key, new_value);
   return curSize;
 }
 
@@ -134,29 +375,54 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(
  *****************************************************************************/
 /*
  * Remove half of key & value pairs from this page to "recipient" page
+ * The moved children are not latched. Without B-link, a writer holding one
+ * of them released this page only because the child will not split or merge,
+ * so it never reads the parent page id. In B-link
+ * mode a child being split is latched by its writer, which then latches its
+ * parent: latching the child here, under the parent latch, could deadlock
+ * with it. The parent page id is only a hint there, a writer which read the
+ * old one latches this page and moves right to the recipient.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(
     BPlusTreeInternalPage *recipient,
     BufferPoolManager *buffer_pool_manager) {
   assert(recipient != nullptr);
-  int total = GetMaxSize() + 1;
-  assert(GetSize() == total);
+  // a new page, nothing stored with another key layout yet
+  recipient->key_size_ = key_size_;
+  recipient->integer_keys_ = integer_keys_;
+  recipient->compressed_ = compressed_;
+  recipient->prefix_size_ = prefix_size_;
+  recipient->key_width_ = key_width_;
+  memcpy(recipient->array, array, prefix_size_);
+  recipient->SetMaxSize(GetMaxSize());
+  // a compressed page also splits when a key does not fit its layout
+  int total = GetSize();
+  assert(total >= 2 && (compressed_ || total == GetMaxSize() + 1));
   //copy last half
   int copyIdx = (total)/2;//max:4 x,1,2,3,4 -> 2,3,4
   page_id_t recipPageId = recipient->GetPageId();
+  MoveItems(recipient, 0, copyIdx, total - copyIdx);
   for (int i = copyIdx; i < total; i++) {
-    recipient->array[i - copyIdx].first = array[i].first;
-    recipient->array[i - copyIdx].second = array[i].second;
     //update children's parent page
-    auto childRawPage = buffer_pool_manager->FetchPage(array[i].second);
+    auto childRawPage = buffer_pool_manager->FetchPage(ValueAt(i));
     BPlusTreePage *childTreePage = reinterpret_cast<BPlusTreePage *>(childRawPage->GetData());
     childTreePage->SetParentPageId(recipPageId);
-    buffer_pool_manager->UnpinPage(array[i].second,true);
+    buffer_pool_manager->UnpinPage(ValueAt(i),true);
   }
+  //set pointer, the key pushed up bounds this page
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(high_key_);
+  SetNextPageId(recipPageId);
+  SetHighKey(KeyAt(copyIdx));
   //set size,is odd, bigger is last part
   SetSize(copyIdx);
   recipient->SetSize(total - copyIdx);
+  if (compressed_) {
+    // the first key of recipient is left out too, the high key of this page
+    Compact();
+    recipient->Compact();
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -174,9 +440,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyHalfFrom(
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
   assert(index >= 0 && index < GetSize());
-  for (int i = index + 1; i < GetSize(); i++) {
-    array[i - 1] = array[i];
-  }
+  MoveItems(this, index, index + 1, GetSize() - index - 1);
   IncreaseSize(-1);
 }
 
@@ -212,15 +476,16 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(
   // the separation key from parent
   SetKeyAt(0, parent->KeyAt(index_in_parent));
   buffer_pool_manager->UnpinPage(parent->GetPageId(), false);
+  MoveItems(recipient, start, 0, GetSize());
   for (int i = 0; i < GetSize(); ++i) {
-    recipient->array[start + i].first = array[i].first;
-    recipient->array[start + i].second = array[i].second;
     //update children's parent page
-    auto childRawPage = buffer_pool_manager->FetchPage(array[i].second);
+    auto childRawPage = buffer_pool_manager->FetchPage(ValueAt(i));
     BPlusTreePage *childTreePage = reinterpret_cast<BPlusTreePage *>(childRawPage->GetData());
     childTreePage->SetParentPageId(recipPageId);
-    buffer_pool_manager->UnpinPage(array[i].second,true);
+    buffer_pool_manager->UnpinPage(ValueAt(i),true);
   }
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(high_key_);
   //update relavent key & value pair in its parent page.
   recipient->SetSize(start + GetSize());
   assert(recipient->GetSize() <= GetMaxSize());
@@ -246,8 +511,9 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(
     BufferPoolManager *buffer_pool_manager) {
   MappingType pair{KeyAt(0), ValueAt(0)};
   IncreaseSize(-1);
-  memmove(array, array + 1, static_cast<size_t>(GetSize()*sizeof(MappingType)));
+  MoveItems(this, 0, 1, GetSize());
   recipient->CopyLastFrom(pair, buffer_pool_manager);
+  recipient->SetHighKey(KeyAt(0));
   // update child parent page id
   page_id_t childPageId = pair.second;
   Page *page = buffer_pool_manager->FetchPage(childPageId);
@@ -259,7 +525,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(
   //update relavent key & value pair in its parent page.
   page = buffer_pool_manager->FetchPage(GetParentPageId());
   B_PLUS_TREE_INTERNAL_PAGE *parent = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(page->GetData());
-  parent->SetKeyAt(parent->ValueIndex(GetPageId()), array[0].first);
+  parent->SetKeyAt(parent->ValueIndex(GetPageId()), KeyAt(0));
   buffer_pool_manager->UnpinPage(GetParentPageId(), true);
 }
 
@@ -267,7 +533,7 @@ INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(
     const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
   assert(GetSize() + 1 <= GetMaxSize());
-  array[GetSize()] = pair;
+  SetItemAt(GetSize(), pair.first, pair.second);
   IncreaseSize(1);
 }
 
@@ -282,6 +548,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(
   MappingType pair {KeyAt(GetSize() - 1),ValueAt(GetSize() - 1)};
   IncreaseSize(-1);
   recipient->CopyFirstFrom(pair, parent_index, buffer_pool_manager);
+  SetHighKey(pair.first);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -289,9 +556,9 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(
     const MappingType &pair, int parent_index,
     BufferPoolManager *buffer_pool_manager) {
   assert(GetSize() + 1 < GetMaxSize());
-  memmove(array + 1, array, GetSize()*sizeof(MappingType));
+  MoveItems(this, 1, 0, GetSize());
   IncreaseSize(1);
-  array[0] = pair;
+  SetItemAt(0, pair.first, pair.second);
   // update child parent page id
   page_id_t childPageId = pair.second;
   Page *page = buffer_pool_manager->FetchPage(childPageId);
@@ -303,7 +570,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(
   //update relavent key & value pair in its parent page.
   page = buffer_pool_manager->FetchPage(GetParentPageId());
   B_PLUS_TREE_INTERNAL_PAGE *parent = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(page->GetData());
-  parent->SetKeyAt(parent_index, array[0].first);
+  parent->SetKeyAt(parent_index, pair.first);
   buffer_pool_manager->UnpinPage(GetParentPageId(), true);
 }
 
@@ -315,7 +582,11 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::QueueUpChildren(
     std::queue<BPlusTreePage *> *queue,
     BufferPoolManager *buffer_pool_manager) {
   for (int i = 0; i < GetSize(); i++) {
-    auto *page = buffer_pool_manager->FetchPage(array[i].second);
+    page_id_t child = ValueAt(i);
+    if (BufferPoolManager::IsSwizzled(child)) {
+      child = buffer_pool_manager->GetSwizzledPage(child)->GetPageId();
+    }
+    auto *page = buffer_pool_manager->FetchPage(child);
     if (page == nullptr)
       throw Exception(EXCEPTION_TYPE_INDEX,
                       "all page are pinned while printing");
@@ -345,9 +616,9 @@ std::string B_PLUS_TREE_INTERNAL_PAGE_TYPE::ToString(bool verbose) const {
     } else {
       os << " ";
     }
-    os << std::dec << array[entry].first.ToString();
+    os << std::dec << KeyAt(entry).ToString();
     if (verbose) {
-      os << "(" << array[entry].second << ")";
+      os << "(" << ValueAt(entry) << ")";
     }
     ++entry;
   }
@@ -365,4 +636,8 @@ template class BPlusTreeInternalPage<GenericKey<32>, page_id_t,
                                            GenericComparator<32>>;
 template class BPlusTreeInternalPage<GenericKey<64>, page_id_t,
                                            GenericComparator<64>>;
+template class BPlusTreeInternalPage<IntegerKey<int32_t>, page_id_t,
+                                           IntegerComparator<int32_t>>;
+template class BPlusTreeInternalPage<IntegerKey<int64_t>, page_id_t,
+                                           IntegerComparator<int64_t>>;
 } // namespace cmudb
@@ -8,16 +8,25 @@
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
- * Internal page format (keys are stored in increasing order):
+ * Internal page format (keys are stored in increasing order, then the page
+ * ids, as in a leaf page):
  *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
+ * | HEADER | KEY(1) | ... | KEY(n) | ... | PAGE_ID(1) | ... | PAGE_ID(n) |
  *  --------------------------------------------------------------------------
+ * HEADER is the one of every B+ tree page followed, as in a leaf page, by
+ * NextPageId (4), the page right of this one on its level, KeySize (2), the
+ * bytes stored of each key, IntegerKeys (1), Compressed (1), Prefix (2),
+ * KeyWidth (2), and HighKey, the first key of that page and the bound of
+ * every key below this page.
+ * A compressed page stores its keys as a compressed leaf page does, the
+ * first key left out: it is zero but for the prefix.
  */
 
 #pragma once
 
 #include <queue>
 
+#include "index/b_plus_tree_key_search.h"
 #include "page/b_plus_tree_page.h"
 
 namespace cmudb {
@@ -31,14 +40,34 @@ INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
 public:
   // must call initialize method after "create" a new node
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID,
+            int key_size = sizeof(KeyType), bool integer_keys = false,
+            bool compressed = false);
+  // max size of an internal page storing key_size bytes of every key
+  static int MaxSizeFor(int key_size);
+  // key can be inserted without a split first, see BPlusTree::InsertBLink
+  bool Admits(const KeyType &key) const;
 
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+  KeyType GetHighKey() const;
+  void SetHighKey(const KeyType &high_key);
+  // key belongs to a page right of this one, see BPlusTree::MoveRight
+  bool IsPastHighKey(const KeyType &key, const KeyComparator &comparator) const;
+
+  int GetKeySize() const;
   KeyType KeyAt(int index) const;
+  // comparator(KeyAt(index), key), on the stored key in place if it can
+  int CompareAt(int index, const KeyType &key,
+                const KeyComparator &comparator) const;
   void SetKeyAt(int index, const KeyType &key);
   int ValueIndex(const ValueType &value) const;
   ValueType ValueAt(int index) const;
 
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
+  int LookupIndex(const KeyType &key, const KeyComparator &comparator) const;
+  // the child pointer in place, see BufferPoolManager::Swizzle
+  ValueType *ValuePointerAt(int index);
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
                        const ValueType &new_value);
   int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
@@ -69,6 +98,49 @@ private:
                     BufferPoolManager *buffer_pool_manager);
   void CopyFirstFrom(const MappingType &pair, int parent_index,
                      BufferPoolManager *buffer_pool_manager);
-  MappingType array[0];
+  static int KeyStrideFor(int key_size);
+  static int MaxSizeForLayout(int prefix_size, int key_width);
+  int PrefixSpace() const { return KeyStrideFor(prefix_size_); }
+  int KeyStride() const { return KeyStrideFor(key_width_ - prefix_size_); }
+  char *KeySlotAt(int index) {
+    return array + PrefixSpace() + index * KeyStride();
+  }
+  const char *KeySlotAt(int index) const {
+    return array + PrefixSpace() + index * KeyStride();
+  }
+  // the page ids start after room for MaxSize + 1 keys
+  const ValueType *ValueSlotAt(int index) const {
+    return reinterpret_cast<const ValueType *>(
+            array + PrefixSpace() + (GetMaxSize() + 1) * KeyStride()) + index;
+  }
+  ValueType *ValueSlotAt(int index) {
+    return const_cast<ValueType *>(
+            static_cast<const BPlusTreeInternalPage *>(this)->ValueSlotAt(index));
+  }
+  // the stored keys are whole KeyType values
+  bool InPlace() const {
+    return alignof(KeyType) == 1 && prefix_size_ == 0 &&
+           key_width_ == static_cast<int>(sizeof(KeyType));
+  }
+  void ReadKey(int index, KeyType *key) const;
+  bool Fits(const KeyType &key) const;
+  int LayoutFor(const KeyType *key, int *prefix_size, int *key_width) const;
+  bool AdmitKey(const KeyType &key, int extra);
+  void Relayout(int prefix_size, int key_width, int max_size,
+                const KeyType &prefix_key);
+  // the smallest layout of the keys stored, after a split
+  void Compact();
+  void SetItemAt(int index, const KeyType &key, const ValueType &value);
+  // move count pairs from index on to to_index of page to, which may be this
+  void MoveItems(BPlusTreeInternalPage *to, int to_index, int index, int count);
+  page_id_t next_page_id_;
+  int16_t key_size_;
+  int8_t integer_keys_;
+  int8_t compressed_;
+  int16_t prefix_size_;
+  int16_t key_width_;
+  KeyType high_key_;
+  // the prefix, the keys past it up to key_width_, then the page ids
+  char array[0];
 };
 } // namespace cmudb
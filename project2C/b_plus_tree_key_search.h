@@ -0,0 +1,92 @@
+/**
+ * b_plus_tree_key_search.h
+ *
+ * Search of B+ tree pages whose keys are plain int64_t values: the keys of a
+ * page are stored one after the other (see BPlusTreeLeafPage), so a few cache
+ * lines of them are compared at once with AVX2 instead of calling the key
+ * comparator, which deserializes both keys through the schema, per probe.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace cmudb {
+
+// keys left once the binary search stops, four cache lines of int64_t
+static const int INT64_SEARCH_WINDOW = 32;
+
+/*
+ * Number of the n keys stored at keys, ascending, that are below key, or not
+ * above it with or_equal: the index of the first key >= key (> key).
+ */
+inline int CountInt64KeysBelow(const char *keys, int n, int64_t key,
+                               bool or_equal) {
+  auto below = [&](int index) {
+    int64_t stored;
+    memcpy(&stored, keys + index * sizeof(int64_t), sizeof(int64_t));
+    return stored < key || (or_equal && stored == key);
+  };
+  int st = 0, ed = n;
+  while (ed - st > INT64_SEARCH_WINDOW) {
+    int mid = (ed - st) / 2 + st;
+    if (below(mid)) st = mid + 1;
+    else ed = mid;
+  }
+  int count = st;
+#ifdef __AVX2__
+  const __m256i bound = _mm256_set1_epi64x(key);
+  for (; st + 4 <= ed; st += 4) {
+    __m256i stored = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(keys + st * sizeof(int64_t)));
+    // lanes of keys above key when or_equal, below it otherwise
+    __m256i mask = or_equal ? _mm256_cmpgt_epi64(stored, bound)
+                            : _mm256_cmpgt_epi64(bound, stored);
+    int lanes = __builtin_popcount(
+            _mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+    count += or_equal ? 4 - lanes : lanes;
+  }
+#endif
+  for (; st < ed; st++) {
+    count += below(st);
+  }
+  return count;
+}
+
+/*
+ * Whether comparator orders keys holding an int64_t in their first 8 bytes,
+ * zero after, as the int64_t values, tried on values around the byte and sign
+ * boundaries. True for a GenericComparator over a single BIGINT column.
+ * INT64_MIN is left out, the type system reads it as NULL.
+ */
+template <typename KeyType, typename KeyComparator>
+bool OrdersAsInt64(const KeyComparator &comparator) {
+  if (sizeof(KeyType) < sizeof(int64_t)) {
+    return false;
+  }
+  static const int64_t probes[] = {
+          std::numeric_limits<int64_t>::min() + 1, -(int64_t(1) << 40),
+          -(int64_t(1) << 32), -65536, -257, -256, -1, 0, 1, 2, 255, 256,
+          65535, int64_t(1) << 31, int64_t(1) << 32, (int64_t(1) << 40) + 1,
+          std::numeric_limits<int64_t>::max()};
+  KeyType lhs, rhs;
+  memset(&lhs, 0, sizeof(KeyType));
+  memset(&rhs, 0, sizeof(KeyType));
+  for (int64_t a : probes) {
+    for (int64_t b : probes) {
+      memcpy(&lhs, &a, sizeof(int64_t));
+      memcpy(&rhs, &b, sizeof(int64_t));
+      int cmp = comparator(lhs, rhs);
+      if ((cmp < 0) != (a < b) || (cmp > 0) != (a > b)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace cmudb
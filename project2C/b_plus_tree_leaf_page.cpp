@@ -2,6 +2,7 @@
  * b_plus_tree_leaf_page.cpp
  */
 
+#include <algorithm>
 #include <sstream>
 #include <include/page/b_plus_tree_internal_page.h>
 
@@ -19,16 +20,196 @@ namespace cmudb {
  * Init method after creating a new leaf page
  * Including set page type, set current size to zero, set page id/parent id, set
  * next page id and set max size
+ * A compressed page starts with the layout of an uncompressed one and gets
+ * its smallest one when it splits, see Compact
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id,
+                                      int key_size, bool integer_keys,
+                                      bool compressed) {
   SetPageType(IndexPageType::LEAF_PAGE);
   SetSize(0);
-  assert(sizeof(BPlusTreeLeafPage) == 28);
+  assert(sizeof(BPlusTreeLeafPage) == 36 + sizeof(KeyType));
+  assert(key_size > 0 && key_size <= static_cast<int>(sizeof(KeyType)));
+  assert(!integer_keys || key_size == static_cast<int>(sizeof(int64_t)));
+  assert(!integer_keys || !compressed);
   SetPageId(page_id);
   SetParentPageId(parent_id);
   SetNextPageId(INVALID_PAGE_ID);
-  SetMaxSize((PAGE_SIZE - sizeof(BPlusTreeLeafPage))/sizeof(MappingType) - 1); //minus 1 for insert first then split
+  key_size_ = static_cast<int16_t>(key_size);
+  integer_keys_ = integer_keys;
+  compressed_ = compressed;
+  prefix_size_ = 0;
+  key_width_ = key_size_;
+  SetMaxSize(MaxSizeFor(key_size));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::MaxSizeFor(int key_size) {
+  return MaxSizeForLayout(0, key_size);
+}
+
+/*
+ * Max size with prefix_size bytes stored once and the next ones up to
+ * key_width stored of every key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::MaxSizeForLayout(int prefix_size,
+                                                 int key_width) {
+  return (PAGE_SIZE - sizeof(BPlusTreeLeafPage) - KeyStrideFor(prefix_size))/
+         (KeyStrideFor(key_width - prefix_size) + sizeof(ValueType)) - 1; //minus 1 for insert first then split
+}
+
+/*
+ * The stored bytes of a key, padded so that the values after the keys are
+ * aligned
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyStrideFor(int key_size) {
+  const int align = alignof(ValueType);
+  return (key_size + align - 1) / align * align;
+}
+
+/*
+ * Store key & value at index, but the bytes of key in the prefix or after
+ * key_width_
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetItemAt(int index, const KeyType &key,
+                                           const ValueType &value) {
+  assert(Fits(key));
+  memcpy(KeySlotAt(index), reinterpret_cast<const char *>(&key) + prefix_size_,
+         key_width_ - prefix_size_);
+  memcpy(ValueSlotAt(index), &value, sizeof(ValueType));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveItems(BPlusTreeLeafPage *to, int to_index,
+                                           int index, int count) {
+  assert(to->prefix_size_ == prefix_size_ && to->key_width_ == key_width_ &&
+         to->GetMaxSize() == GetMaxSize());
+  memmove(to->KeySlotAt(to_index), KeySlotAt(index),
+          static_cast<size_t>(count * KeyStride()));
+  memmove(to->ValueSlotAt(to_index), ValueSlotAt(index),
+          static_cast<size_t>(count) * sizeof(ValueType));
+}
+
+/*
+ * The key stored at index, its prefix, the bytes after it up to key_width_,
+ * then zeros
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::ReadKey(int index, KeyType *key) const {
+  char *bytes = reinterpret_cast<char *>(key);
+  memcpy(bytes, array, prefix_size_);
+  memcpy(bytes + prefix_size_, KeySlotAt(index), key_width_ - prefix_size_);
+  memset(bytes + key_width_, 0, sizeof(KeyType) - key_width_);
+}
+
+/*
+ * key has the prefix of the page and no byte past key_width_
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::Fits(const KeyType &key) const {
+  const char *bytes = reinterpret_cast<const char *>(&key);
+  return SignificantSize(bytes, key_size_) <= key_width_ &&
+         memcmp(bytes, array, prefix_size_) == 0;
+}
+
+/*
+ * The smallest layout of the keys of the page and key, if not null: the
+ * prefix they share, unless it makes no room for more keys, and the width
+ * of the longest one.
+ * @return: the max size of the page with that layout
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::LayoutFor(const KeyType *key, int *prefix_size,
+                                          int *key_width) const {
+  KeyType first, stored;
+  int prefix = key_size_, width = 0;
+  auto add = [&](const KeyType &k) {
+    const char *bytes = reinterpret_cast<const char *>(&k);
+    prefix = CommonPrefixSize(reinterpret_cast<const char *>(&first), bytes,
+                              prefix);
+    width = std::max(width, SignificantSize(bytes, key_size_));
+  };
+  if (key != nullptr) {
+    first = *key;
+    add(*key);
+  } else if (GetSize() > 0) {
+    ReadKey(0, &first);
+  }
+  for (int i = 0; i < GetSize(); i++) {
+    ReadKey(i, &stored);
+    add(stored);
+  }
+  prefix = std::min(prefix, width);
+  if (MaxSizeForLayout(prefix, width) <= MaxSizeForLayout(0, width)) {
+    prefix = 0;
+  }
+  *prefix_size = prefix;
+  *key_width = width;
+  return MaxSizeForLayout(prefix, width);
+}
+
+/*
+ * Rewrite the page with another layout, prefix_key holding the prefix
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Relayout(int prefix_size, int key_width,
+                                          int max_size,
+                                          const KeyType &prefix_key) {
+  assert(GetSize() <= max_size + 1);
+  std::vector<MappingType> items;
+  items.reserve(GetSize());
+  for (int i = 0; i < GetSize(); i++) {
+    items.push_back(GetItem(i));
+  }
+  prefix_size_ = static_cast<int16_t>(prefix_size);
+  key_width_ = static_cast<int16_t>(key_width);
+  SetMaxSize(max_size);
+  memcpy(array, &prefix_key, prefix_size_);
+  for (int i = 0; i < GetSize(); i++) {
+    SetItemAt(i, items[i].first, items[i].second);
+  }
+}
+
+/*
+ * Whether key goes in without a split: it fits the layout, or another one
+ * with room for one more key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::Admits(const KeyType &key) const {
+  if (!compressed_ || Fits(key)) {
+    return true;
+  }
+  int prefix, width;
+  return GetSize() + 1 <= LayoutFor(&key, &prefix, &width) + 1;
+}
+
+/*
+ * Same as Admits, switching to the layout key needs
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::AdmitKey(const KeyType &key) {
+  if (!compressed_ || Fits(key)) {
+    return true;
+  }
+  int prefix, width;
+  int max = LayoutFor(&key, &prefix, &width);
+  if (GetSize() + 1 > max + 1) {
+    return false;
+  }
+  Relayout(prefix, width, max, key);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Compact() {
+  assert(GetSize() > 0);
+  int prefix, width;
+  int max = LayoutFor(nullptr, &prefix, &width);
+  Relayout(prefix, width, max, KeyAt(0));
 }
 
 /**
@@ -42,6 +223,23 @@ page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const {
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {next_page_id_ = next_page_id;}
 
+/**
+ * Helper methods to set/get high key, valid while there is a next page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::GetHighKey() const { return high_key_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetHighKey(const KeyType &high_key) {
+  high_key_ = high_key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsPastHighKey(
+    const KeyType &key, const KeyComparator &comparator) const {
+  return next_page_id_ != INVALID_PAGE_ID && comparator(key, high_key_) >= 0;
+}
+
 /**
  * Helper method to find the first index i so that array[i].first >= key
  * NOTE: This method is only used when generating index iterator
@@ -50,10 +248,15 @@ INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(
     const KeyType &key, const KeyComparator &comparator) const {
   assert(GetSize() >= 0);
+  if (integer_keys_) {
+    int64_t value;
+    memcpy(&value, &key, sizeof(int64_t));
+    return CountInt64KeysBelow(KeySlotAt(0), GetSize(), value, false);
+  }
   int st = 0, ed = GetSize() - 1;
   while (st <= ed) { //find the last key in array <= input
     int mid = (ed - st) / 2 + st;
-    if (comparator(array[mid].first,key) >= 0) ed = mid - 1;
+    if (CompareAt(mid, key, comparator) >= 0) ed = mid - 1;
     else st = mid + 1;
   }
   return ed + 1;
@@ -66,7 +269,32 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
   assert(index >= 0 && index < GetSize());
-  return array[index].first;
+  if (InPlace()) {
+    return *reinterpret_cast<const KeyType *>(KeySlotAt(index));
+  }
+  KeyType key;
+  ReadKey(index, &key);
+  return key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::CompareAt(
+    int index, const KeyType &key, const KeyComparator &comparator) const {
+  if (InPlace()) {
+    return comparator(*reinterpret_cast<const KeyType *>(KeySlotAt(index)),
+                      key);
+  }
+  KeyType stored;
+  ReadKey(index, &stored);
+  return comparator(stored, key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const {
+  assert(index >= 0 && index < GetSize());
+  ValueType value;
+  memcpy(&value, ValueSlotAt(index), sizeof(ValueType));
+  return value;
 }
 
 /*
@@ -74,9 +302,8 @@ KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
  * "index"(a.k.a array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
-  assert(index >= 0 && index < GetSize());
-  return array[index];
+MappingType B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const {
+  return MappingType(KeyAt(index), ValueAt(index));
 }
 
 /*****************************************************************************
@@ -92,14 +319,14 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key,
                                        const KeyComparator &comparator) {
   int idx = KeyIndex(key,comparator); //first larger than key
   assert(idx >= 0);
+  // a new layout is written while the slots hold the keys of the page only
+  const bool admitted = AdmitKey(key);
+  assert(admitted);
+  (void)admitted;
   IncreaseSize(1);
   int curSize = GetSize();
-  for (int i = curSize - 1; i > idx; i--) {
-    array[i].first = array[i - 1].first;
-    array[i].second = array[i - 1].second;
-  }
-  array[idx].first = key;
-  array[idx].second = value;
+  MoveItems(this, idx + 1, idx, curSize - 1 - idx);
+  SetItemAt(idx, key, value);
   return curSize;
 }
 
@@ -114,21 +341,32 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(
     BPlusTreeLeafPage *recipient,
     __attribute__((unused)) BufferPoolManager *buffer_pool_manager) {
   assert(recipient != nullptr);
-  int total = GetMaxSize() + 1;
-  assert(GetSize() == total);
+  // a new page, nothing stored with another key layout yet
+  recipient->key_size_ = key_size_;
+  recipient->integer_keys_ = integer_keys_;
+  recipient->compressed_ = compressed_;
+  recipient->prefix_size_ = prefix_size_;
+  recipient->key_width_ = key_width_;
+  memcpy(recipient->array, array, prefix_size_);
+  recipient->SetMaxSize(GetMaxSize());
+  // a compressed page also splits when a key does not fit its layout
+  int total = GetSize();
+  assert(total >= 2 && (compressed_ || total == GetMaxSize() + 1));
   //copy last half
   int copyIdx = (total)/2;//7 is 4,5,6,7; 8 is 4,5,6,7,8
-  for (int i = copyIdx; i < total; i++) {
-    recipient->array[i - copyIdx].first = array[i].first;
-    recipient->array[i - copyIdx].second = array[i].second;
-  }
-  //set pointer
+  MoveItems(recipient, 0, copyIdx, total - copyIdx);
+  //set pointer, recipient now bounds this page
   recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(high_key_);
   SetNextPageId(recipient->GetPageId());
+  SetHighKey(KeyAt(copyIdx));
   //set size, is odd, bigger is last part
   SetSize(copyIdx);
   recipient->SetSize(total - copyIdx);
-
+  if (compressed_) {
+    Compact();
+    recipient->Compact();
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -146,8 +384,8 @@ INDEX_TEMPLATE_ARGUMENTS
 bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType &value,
                                         const KeyComparator &comparator) const {
   int idx = KeyIndex(key,comparator);
-  if (idx < GetSize() && comparator(array[idx].first, key) == 0) {
-    value = array[idx].second;
+  if (idx < GetSize() && CompareAt(idx, key, comparator) == 0) {
+    value = ValueAt(idx);
     return true;
   }
   return false;
@@ -166,13 +404,12 @@ INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(
     const KeyType &key, const KeyComparator &comparator) {
   int firIdxLargerEqualThanKey = KeyIndex(key,comparator);
-  if (firIdxLargerEqualThanKey >= GetSize() || comparator(key,KeyAt(firIdxLargerEqualThanKey)) != 0) {
+  if (firIdxLargerEqualThanKey >= GetSize() || CompareAt(firIdxLargerEqualThanKey, key, comparator) != 0) {
     return GetSize();
   }
   //quick deletion
   int tarIdx = firIdxLargerEqualThanKey;
-  memmove(array + tarIdx, array + tarIdx + 1,
-          static_cast<size_t>((GetSize() - tarIdx - 1)*sizeof(MappingType)));
+  MoveItems(this, tarIdx, tarIdx + 1, GetSize() - tarIdx - 1);
   IncreaseSize(-1);
   return GetSize();
 }
@@ -191,12 +428,10 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient,
 
   //copy last half
   int startIdx = recipient->GetSize();//7 is 4,5,6,7; 8 is 4,5,6,7,8
-  for (int i = 0; i < GetSize(); i++) {
-    recipient->array[startIdx + i].first = array[i].first;
-    recipient->array[startIdx + i].second = array[i].second;
-  }
+  MoveItems(recipient, startIdx, 0, GetSize());
   //set pointer
   recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(high_key_);
   //set size, is odd, bigger is last part
   recipient->IncreaseSize(GetSize());
   SetSize(0);
@@ -218,19 +453,20 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(
     BufferPoolManager *buffer_pool_manager) {
   MappingType pair = GetItem(0);
   IncreaseSize(-1);
-  memmove(array, array + 1, static_cast<size_t>(GetSize()*sizeof(MappingType)));
+  MoveItems(this, 0, 1, GetSize());
   recipient->CopyLastFrom(pair);
+  recipient->SetHighKey(KeyAt(0));
   //update relavent key & value pair in its parent page.
   Page *page = buffer_pool_manager->FetchPage(GetParentPageId());
   B_PLUS_TREE_INTERNAL_PAGE *parent = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(page->GetData());
-  parent->SetKeyAt(parent->ValueIndex(GetPageId()), array[0].first);
+  parent->SetKeyAt(parent->ValueIndex(GetPageId()), KeyAt(0));
   buffer_pool_manager->UnpinPage(GetParentPageId(), true);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {
   assert(GetSize() + 1 <= GetMaxSize());
-  array[GetSize()] = item;
+  SetItemAt(GetSize(), item.first, item.second);
   IncreaseSize(1);
 }
 /*
@@ -244,6 +480,7 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(
   MappingType pair = GetItem(GetSize() - 1);
   IncreaseSize(-1);
   recipient->CopyFirstFrom(pair, parentIndex, buffer_pool_manager);
+  SetHighKey(pair.first);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -251,13 +488,13 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(
     const MappingType &item, int parentIndex,
     BufferPoolManager *buffer_pool_manager) {
   assert(GetSize() + 1 < GetMaxSize());
-  memmove(array + 1, array, GetSize()*sizeof(MappingType));
+  MoveItems(this, 1, 0, GetSize());
   IncreaseSize(1);
-  array[0] = item;
+  SetItemAt(0, item.first, item.second);
 
   Page *page = buffer_pool_manager->FetchPage(GetParentPageId());
   B_PLUS_TREE_INTERNAL_PAGE *parent = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(page->GetData());
-  parent->SetKeyAt(parentIndex, array[0].first);
+  parent->SetKeyAt(parentIndex, item.first);
   buffer_pool_manager->UnpinPage(GetParentPageId(), true);
 }
 
@@ -284,9 +521,9 @@ std::string B_PLUS_TREE_LEAF_PAGE_TYPE::ToString(bool verbose) const {
     } else {
       stream << " ";
     }
-    stream << std::dec << array[entry].first;
+    stream << std::dec << KeyAt(entry);
     if (verbose) {
-      stream << "(" << array[entry].second << ")";
+      stream << "(" << ValueAt(entry) << ")";
     }
     ++entry;
   }
@@ -303,4 +540,8 @@ template class BPlusTreeLeafPage<GenericKey<32>, RID,
                                        GenericComparator<32>>;
 template class BPlusTreeLeafPage<GenericKey<64>, RID,
                                        GenericComparator<64>>;
+template class BPlusTreeLeafPage<IntegerKey<int32_t>, RID,
+                                       IntegerComparator<int32_t>>;
+template class BPlusTreeLeafPage<IntegerKey<int64_t>, RID,
+                                       IntegerComparator<int64_t>>;
 } // namespace cmudb
@@ -5,23 +5,47 @@
  * see include/common/rid.h for detailed implementation) together within leaf
  * page. Only support unique key.
 
- * Leaf page format (keys are stored in order):
+ * Leaf page format (keys are stored in order, then the RIDs in the same
+ * order, each array has room for MaxSize + 1 entries, so MaxSize must not
+ * change once there are any):
  *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
+ * | HEADER | KEY(1) | KEY(2) | ... | KEY(n) | ... | RID(1) | ... | RID(n)
  *  ----------------------------------------------------------------------
+ * A search only reads the keys, packed in as few cache lines as they fit.
+ * Only the KeySize leading bytes of a key are stored, padded to the alignment
+ * of a RID; the bytes after them are zero in every key of the tree (see
+ * BPlusTree). KeySize is the size of the whole key unless the tree says so.
  *
- *  Header format (size in byte, 24 bytes in total):
+ * A compressed page stores the Prefix bytes all its keys share once, before
+ * the keys, and of each key only the bytes after the prefix up to KeyWidth,
+ * its bytes past KeyWidth being zero:
+ *  ----------------------------------------------------------------------
+ * | HEADER | PREFIX | SUFFIX(1) | ... | SUFFIX(n) | ... | RID(1) | ... |
+ *  ----------------------------------------------------------------------
+ * The layout and so MaxSize change as keys come in that do not fit it (see
+ * Admits) or when the page splits; an uncompressed page is one with no
+ * prefix and KeySize wide keys.
+ *
+ *  Header format (size in byte, 36 bytes + key size in total):
+ *  ---------------------------------------------------------------------
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
+ *  ---------------------------------------------------------------------
+ *  ------------------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | NextPageId (4) | KeySize (2) |
+ *  ------------------------------------------------------------------------
  *  ---------------------------------------------------------------------
- * | PageType (4) | CurrentSize (4) | MaxSize (4) | ParentPageId (4) |
+ * | IntegerKeys (1) | Compressed (1) | Prefix (2) | KeyWidth (2) | HighKey |
  *  ---------------------------------------------------------------------
- *  ------------------------------
- * | PageId (4) | NextPageId (4)
- *  ------------------------------
+ * IntegerKeys is set when keys are int64_t values of 8 bytes compared as
+ * such, searched with CountInt64KeysBelow.
+ * Every key of the page is below HighKey, the first key of the next page;
+ * HighKey is meaningless on the last page, which has no next page.
  */
 #pragma once
 #include <utility>
 #include <vector>
 
+#include "index/b_plus_tree_key_search.h"
 #include "page/b_plus_tree_page.h"
 
 namespace cmudb {
@@ -34,13 +58,27 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID,
+            int key_size = sizeof(KeyType), bool integer_keys = false,
+            bool compressed = false);
+  // max size of a leaf page storing key_size bytes of every key
+  static int MaxSizeFor(int key_size);
+  // key can be inserted without a split first, see BPlusTree::InsertBLink
+  bool Admits(const KeyType &key) const;
   // helper methods
   page_id_t GetNextPageId() const;
   void SetNextPageId(page_id_t next_page_id);
+  KeyType GetHighKey() const;
+  void SetHighKey(const KeyType &high_key);
+  // key belongs to a page right of this one, see BPlusTree::MoveRight
+  bool IsPastHighKey(const KeyType &key, const KeyComparator &comparator) const;
   KeyType KeyAt(int index) const;
+  // comparator(KeyAt(index), key), on the stored key in place if it can
+  int CompareAt(int index, const KeyType &key,
+                const KeyComparator &comparator) const;
+  ValueType ValueAt(int index) const;
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
-  const MappingType &GetItem(int index);
+  MappingType GetItem(int index) const;
 
   // insert and delete methods
   int Insert(const KeyType &key, const ValueType &value,
@@ -67,7 +105,49 @@ private:
   void CopyLastFrom(const MappingType &item);
   void CopyFirstFrom(const MappingType &item, int parentIndex,
                      BufferPoolManager *buffer_pool_manager);
+  static int KeyStrideFor(int key_size);
+  static int MaxSizeForLayout(int prefix_size, int key_width);
+  int PrefixSpace() const { return KeyStrideFor(prefix_size_); }
+  int KeyStride() const { return KeyStrideFor(key_width_ - prefix_size_); }
+  char *KeySlotAt(int index) {
+    return array + PrefixSpace() + index * KeyStride();
+  }
+  const char *KeySlotAt(int index) const {
+    return array + PrefixSpace() + index * KeyStride();
+  }
+  // the values start after room for MaxSize + 1 keys
+  const char *ValueSlotAt(int index) const {
+    return array + PrefixSpace() + (GetMaxSize() + 1) * KeyStride() +
+           index * sizeof(ValueType);
+  }
+  char *ValueSlotAt(int index) {
+    return const_cast<char *>(
+            static_cast<const BPlusTreeLeafPage *>(this)->ValueSlotAt(index));
+  }
+  // the stored keys are whole KeyType values
+  bool InPlace() const {
+    return alignof(KeyType) == 1 && prefix_size_ == 0 &&
+           key_width_ == static_cast<int>(sizeof(KeyType));
+  }
+  void ReadKey(int index, KeyType *key) const;
+  bool Fits(const KeyType &key) const;
+  int LayoutFor(const KeyType *key, int *prefix_size, int *key_width) const;
+  bool AdmitKey(const KeyType &key);
+  void Relayout(int prefix_size, int key_width, int max_size,
+                const KeyType &prefix_key);
+  // the smallest layout of the keys stored, after a split
+  void Compact();
+  void SetItemAt(int index, const KeyType &key, const ValueType &value);
+  // move count pairs from index on to to_index of page to, which may be this
+  void MoveItems(BPlusTreeLeafPage *to, int to_index, int index, int count);
   page_id_t next_page_id_;
-  MappingType array[0];
+  int16_t key_size_;
+  int8_t integer_keys_;
+  int8_t compressed_;
+  int16_t prefix_size_;
+  int16_t key_width_;
+  KeyType high_key_;
+  // the prefix, the keys past it up to key_width_, then the values
+  char array[0];
 };
 } // namespace cmudb
@@ -11,7 +11,7 @@ namespace cmudb {
  */
 bool BPlusTreePage::IsLeafPage() const { return page_type_ == IndexPageType::LEAF_PAGE; }
 
-bool BPlusTreePage::IsRootPage() const { return parent_page_id_ == INVALID_PAGE_ID; }
+bool BPlusTreePage::IsRootPage() const { return GetParentPageId() == INVALID_PAGE_ID; }
 
 void BPlusTreePage::SetPageType(IndexPageType page_type) { page_type_ = page_type; }
 
@@ -47,10 +47,16 @@ int BPlusTreePage::GetMinSize() const {
 
 /*
  * Helper methods to get/set parent page id
+ * A parent split in B-link mode sets it without the latch of this page, see
+ * BPlusTreeInternalPage::MoveHalfTo.
  */
-page_id_t BPlusTreePage::GetParentPageId() const { return parent_page_id_; }
+page_id_t BPlusTreePage::GetParentPageId() const {
+  return __atomic_load_n(&parent_page_id_, __ATOMIC_RELAXED);
+}
 
-void BPlusTreePage::SetParentPageId(page_id_t parent_page_id) { parent_page_id_ = parent_page_id; }
+void BPlusTreePage::SetParentPageId(page_id_t parent_page_id) {
+  __atomic_store_n(&parent_page_id_, parent_page_id, __ATOMIC_RELAXED);
+}
 
 /*
  * Helper methods to get/set self page id
@@ -77,4 +83,22 @@ bool BPlusTreePage::IsSafe(OpType op) {
   assert(false);//invalid area
 }
 
+/*
+ * Helper methods for prefix compressed pages, see BPlusTreeLeafPage
+ */
+int BPlusTreePage::SignificantSize(const char *key, int size) {
+  while (size > 0 && key[size - 1] == 0) {
+    size--;
+  }
+  return size;
+}
+
+int BPlusTreePage::CommonPrefixSize(const char *a, const char *b, int size) {
+  int i = 0;
+  while (i < size && a[i] == b[i]) {
+    i++;
+  }
+  return i;
+}
+
 } // namespace cmudb
@@ -24,6 +24,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "index/generic_key.h"
+#include "index/integer_key.h"
 
 namespace cmudb {
 
@@ -59,6 +60,11 @@ public:
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
   bool IsSafe(OpType op);
+protected:
+  // bytes of a key stored in size bytes up to its last nonzero one
+  static int SignificantSize(const char *key, int size);
+  // leading bytes out of size that keys a and b have in common
+  static int CommonPrefixSize(const char *a, const char *b, int size);
 private:
   // member variable, attributes that both internal and leaf page share
   IndexPageType page_type_;
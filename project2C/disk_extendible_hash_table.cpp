@@ -0,0 +1,459 @@
+/**
+ * disk_extendible_hash_table.cpp
+ */
+#include <algorithm>
+#include <iostream>
+
+#include "common/exception.h"
+#include "common/rid.h"
+#include "index/disk_extendible_hash_table.h"
+#include "page/header_page.h"
+
+namespace cmudb {
+
+INDEX_TEMPLATE_ARGUMENTS
+DISK_EXTENDIBLE_HASH_TABLE_TYPE::DiskExtendibleHashTable(
+    const std::string &name, BufferPoolManager *buffer_pool_manager,
+    const KeyComparator &comparator, page_id_t header_page_id)
+    : index_name_(name), header_page_id_(header_page_id),
+      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
+
+/*
+ * Helper function to decide whether current hash table is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool DISK_EXTENDIBLE_HASH_TABLE_TYPE::IsEmpty() const {
+  return header_page_id_ == INVALID_PAGE_ID;
+}
+
+/*
+ * Hash of the bytes of a key (FNV-1a, then the murmur3 finalizer so the low
+ * bits the directory uses depend on every byte)
+ */
+INDEX_TEMPLATE_ARGUMENTS
+uint32_t DISK_EXTENDIBLE_HASH_TABLE_TYPE::Hash(const KeyType &key) const {
+  const unsigned char *data = reinterpret_cast<const unsigned char *>(&key);
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < sizeof(KeyType); i++) {
+    h = (h ^ data[i]) * 0x100000001b3ULL;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return static_cast<uint32_t>(h);
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+/*
+ * Return the only value that associated with input key
+ * This method is used for point query: the hash table header page, the
+ * directory page, then one bucket page
+ * @return : true means key exists
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool DISK_EXTENDIBLE_HASH_TABLE_TYPE::GetValue(const KeyType &key,
+                                               std::vector<ValueType> &result) {
+  if (IsEmpty()) {
+    return false;
+  }
+  const uint32_t hash = Hash(key);
+  const page_id_t dirPageId = GetDirectoryPageId(hash, false);
+  if (dirPageId == INVALID_PAGE_ID) {
+    return false;
+  }
+  ReadPageGuard dirGuard = buffer_pool_manager_->FetchPageRead(dirPageId);
+  if (dirGuard.IsEmpty()) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned while GetValue");
+  }
+  auto dir = dirGuard.As<HashTableDirectoryPage>();
+  ReadPageGuard bucketGuard = buffer_pool_manager_->FetchPageRead(
+          dir->GetBucketPageId(hash & dir->GetGlobalDepthMask()));
+  if (bucketGuard.IsEmpty()) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned while GetValue");
+  }
+  dirGuard.Release();
+  result.resize(1);
+  return bucketGuard.As<HASH_TABLE_BUCKET_PAGE_TYPE>()->Lookup(key, result[0],
+                                                              comparator_);
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/*
+ * Insert constant key & value pair into the hash table
+ * if there is no hash table header yet, create it, and the directory of the
+ * key with one empty bucket if there is none. The bucket of the key is write
+ * latched under a read latched directory; only when it is full does the
+ * insert start over in SplitInsert.
+ * @return: since we only support unique key, if user try to insert duplicate
+ * keys return false, otherwise return true.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool DISK_EXTENDIBLE_HASH_TABLE_TYPE::Insert(const KeyType &key,
+                                             const ValueType &value) {
+  if (IsEmpty()) {
+    StartNewTable();
+  }
+  const uint32_t hash = Hash(key);
+  const page_id_t dirPageId = GetDirectoryPageId(hash, true);
+  {
+    ReadPageGuard dirGuard = buffer_pool_manager_->FetchPageRead(dirPageId);
+    if (dirGuard.IsEmpty()) {
+      throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned while Insert");
+    }
+    auto dir = dirGuard.As<HashTableDirectoryPage>();
+    WritePageGuard bucketGuard = buffer_pool_manager_->FetchPageWrite(
+            dir->GetBucketPageId(hash & dir->GetGlobalDepthMask()));
+    if (bucketGuard.IsEmpty()) {
+      throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned while Insert");
+    }
+    dirGuard.Release();
+    auto bucket = bucketGuard.As<HASH_TABLE_BUCKET_PAGE_TYPE>();
+    ValueType v;
+    if (bucket->Lookup(key, v, comparator_)) {
+      return false;
+    }
+    if (!bucket->IsFull()) {
+      bucket->Append(MappingType(key, value));
+      bucketGuard.MarkDirty();
+      return true;
+    }
+  }
+  return SplitInsert(dirPageId, key, value);
+}
+
+/*
+ * Create the hash table header page, and record it in the header page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void DISK_EXTENDIBLE_HASH_TABLE_TYPE::StartNewTable() {
+  std::lock_guard<std::mutex> lck(mutex_);
+  if (!IsEmpty()) {
+    return;
+  }
+  page_id_t headerPageId;
+  WritePageGuard headerGuard =
+          buffer_pool_manager_->NewPageGuarded(headerPageId);
+  if (headerGuard.IsEmpty()) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  }
+  headerGuard.As<HashTableHeaderPage>()->Init(headerPageId);
+  {
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+    HeaderPage *header_page = static_cast<HeaderPage *>(guard.GetPage());
+    guard.MarkDirty();
+    // create a new record<index_name + header_page_id> in header_page
+    header_page->InsertRecord(index_name_, headerPageId);
+  }
+  header_page_id_ = headerPageId;
+}
+
+/*
+ * Page id of the directory hash goes to, INVALID_PAGE_ID if it has none yet
+ * and create is false. A directory is created with one empty bucket, under
+ * the hash table header write latched. It never moves afterwards, so the
+ * header is not held while the directory is used.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t DISK_EXTENDIBLE_HASH_TABLE_TYPE::GetDirectoryPageId(uint32_t hash,
+                                                              bool create) {
+  {
+    ReadPageGuard headerGuard =
+            buffer_pool_manager_->FetchPageRead(header_page_id_);
+    if (headerGuard.IsEmpty()) {
+      throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned");
+    }
+    auto header = headerGuard.As<HashTableHeaderPage>();
+    page_id_t dirPageId =
+            header->GetDirectoryPageId(header->HashToSlot(hash));
+    if (dirPageId != INVALID_PAGE_ID || !create) {
+      return dirPageId;
+    }
+  }
+  WritePageGuard headerGuard =
+          buffer_pool_manager_->FetchPageWrite(header_page_id_);
+  if (headerGuard.IsEmpty()) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned");
+  }
+  auto header = headerGuard.As<HashTableHeaderPage>();
+  const uint32_t slot = header->HashToSlot(hash);
+  if (header->GetDirectoryPageId(slot) != INVALID_PAGE_ID) {
+    return header->GetDirectoryPageId(slot);
+  }
+  page_id_t dirPageId, bucketPageId;
+  WritePageGuard dirGuard = buffer_pool_manager_->NewPageGuarded(dirPageId);
+  WritePageGuard bucketGuard =
+          buffer_pool_manager_->NewPageGuarded(bucketPageId);
+  if (dirGuard.IsEmpty() || bucketGuard.IsEmpty()) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  }
+  bucketGuard.As<HASH_TABLE_BUCKET_PAGE_TYPE>()->Init(bucketPageId);
+  dirGuard.As<HashTableDirectoryPage>()->Init(dirPageId, bucketPageId);
+  header->SetDirectoryPageId(slot, dirPageId);
+  headerGuard.MarkDirty();
+  return dirPageId;
+}
+
+/*
+ * Insert with the directory write latched: split the bucket of key as long as
+ * it is full, doubling the directory when the bucket already uses all of its
+ * bits. Entries whose hash has the new bit set move to a new bucket page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool DISK_EXTENDIBLE_HASH_TABLE_TYPE::SplitInsert(page_id_t dirPageId,
+                                                  const KeyType &key,
+                                                  const ValueType &value) {
+  WritePageGuard dirGuard = buffer_pool_manager_->FetchPageWrite(dirPageId);
+  if (dirGuard.IsEmpty()) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned while Insert");
+  }
+  auto dir = dirGuard.As<HashTableDirectoryPage>();
+  const uint32_t hash = Hash(key);
+  while (true) {
+    const uint32_t slot = hash & dir->GetGlobalDepthMask();
+    WritePageGuard bucketGuard =
+            buffer_pool_manager_->FetchPageWrite(dir->GetBucketPageId(slot));
+    if (bucketGuard.IsEmpty()) {
+      throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned while Insert");
+    }
+    auto bucket = bucketGuard.As<HASH_TABLE_BUCKET_PAGE_TYPE>();
+    ValueType v;
+    if (bucket->Lookup(key, v, comparator_)) {
+      return false;
+    }
+    if (!bucket->IsFull()) {
+      bucket->Append(MappingType(key, value));
+      bucketGuard.MarkDirty();
+      return true;
+    }
+
+    const int localDepth = dir->GetLocalDepth(slot);
+    if (localDepth == dir->GetGlobalDepth()) {
+      if (localDepth == DIRECTORY_MAX_DEPTH) {
+        throw Exception(EXCEPTION_TYPE_INDEX, "hash directory is full");
+      }
+      dir->IncrGlobalDepth();
+    }
+    page_id_t imagePageId;
+    WritePageGuard imageGuard =
+            buffer_pool_manager_->NewPageGuarded(imagePageId);
+    if (imageGuard.IsEmpty()) {
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    }
+    auto image = imageGuard.As<HASH_TABLE_BUCKET_PAGE_TYPE>();
+    image->Init(imagePageId);
+
+    const uint32_t bit = 1u << localDepth;
+    for (int i = bucket->GetSize() - 1; i >= 0; i--) {
+      if (Hash(bucket->GetItem(i).first) & bit) {
+        image->Append(bucket->GetItem(i));
+        bucket->RemoveAt(i);
+      }
+    }
+    for (uint32_t i = slot & (bit - 1); i < dir->Size(); i += bit) {
+      dir->SetLocalDepth(i, localDepth + 1);
+      if (i & bit) {
+        dir->SetBucketPageId(i, imagePageId);
+      }
+    }
+    bucketGuard.MarkDirty();
+    dirGuard.MarkDirty();
+  }
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+/*
+ * Delete key & value pair associated with input key
+ * If current hash table is empty, return immdiately. A bucket left empty is
+ * merged with its split image, under the directory write latched.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void DISK_EXTENDIBLE_HASH_TABLE_TYPE::Remove(const KeyType &key) {
+  if (IsEmpty()) {
+    return;
+  }
+  const page_id_t dirPageId = GetDirectoryPageId(Hash(key), false);
+  if (dirPageId == INVALID_PAGE_ID) {
+    return;
+  }
+  {
+    ReadPageGuard dirGuard = buffer_pool_manager_->FetchPageRead(dirPageId);
+    if (dirGuard.IsEmpty()) {
+      throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned while Remove");
+    }
+    auto dir = dirGuard.As<HashTableDirectoryPage>();
+    const uint32_t slot = Hash(key) & dir->GetGlobalDepthMask();
+    WritePageGuard bucketGuard =
+            buffer_pool_manager_->FetchPageWrite(dir->GetBucketPageId(slot));
+    if (bucketGuard.IsEmpty()) {
+      throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned while Remove");
+    }
+    const bool canMerge = dir->GetLocalDepth(slot) > 0;
+    dirGuard.Release();
+    auto bucket = bucketGuard.As<HASH_TABLE_BUCKET_PAGE_TYPE>();
+    if (!bucket->Remove(key, comparator_)) {
+      return;
+    }
+    bucketGuard.MarkDirty();
+    if (!canMerge || !bucket->IsEmpty()) {
+      return;
+    }
+  }
+  Merge(dirPageId, key);
+}
+
+/*
+ * With the directory write latched, as long as the bucket of key or its split
+ * image is empty and both have the same local depth, point the slots of the
+ * empty one to the other and drop its page. Then halve the directory while no
+ * bucket needs all of its bits.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void DISK_EXTENDIBLE_HASH_TABLE_TYPE::Merge(page_id_t dirPageId,
+                                            const KeyType &key) {
+  WritePageGuard dirGuard = buffer_pool_manager_->FetchPageWrite(dirPageId);
+  if (dirGuard.IsEmpty()) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned while Remove");
+  }
+  auto dir = dirGuard.As<HashTableDirectoryPage>();
+  const uint32_t hash = Hash(key);
+  while (true) {
+    const uint32_t slot = hash & dir->GetGlobalDepthMask();
+    const int localDepth = dir->GetLocalDepth(slot);
+    if (localDepth == 0) {
+      break;
+    }
+    const uint32_t bit = 1u << (localDepth - 1);
+    if (dir->GetLocalDepth(slot ^ bit) != localDepth) {
+      break;
+    }
+    const page_id_t bucketPageId = dir->GetBucketPageId(slot);
+    const page_id_t imagePageId = dir->GetBucketPageId(slot ^ bit);
+    page_id_t emptyPageId, keptPageId;
+    {
+      // a lookup may still be reading one of them, wait for it
+      ReadPageGuard bucketGuard = buffer_pool_manager_->FetchPageRead(bucketPageId);
+      ReadPageGuard imageGuard = buffer_pool_manager_->FetchPageRead(imagePageId);
+      if (bucketGuard.IsEmpty() || imageGuard.IsEmpty()) {
+        throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned while Remove");
+      }
+      if (bucketGuard.As<HASH_TABLE_BUCKET_PAGE_TYPE>()->IsEmpty()) {
+        emptyPageId = bucketPageId;
+        keptPageId = imagePageId;
+      } else if (imageGuard.As<HASH_TABLE_BUCKET_PAGE_TYPE>()->IsEmpty()) {
+        emptyPageId = imagePageId;
+        keptPageId = bucketPageId;
+      } else {
+        break;
+      }
+    }
+    for (uint32_t i = slot & (bit - 1); i < dir->Size(); i += bit) {
+      dir->SetLocalDepth(i, localDepth - 1);
+      dir->SetBucketPageId(i, keptPageId);
+    }
+    // nobody can reach the empty page anymore; one that a lookup has not
+    // unpinned yet stays allocated
+    buffer_pool_manager_->DeletePage(emptyPageId);
+    dirGuard.MarkDirty();
+  }
+  while (dir->CanShrink()) {
+    dir->DecrGlobalDepth();
+    dirGuard.MarkDirty();
+  }
+}
+
+/*****************************************************************************
+ * UTILITIES AND DEBUG
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+std::vector<page_id_t> DISK_EXTENDIBLE_HASH_TABLE_TYPE::GetDirectoryPageIds() {
+  std::vector<page_id_t> dirPageIds;
+  if (IsEmpty()) {
+    return dirPageIds;
+  }
+  ReadPageGuard headerGuard =
+          buffer_pool_manager_->FetchPageRead(header_page_id_);
+  if (headerGuard.IsEmpty()) {
+    throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned");
+  }
+  auto header = headerGuard.As<HashTableHeaderPage>();
+  for (uint32_t i = 0; i < HEADER_ARRAY_SIZE; i++) {
+    if (header->GetDirectoryPageId(i) != INVALID_PAGE_ID) {
+      dirPageIds.push_back(header->GetDirectoryPageId(i));
+    }
+  }
+  return dirPageIds;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int DISK_EXTENDIBLE_HASH_TABLE_TYPE::GetGlobalDepth() {
+  int globalDepth = 0;
+  for (page_id_t dirPageId : GetDirectoryPageIds()) {
+    ReadPageGuard dirGuard = buffer_pool_manager_->FetchPageRead(dirPageId);
+    if (dirGuard.IsEmpty()) {
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "all page are pinned while GetGlobalDepth");
+    }
+    globalDepth = std::max(
+            globalDepth, dirGuard.As<HashTableDirectoryPage>()->GetGlobalDepth());
+  }
+  return globalDepth;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool DISK_EXTENDIBLE_HASH_TABLE_TYPE::Check() {
+  bool isDirCorr = true, isBucketCorr = true;
+  for (page_id_t dirPageId : GetDirectoryPageIds()) {
+    ReadPageGuard dirGuard = buffer_pool_manager_->FetchPageRead(dirPageId);
+    if (dirGuard.IsEmpty()) {
+      throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned while Check");
+    }
+    auto dir = dirGuard.As<HashTableDirectoryPage>();
+    for (uint32_t i = 0; i < dir->Size(); i++) {
+      const int localDepth = dir->GetLocalDepth(i);
+      const uint32_t localMask = (1u << localDepth) - 1;
+      if (localDepth > dir->GetGlobalDepth() ||
+          dir->GetBucketPageId(i) != dir->GetBucketPageId(i & localMask) ||
+          localDepth != dir->GetLocalDepth(i & localMask)) {
+        isDirCorr = false;
+        continue;
+      }
+      if (i != (i & localMask)) {
+        continue;
+      }
+      ReadPageGuard bucketGuard =
+              buffer_pool_manager_->FetchPageRead(dir->GetBucketPageId(i));
+      if (bucketGuard.IsEmpty()) {
+        throw Exception(EXCEPTION_TYPE_INDEX, "all page are pinned while Check");
+      }
+      auto bucket = bucketGuard.As<HASH_TABLE_BUCKET_PAGE_TYPE>();
+      for (int j = 0; j < bucket->GetSize(); j++) {
+        if ((Hash(bucket->GetItem(j).first) & localMask) != i) {
+          isBucketCorr = false;
+        }
+      }
+    }
+  }
+  bool isAllUnpin = buffer_pool_manager_->CheckAllUnpined();
+  if (!isDirCorr) std::cout << "problem in directory" << std::endl;
+  if (!isBucketCorr) std::cout << "problem in bucket content" << std::endl;
+  if (!isAllUnpin) std::cout << "problem in page unpin" << std::endl;
+  return isDirCorr && isBucketCorr && isAllUnpin;
+}
+
+template class DiskExtendibleHashTable<GenericKey<4>, RID, GenericComparator<4>>;
+template class DiskExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>>;
+template class DiskExtendibleHashTable<GenericKey<16>, RID,
+                                       GenericComparator<16>>;
+template class DiskExtendibleHashTable<GenericKey<32>, RID,
+                                       GenericComparator<32>>;
+template class DiskExtendibleHashTable<GenericKey<64>, RID,
+                                       GenericComparator<64>>;
+} // namespace cmudb
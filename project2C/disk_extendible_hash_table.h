@@ -0,0 +1,84 @@
+/**
+ * disk_extendible_hash_table.h
+ *
+ * Extendible hash index kept in pages of the buffer pool, for equality
+ * lookups: a header page maps the top bits of the hash of a key to a directory
+ * page, which maps its low GlobalDepth bits to a bucket page, so a point query
+ * fetches three pages whatever the size of the index.
+ * (1) We only support unique key
+ * (2) support insert & remove
+ * (3) A full bucket splits, doubling the directory when it has to; an emptied
+ * bucket merges with its split image and the directory halves when it can
+ *
+ * Latching: the header page is only latched to read or create a directory
+ * page id. The directory page is read latched while a bucket is latched, and
+ * released right after. An insert needing a split or a remove emptying a
+ * bucket starts over with the directory write latched, which keeps everybody
+ * else out of the buckets while they move.
+ */
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "page/hash_table_bucket_page.h"
+#include "page/hash_table_directory_page.h"
+#include "page/hash_table_header_page.h"
+
+namespace cmudb {
+
+#define DISK_EXTENDIBLE_HASH_TABLE_TYPE                                        \
+  DiskExtendibleHashTable<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+class DiskExtendibleHashTable {
+public:
+  explicit DiskExtendibleHashTable(const std::string &name,
+                                   BufferPoolManager *buffer_pool_manager,
+                                   const KeyComparator &comparator,
+                                   page_id_t header_page_id = INVALID_PAGE_ID);
+
+  // Returns true if this index has no header page yet.
+  bool IsEmpty() const;
+
+  // Insert a key-value pair into this index.
+  bool Insert(const KeyType &key, const ValueType &value);
+
+  // Remove a key and its value from this index.
+  void Remove(const KeyType &key);
+
+  // return the value associated with a given key
+  bool GetValue(const KeyType &key, std::vector<ValueType> &result);
+
+  // expose for test purpose: the largest over all directories
+  int GetGlobalDepth();
+  // expose for test purpose: every key sits in the bucket of its slot, the
+  // local depths are consistent, and nothing is left pinned
+  bool Check();
+
+private:
+  uint32_t Hash(const KeyType &key) const;
+
+  void StartNewTable();
+
+  page_id_t GetDirectoryPageId(uint32_t hash, bool create);
+
+  std::vector<page_id_t> GetDirectoryPageIds();
+
+  bool SplitInsert(page_id_t dirPageId, const KeyType &key,
+                   const ValueType &value);
+
+  void Merge(page_id_t dirPageId, const KeyType &key);
+
+  // member variable
+  std::string index_name_;
+  std::atomic<page_id_t> header_page_id_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+  // creating the header page
+  std::mutex mutex_;
+};
+} // namespace cmudb
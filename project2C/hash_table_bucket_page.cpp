@@ -0,0 +1,108 @@
+/**
+ * hash_table_bucket_page.cpp
+ */
+
+#include "common/rid.h"
+#include "page/hash_table_bucket_page.h"
+
+namespace cmudb {
+
+/**
+ * Init method after creating a new bucket page
+ * Including set page id, set current size to zero and set max size
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::Init(page_id_t page_id) {
+  assert(sizeof(HashTableBucketPage) == 16);
+  page_id_ = page_id;
+  lsn_ = INVALID_LSN;
+  size_ = 0;
+  max_size_ = (PAGE_SIZE - sizeof(HashTableBucketPage)) / sizeof(MappingType);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t HASH_TABLE_BUCKET_PAGE_TYPE::GetPageId() const { return page_id_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+INDEX_TEMPLATE_ARGUMENTS
+int HASH_TABLE_BUCKET_PAGE_TYPE::GetSize() const { return size_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+int HASH_TABLE_BUCKET_PAGE_TYPE::GetMaxSize() const { return max_size_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_PAGE_TYPE::IsFull() const { return size_ == max_size_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_PAGE_TYPE::IsEmpty() const { return size_ == 0; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const MappingType &HASH_TABLE_BUCKET_PAGE_TYPE::GetItem(int index) const {
+  assert(index >= 0 && index < size_);
+  return array[index];
+}
+
+/*
+ * Helper method to find the index of key, -1 if absent
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int HASH_TABLE_BUCKET_PAGE_TYPE::KeyIndex(
+    const KeyType &key, const KeyComparator &comparator) const {
+  for (int i = 0; i < size_; i++) {
+    if (comparator(array[i].first, key) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/*
+ * For the given key, check to see whether it exists in the bucket. If it does,
+ * then store its corresponding value in input "value" and return true.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_PAGE_TYPE::Lookup(const KeyType &key, ValueType &value,
+                                         const KeyComparator &comparator) const {
+  int index = KeyIndex(key, comparator);
+  if (index == -1) {
+    return false;
+  }
+  value = array[index].second;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::Append(const MappingType &item) {
+  assert(size_ < max_size_);
+  array[size_++] = item;
+}
+
+/*
+ * Delete key from the bucket if it exists
+ * @return whether key was there
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_PAGE_TYPE::Remove(const KeyType &key,
+                                         const KeyComparator &comparator) {
+  int index = KeyIndex(key, comparator);
+  if (index == -1) {
+    return false;
+  }
+  RemoveAt(index);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::RemoveAt(int index) {
+  assert(index >= 0 && index < size_);
+  array[index] = array[--size_];
+}
+
+template class HashTableBucketPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class HashTableBucketPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class HashTableBucketPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class HashTableBucketPage<GenericKey<64>, RID, GenericComparator<64>>;
+} // namespace cmudb
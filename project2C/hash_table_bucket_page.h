@@ -0,0 +1,60 @@
+/**
+ * hash_table_bucket_page.h
+ *
+ * Bucket of a disk extendible hash table: the key/value pairs whose hash falls
+ * on its directory slots, unordered and packed at the front. Only support
+ * unique key.
+ *
+ * Bucket page format:
+ *  ----------------------------------------------------------------------
+ * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
+ *  ----------------------------------------------------------------------
+ *
+ *  Header format (size in byte, 16 bytes in total):
+ *  ---------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
+ *  ---------------------------------------------------------------------
+ */
+#pragma once
+
+#include <utility>
+
+#include "page/b_plus_tree_page.h"
+
+namespace cmudb {
+#define HASH_TABLE_BUCKET_PAGE_TYPE                                            \
+  HashTableBucketPage<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+class HashTableBucketPage {
+public:
+  // After creating a new bucket page from buffer pool, must call initialize
+  // method to set default values
+  void Init(page_id_t page_id);
+
+  page_id_t GetPageId() const;
+  void SetLSN(lsn_t lsn = INVALID_LSN);
+  int GetSize() const;
+  int GetMaxSize() const;
+  bool IsFull() const;
+  bool IsEmpty() const;
+
+  const MappingType &GetItem(int index) const;
+  bool Lookup(const KeyType &key, ValueType &value,
+              const KeyComparator &comparator) const;
+  // append a key known to be absent, the page must not be full
+  void Append(const MappingType &item);
+  bool Remove(const KeyType &key, const KeyComparator &comparator);
+  // the last pair fills the hole
+  void RemoveAt(int index);
+
+private:
+  int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
+
+  page_id_t page_id_;
+  lsn_t lsn_;
+  int size_;
+  int max_size_;
+  MappingType array[0];
+};
+} // namespace cmudb
@@ -0,0 +1,76 @@
+/**
+ * hash_table_directory_page.cpp
+ */
+#include <cassert>
+#include <cstring>
+
+#include "page/hash_table_directory_page.h"
+
+namespace cmudb {
+
+void HashTableDirectoryPage::Init(page_id_t page_id,
+                                  page_id_t bucket_page_id) {
+  static_assert(sizeof(HashTableDirectoryPage) <= PAGE_SIZE,
+                "directory does not fit a page");
+  page_id_ = page_id;
+  lsn_ = INVALID_LSN;
+  global_depth_ = 0;
+  local_depths_[0] = 0;
+  bucket_page_ids_[0] = bucket_page_id;
+}
+
+page_id_t HashTableDirectoryPage::GetPageId() const { return page_id_; }
+
+void HashTableDirectoryPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+int HashTableDirectoryPage::GetGlobalDepth() const { return global_depth_; }
+
+uint32_t HashTableDirectoryPage::GetGlobalDepthMask() const {
+  return Size() - 1;
+}
+
+uint32_t HashTableDirectoryPage::Size() const { return 1u << global_depth_; }
+
+page_id_t HashTableDirectoryPage::GetBucketPageId(uint32_t slot) const {
+  return bucket_page_ids_[slot];
+}
+
+void HashTableDirectoryPage::SetBucketPageId(uint32_t slot,
+                                             page_id_t bucket_page_id) {
+  bucket_page_ids_[slot] = bucket_page_id;
+}
+
+int HashTableDirectoryPage::GetLocalDepth(uint32_t slot) const {
+  return local_depths_[slot];
+}
+
+void HashTableDirectoryPage::SetLocalDepth(uint32_t slot, int local_depth) {
+  local_depths_[slot] = static_cast<uint8_t>(local_depth);
+}
+
+void HashTableDirectoryPage::IncrGlobalDepth() {
+  assert(global_depth_ < DIRECTORY_MAX_DEPTH);
+  const uint32_t size = Size();
+  memcpy(local_depths_ + size, local_depths_, size * sizeof(uint8_t));
+  memcpy(bucket_page_ids_ + size, bucket_page_ids_, size * sizeof(page_id_t));
+  global_depth_++;
+}
+
+void HashTableDirectoryPage::DecrGlobalDepth() {
+  assert(global_depth_ > 0);
+  global_depth_--;
+}
+
+bool HashTableDirectoryPage::CanShrink() const {
+  if (global_depth_ == 0) {
+    return false;
+  }
+  for (uint32_t i = 0; i < Size(); i++) {
+    if (local_depths_[i] == global_depth_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace cmudb
@@ -0,0 +1,70 @@
+/**
+ * hash_table_directory_page.h
+ *
+ * Directory of a disk extendible hash table (see disk_extendible_hash_table.h):
+ * the page id and local depth of the bucket behind each of the 2^GlobalDepth
+ * slots. A bucket of local depth d owns the slots whose low d bits match.
+ *
+ * Directory page format (size in byte, N = DIRECTORY_ARRAY_SIZE):
+ * ----------------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | GlobalDepth (4) | LocalDepths (N) |
+ * ----------------------------------------------------------------------------
+ * | BucketPageIds (4 * N) |
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+// largest depth at which 2^depth slots of slot_size bytes fit in a page
+// after header_size bytes
+constexpr int HashTableMaxDepth(size_t header_size, size_t slot_size,
+                                int depth = 0) {
+  return header_size + (size_t(2) << depth) * slot_size > PAGE_SIZE
+             ? depth
+             : HashTableMaxDepth(header_size, slot_size, depth + 1);
+}
+
+// a bucket page id and a local depth per slot
+#define DIRECTORY_MAX_DEPTH HashTableMaxDepth(12, 5)
+#define DIRECTORY_ARRAY_SIZE (1 << DIRECTORY_MAX_DEPTH)
+
+class HashTableDirectoryPage {
+public:
+  // After creating a new directory page from buffer pool, must call
+  // initialize method: one slot pointing to bucket_page_id
+  void Init(page_id_t page_id, page_id_t bucket_page_id);
+
+  page_id_t GetPageId() const;
+  void SetLSN(lsn_t lsn = INVALID_LSN);
+
+  int GetGlobalDepth() const;
+  uint32_t GetGlobalDepthMask() const;
+  uint32_t Size() const;
+
+  page_id_t GetBucketPageId(uint32_t slot) const;
+  void SetBucketPageId(uint32_t slot, page_id_t bucket_page_id);
+  int GetLocalDepth(uint32_t slot) const;
+  void SetLocalDepth(uint32_t slot, int local_depth);
+
+  // doubling copies every slot to its upper half twin
+  void IncrGlobalDepth();
+  void DecrGlobalDepth();
+  // true when no bucket needs all global depth bits
+  bool CanShrink() const;
+
+private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  int global_depth_;
+  uint8_t local_depths_[DIRECTORY_ARRAY_SIZE];
+  page_id_t bucket_page_ids_[DIRECTORY_ARRAY_SIZE];
+};
+
+} // namespace cmudb
@@ -0,0 +1,38 @@
+/**
+ * hash_table_header_page.cpp
+ */
+#include "page/hash_table_header_page.h"
+
+namespace cmudb {
+
+void HashTableHeaderPage::Init(page_id_t page_id) {
+  static_assert(sizeof(HashTableHeaderPage) <= PAGE_SIZE,
+                "hash table header does not fit a page");
+  page_id_ = page_id;
+  lsn_ = INVALID_LSN;
+  for (int i = 0; i < HEADER_ARRAY_SIZE; i++) {
+    directory_page_ids_[i] = INVALID_PAGE_ID;
+  }
+}
+
+page_id_t HashTableHeaderPage::GetPageId() const { return page_id_; }
+
+void HashTableHeaderPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+/*
+ * The top bits, the directories use the low ones
+ */
+uint32_t HashTableHeaderPage::HashToSlot(uint32_t hash) const {
+  return HEADER_MAX_DEPTH == 0 ? 0 : hash >> (32 - HEADER_MAX_DEPTH);
+}
+
+page_id_t HashTableHeaderPage::GetDirectoryPageId(uint32_t slot) const {
+  return directory_page_ids_[slot];
+}
+
+void HashTableHeaderPage::SetDirectoryPageId(uint32_t slot,
+                                             page_id_t directory_page_id) {
+  directory_page_ids_[slot] = directory_page_id;
+}
+
+} // namespace cmudb
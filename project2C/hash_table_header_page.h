@@ -0,0 +1,44 @@
+/**
+ * hash_table_header_page.h
+ *
+ * First page of a disk extendible hash table (see
+ * disk_extendible_hash_table.h): the page id of the directory behind each value
+ * of the top HEADER_MAX_DEPTH bits of a hash, INVALID_PAGE_ID until a key
+ * lands there. Its depth is fixed, so a directory page never moves.
+ *
+ * Header page format (size in byte, N = HEADER_ARRAY_SIZE):
+ * ----------------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | DirectoryPageIds (4 * N) |
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include "page/hash_table_directory_page.h"
+
+namespace cmudb {
+
+#define HEADER_MAX_DEPTH HashTableMaxDepth(8, 4)
+#define HEADER_ARRAY_SIZE (1 << HEADER_MAX_DEPTH)
+
+class HashTableHeaderPage {
+public:
+  // After creating a new header page from buffer pool, must call initialize
+  // method: no directory yet
+  void Init(page_id_t page_id);
+
+  page_id_t GetPageId() const;
+  void SetLSN(lsn_t lsn = INVALID_LSN);
+
+  // slot of the directory a hash goes to
+  uint32_t HashToSlot(uint32_t hash) const;
+  page_id_t GetDirectoryPageId(uint32_t slot) const;
+  void SetDirectoryPageId(uint32_t slot, page_id_t directory_page_id);
+
+private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  page_id_t directory_page_ids_[HEADER_ARRAY_SIZE];
+};
+
+} // namespace cmudb
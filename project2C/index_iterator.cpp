@@ -2,6 +2,7 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <utility>
 
 #include "index/index_iterator.h"
 
@@ -12,21 +13,30 @@ namespace cmudb {
  * set your own input parameters
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf, int index, BufferPoolManager *bufferPoolManager)
-: index_(index),leaf_(leaf), bufferPoolManager_(bufferPoolManager){}
-
-INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() {
-  if (leaf_ != nullptr) {
-    UnlockAndUnPin();
+INDEXITERATOR_TYPE::IndexIterator(ReadPageGuard leaf, int index,
+                                  BufferPoolManager *bufferPoolManager)
+: index_(index), guard_(std::move(leaf)), leaf_(nullptr),
+  bufferPoolManager_(bufferPoolManager) {
+  if (!guard_.IsEmpty()) {
+    leaf_ = guard_.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
+    PrefetchNext();
+    SkipExhausted();
   }
 }
 
+// the guard unlatches and unpins the current leaf
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::~IndexIterator() {}
+
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
 template class IndexIterator<GenericKey<16>, RID, GenericComparator<16>>;
 template class IndexIterator<GenericKey<32>, RID, GenericComparator<32>>;
 template class IndexIterator<GenericKey<64>, RID, GenericComparator<64>>;
+template class IndexIterator<IntegerKey<int32_t>, RID,
+                             IntegerComparator<int32_t>>;
+template class IndexIterator<IntegerKey<int64_t>, RID,
+                             IntegerComparator<int64_t>>;
 
 } // namespace cmudb
@@ -3,6 +3,7 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include "buffer/page_guard.h"
 #include "page/b_plus_tree_leaf_page.h"
 
 namespace cmudb {
@@ -14,7 +15,10 @@ INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
 public:
   // you may define your own constructor based on your member variables
-  IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf, int index, BufferPoolManager *bufferPoolManager);
+  // leaf is empty at the end of the tree
+  IndexIterator(ReadPageGuard leaf, int index,
+                BufferPoolManager *bufferPoolManager);
+  IndexIterator(IndexIterator &&other) = default;
   ~IndexIterator();
 
   bool isEnd(){
@@ -22,34 +26,45 @@ public:
   }
 
   const MappingType &operator*() {
-    return leaf_->GetItem(index_);
+    // rebuilt from the slot, keys are not stored whole
+    item_ = leaf_->GetItem(index_);
+    return item_;
   }
 
   IndexIterator &operator++() {
     index_++;
-    if (index_ >= leaf_->GetSize()) {
+    SkipExhausted();
+    return *this;
+  }
+
+private:
+  // on to the next leaf while there is no key left in this one, B-link mode
+  // leaves empty leaves behind
+  void SkipExhausted() {
+    while (leaf_ != nullptr && index_ >= leaf_->GetSize()) {
       page_id_t next = leaf_->GetNextPageId();
-      UnlockAndUnPin();
-      if (next == INVALID_PAGE_ID) {
-        leaf_ = nullptr;
-      } else {
-        Page *page = bufferPoolManager_->FetchPage(next);
-        page->RLatch();
-        leaf_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+      // unlatched before the next leaf is latched, like before
+      guard_.Release();
+      leaf_ = nullptr;
+      if (next != INVALID_PAGE_ID) {
+        guard_ = bufferPoolManager_->FetchPageRead(next);
+        leaf_ = guard_.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
         index_ = 0;
+        PrefetchNext();
       }
     }
-    return *this;
   }
 
-private:
   // add your own private member variables here
-  void UnlockAndUnPin() {
-    bufferPoolManager_->FetchPage(leaf_->GetPageId())->RUnlatch();
-    bufferPoolManager_->UnpinPage(leaf_->GetPageId(), false);
-    bufferPoolManager_->UnpinPage(leaf_->GetPageId(), false);
+  // read the next leaf while the keys of this one are processed
+  void PrefetchNext() {
+    if (leaf_->GetNextPageId() != INVALID_PAGE_ID) {
+      bufferPoolManager_->Prefetch(leaf_->GetNextPageId(), 1);
+    }
   }
   int index_;
+  MappingType item_;
+  ReadPageGuard guard_; // pin and read latch of leaf_
   B_PLUS_TREE_LEAF_PAGE_TYPE *leaf_;
   BufferPoolManager *bufferPoolManager_;
 };
@@ -0,0 +1,98 @@
+/**
+ * integer_key.h
+ *
+ * Key used for indexing a single integer column (INTEGER, BIGINT, ...)
+ *
+ * The value is stored big-endian with its sign bit flipped, so that the order
+ * of the bytes is the order of the values: IntegerComparator compares them
+ * as one unsigned integer, inlined, where GenericComparator deserializes both
+ * keys through the key schema on every comparison.
+ */
+#pragma once
+
+#include <cassert>
+#include <cstring>
+#include <ostream>
+#include <type_traits>
+
+#include "table/tuple.h"
+
+namespace cmudb {
+template <typename T> class IntegerKey {
+  static_assert(std::is_integral<T>::value && std::is_signed<T>::value,
+                "IntegerKey holds a signed integer");
+  typedef typename std::make_unsigned<T>::type Bits;
+
+public:
+  // the key tuple has the integer column only
+  inline void SetFromKey(const Tuple &tuple) {
+    T value;
+    memcpy(&value, tuple.GetData(), sizeof(T));
+    SetValue(value);
+  }
+
+  // NOTE: for test purpose only
+  inline void SetFromInteger(int64_t key) { SetValue(static_cast<T>(key)); }
+
+  inline void SetValue(T value) {
+    Bits bits = static_cast<Bits>(value) ^ SIGN_BIT;
+    for (size_t i = sizeof(T); i-- > 0; bits >>= 8) {
+      data[i] = static_cast<unsigned char>(bits);
+    }
+  }
+
+  // the bytes as one unsigned integer, ordered as the values
+  constexpr Bits GetBits() const {
+    Bits bits = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+      bits = static_cast<Bits>(bits << 8 | data[i]);
+    }
+    return bits;
+  }
+
+  constexpr T GetValue() const { return static_cast<T>(GetBits() ^ SIGN_BIT); }
+
+  // NOTE: for test purpose only
+  inline int64_t ToString() const { return GetValue(); }
+
+  // NOTE: for test purpose only
+  friend std::ostream &operator<<(std::ostream &os, const IntegerKey &key) {
+    os << key.ToString();
+    return os;
+  }
+
+  unsigned char data[sizeof(T)];
+
+private:
+  static constexpr Bits SIGN_BIT = Bits(1) << (sizeof(T) * 8 - 1);
+};
+
+/**
+ * Function object returns -1, 0 or 1 as lhs is below, equal to or above rhs,
+ * like GenericComparator, without a branch
+ */
+template <typename T> class IntegerComparator {
+public:
+  constexpr int operator()(const IntegerKey<T> &lhs,
+                           const IntegerKey<T> &rhs) const {
+    return (lhs.GetBits() > rhs.GetBits()) - (lhs.GetBits() < rhs.GetBits());
+  }
+
+  // built as GenericComparator is, the key schema if any must be a single
+  // integer column of the size of T, see SetFromKey
+  explicit IntegerComparator(Schema *key_schema = nullptr) {
+    assert(key_schema == nullptr ||
+           (key_schema->GetColumnCount() == 1 &&
+            IsIntegerColumn(key_schema->GetType(0)) &&
+            key_schema->GetLength(0) == static_cast<int32_t>(sizeof(T))));
+    (void)key_schema;
+  }
+
+private:
+  static constexpr bool IsIntegerColumn(TypeId type) {
+    return type == TINYINT || type == SMALLINT || type == INTEGER ||
+           type == BIGINT;
+  }
+};
+
+} // namespace cmudb
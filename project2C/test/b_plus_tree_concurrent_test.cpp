@@ -3,6 +3,7 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdio>
 #include <functional>
@@ -13,6 +14,7 @@
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
 #include "index/b_plus_tree.h"
+#include "page/header_page.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
 
@@ -823,4 +825,188 @@ TEST(BPlusTreeConcurrentTest, MixTest3) {
   remove("test.log");
 }
 
+TEST(BPlusTreeConcurrentTest, SwizzleTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<16> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  // the tree does not fit, children get unswizzled by evictions
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  bpm->SetSwizzling(20);
+  bpm->RunPageCleaner(0.2, 0.1);
+  // create b+ tree
+  BPlusTree<GenericKey<16>, RID, GenericComparator<16>> tree("foo_pk", bpm,
+                                                             comparator);
+  GenericKey<16> index_key;
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void) header_page;
+  std::vector<int64_t> keys, deleted;
+  int scale = 4000;
+  for (int i = 1; i <= scale; ++i) {
+    keys.push_back(i);
+  }
+  std::random_shuffle(keys.begin(), keys.end());
+  for (int i = 1; i <= scale / 2; ++i) {
+    deleted.push_back(keys.back());
+    keys.pop_back();
+  }
+  LaunchParallelTest(4, InsertHelperSplit, std::ref(tree), std::ref(deleted), 4);
+  // concurrent insert and delete, with readers swizzling and pages written
+  // back all along
+  std::atomic<bool> done(false);
+  std::thread flusher([&] {
+    while (!done) {
+      bpm->FlushAllPages();
+    }
+  });
+  std::thread t0(InsertAndGetHelper, std::ref(tree), keys, 0);
+  std::thread t1(DeleteAndGetHelper, std::ref(tree), deleted, 0);
+  t0.join();
+  t1.join();
+  done = true;
+  flusher.join();
+  EXPECT_TRUE(tree.Check(true));
+  EXPECT_LT(0, bpm->GetStats().swizzles);
+
+  // what reached the disk has no swizzled ids in it
+  bpm->StopPageCleaner();
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  bpm->FlushAllPages();
+  page_id_t root_page_id;
+  header_page = bpm->FetchPage(HEADER_PAGE_ID);
+  EXPECT_TRUE(static_cast<HeaderPage *>(header_page)
+                      ->GetRootId("foo_pk", root_page_id));
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+  BufferPoolManager *fresh = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<16>, RID, GenericComparator<16>> reopened(
+          "foo_pk", fresh, comparator, root_page_id);
+  for (auto key : keys) {
+    std::vector<RID> rids;
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(reopened.GetValue(index_key, rids));
+  }
+  EXPECT_TRUE(reopened.Check(true));
+
+  delete fresh;
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, BLinkTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<16> comparator(key_schema);
+
+  // uncompressed pages, then compressed ones, see BPlusTree (8)
+  for (bool compress : {false, true}) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+    // create b+ tree in B-link mode
+    BPlusTree<GenericKey<16>, RID, GenericComparator<16>> tree(
+            "foo_pk", bpm, comparator, INVALID_PAGE_ID, true, 16, compress);
+
+    // create and fetch header_page
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(page_id);
+    (void) header_page;
+    std::vector<int64_t> keys, stay;
+    int scale = 10000;
+    for (int i = 1; i <= scale; ++i) {
+      (i % 4 == 0 ? stay : keys).push_back(i);
+    }
+    std::random_shuffle(keys.begin(), keys.end());
+    LaunchParallelTest(4, InsertHelperSplit, std::ref(tree), std::ref(stay), 4);
+
+    // the keys which stay are found all along while pages split and empty
+    std::atomic<bool> done(false);
+    std::thread reader([&] {
+      GenericKey<16> index_key;
+      while (!done) {
+        for (auto key : stay) {
+          std::vector<RID> rids;
+          index_key.SetFromInteger(key);
+          EXPECT_TRUE(tree.GetValue(index_key, rids));
+          EXPECT_EQ(rids[0].GetSlotNum(), key);
+        }
+      }
+    });
+    LaunchParallelTest(4, InsertHelperSplit, std::ref(tree), std::ref(keys), 4);
+    LaunchParallelTest(4, DeleteHelperSplit, std::ref(tree), std::ref(keys), 4);
+    done = true;
+    reader.join();
+    EXPECT_TRUE(tree.Check(true));
+
+    int64_t size = 0;
+    for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+      EXPECT_EQ((*iterator).second.GetSlotNum() % 4, 0);
+      size = size + 1;
+    }
+    EXPECT_EQ(size, scale / 4);
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete disk_manager;
+    delete bpm;
+    remove("test.db");
+    remove("test.log");
+  }
+  delete key_schema;
+}
+
+/*
+ * Random inserts of 40000 keys from 1, 4 and 32 threads; writers only write
+ * latch the leaves they change unless those split. Only reports numbers, run
+ * it with --gtest_also_run_disabled_tests.
+ */
+TEST(BPlusTreeConcurrentTest, DISABLED_InsertScalabilityBenchmark) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<16> comparator(key_schema);
+  std::vector<int64_t> keys;
+  int scale = 40000;
+  for (int i = 1; i <= scale; ++i) {
+    keys.push_back(i);
+  }
+  std::random_shuffle(keys.begin(), keys.end());
+
+  for (int num_threads : {1, 4, 32}) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(4000, disk_manager);
+    // create b+ tree
+    BPlusTree<GenericKey<16>, RID, GenericComparator<16>> tree("foo_pk", bpm,
+                                                               comparator);
+    // create and fetch header_page
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(page_id);
+    (void) header_page;
+
+    auto start = std::chrono::steady_clock::now();
+    LaunchParallelTest(num_threads, InsertHelperSplit, std::ref(tree),
+                       std::ref(keys), num_threads);
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+    printf("insert threads: %2d  %10.0f ops/s\n", num_threads,
+           scale / elapsed.count());
+
+    EXPECT_TRUE(tree.Check(true));
+    int64_t size = 0;
+    for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+      size = size + 1;
+    }
+    EXPECT_EQ(size, scale);
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete disk_manager;
+    delete bpm;
+    remove("test.db");
+    remove("test.log");
+  }
+  delete key_schema;
+}
+
 } // namespace cmudb
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
@@ -366,5 +367,448 @@ TEST(BPlusTreeInsertTests, InsertRandom) {
   remove("test.log");
 }
 
+TEST(BPlusTreeInsertTests, BulkLoadTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void) header_page;
+
+  // even keys only, each twice
+  int64_t scale = 10000;
+  int64_t next_key = 0;
+  auto next = [&](std::pair<GenericKey<8>, RID> &item) {
+    if (next_key >= scale) {
+      return false;
+    }
+    int64_t key = next_key / 2 * 2;
+    item.first.SetFromInteger(key);
+    item.second.Set((int32_t) (key >> 32), key & 0xFFFFFFFF);
+    next_key++;
+    return true;
+  };
+  EXPECT_TRUE(tree.BulkLoad(next, 0.7));
+  ASSERT_TRUE(tree.Check(true));
+  // only an empty tree is loaded
+  next_key = 0;
+  EXPECT_FALSE(tree.BulkLoad(next));
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 2 == 0, tree.GetValue(index_key, rids));
+    if (key % 2 == 0) {
+      EXPECT_EQ(rids[0].GetSlotNum(), key);
+    }
+  }
+  int64_t current_key = 0;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key += 2;
+  }
+  EXPECT_EQ(current_key, scale);
+
+  // the loaded tree takes the odd keys and loses them again
+  for (int64_t key = 1; key < scale; key += 2) {
+    rid.Set((int32_t) (key >> 32), key & 0xFFFFFFFF);
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, rid, transaction));
+  }
+  ASSERT_TRUE(tree.Check(true));
+  for (int64_t key = 0; key < scale; key += 3) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  ASSERT_TRUE(tree.Check(true));
+  for (int64_t key = 0; key < scale; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 3 != 0, tree.GetValue(index_key, rids));
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  delete key_schema;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeInsertTests, BulkLoadLevelsTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  GenericKey<8> index_key;
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void) header_page;
+
+  int64_t scale = 0;
+  int64_t next_key = 0;
+  auto next = [&](std::pair<GenericKey<8>, RID> &item) {
+    if (next_key >= scale) {
+      return false;
+    }
+    item.first.SetFromInteger(next_key);
+    item.second.Set((int32_t) (next_key >> 32), next_key & 0xFFFFFFFF);
+    next_key++;
+    return true;
+  };
+  // from a single leaf to three levels, with every shape of the right edge;
+  // one name, the header page only holds a few records
+  for (scale = 1; scale < 100000; scale = scale * 3 / 2 + 7) {
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                             comparator);
+    next_key = 0;
+    EXPECT_TRUE(tree.BulkLoad(next, 0.5));
+    ASSERT_TRUE(tree.Check(true));
+    int64_t current_key = 0;
+    for (auto iterator = tree.Begin(); iterator.isEnd() == false;
+         ++iterator) {
+      EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+      current_key++;
+    }
+    EXPECT_EQ(current_key, scale);
+  }
+
+  // unsorted input leaves the tree empty, without any page left pinned
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  scale = 20000;
+  next_key = 0;
+  auto unsorted = [&](std::pair<GenericKey<8>, RID> &item) {
+    if (next_key == scale - 1) {
+      next_key = 0;
+    }
+    return next(item);
+  };
+  EXPECT_THROW(tree.BulkLoad(unsorted), Exception);
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_TRUE(bpm->CheckAllUnpined());
+  next_key = 0;
+  EXPECT_TRUE(tree.BulkLoad(next));
+  ASSERT_TRUE(tree.Check(true));
+  std::vector<RID> rids;
+  index_key.SetFromInteger(scale - 1);
+  EXPECT_TRUE(tree.GetValue(index_key, rids));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  delete key_schema;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeInsertTests, BulkLoadFromFileTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void) header_page;
+
+  std::vector<int64_t> keys;
+  int scale = 10000;
+  for (int i = 0; i < scale; ++i) {
+    keys.push_back(i + 1);
+  }
+  // with a few duplicates
+  keys.insert(keys.end(), keys.begin(), keys.begin() + 100);
+  std::random_shuffle(keys.begin(), keys.end());
+  {
+    std::ofstream file("keys.txt");
+    for (auto key : keys) {
+      file << key << "\n";
+    }
+  }
+  // runs of 1000 keys go through disk
+  EXPECT_TRUE(tree.BulkLoadFromFile("keys.txt", 1.0, 1000));
+  ASSERT_TRUE(tree.Check(true));
+
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, rids));
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+  int64_t current_key = 1;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key++;
+  }
+  EXPECT_EQ(current_key, scale + 1);
+  // no run left behind
+  EXPECT_FALSE(std::ifstream("keys.txt.run0").good());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  delete key_schema;
+  remove("keys.txt");
+  remove("test.db");
+  remove("test.log");
+}
+
+// a file that is missing or is not all keys loads nothing
+TEST(BPlusTreeInsertTests, BulkLoadFromBadFileTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void) header_page;
+
+  remove("missing.txt");
+  EXPECT_FALSE(tree.BulkLoadFromFile("missing.txt"));
+  EXPECT_TRUE(tree.IsEmpty());
+
+  {
+    std::ofstream file("keys.txt");
+    file << "1\n2\n3\nfour\n5\n";
+  }
+  EXPECT_FALSE(tree.BulkLoadFromFile("keys.txt", 1.0, 0));
+  // runs of 1 key, spilled before the bad one
+  EXPECT_FALSE(tree.BulkLoadFromFile("keys.txt", 1.0, 1));
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_FALSE(std::ifstream("keys.txt.run0").good());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  delete key_schema;
+  remove("keys.txt");
+  remove("test.db");
+  remove("test.log");
+}
+
+// bigint keys in 64 byte keys, stored whole or only their first 8 bytes
+TEST(BPlusTreeInsertTests, KeySizeTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(30, disk_manager);
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> full("foo_pk", bpm,
+                                                             comparator);
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> truncated(
+          "bar_pk", bpm, comparator, INVALID_PAGE_ID, false, 8);
+  GenericKey<64> index_key;
+  RID rid;
+  Transaction *transaction = new Transaction(0);
+
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void) header_page;
+
+  int64_t scale = 2000;
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= scale; key++) {
+    keys.push_back(key);
+  }
+  std::random_shuffle(keys.begin(), keys.end());
+  for (auto key : keys) {
+    rid.Set((int32_t) (key >> 32), key & 0xFFFFFFFF);
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(full.Insert(index_key, rid, transaction));
+    EXPECT_TRUE(truncated.Insert(index_key, rid, transaction));
+  }
+  ASSERT_TRUE(full.Check(true));
+  ASSERT_TRUE(truncated.Check(true));
+
+  // pages read from disk by point queries and a scan of a tree
+  auto misses = [&](BPlusTree<GenericKey<64>, RID, GenericComparator<64>> &tree) {
+    size_t before = bpm->GetStats().misses;
+    std::vector<RID> rids;
+    for (auto key : keys) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.GetValue(index_key, rids));
+      EXPECT_EQ(rids[0].GetSlotNum(), key);
+    }
+    int64_t current_key = 1;
+    for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+      EXPECT_EQ((*iterator).first.ToString(), current_key);
+      EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+      current_key++;
+    }
+    EXPECT_EQ(current_key, scale + 1);
+    return bpm->GetStats().misses - before;
+  };
+  size_t fullMisses = misses(full);
+  size_t truncatedMisses = misses(truncated);
+  EXPECT_LT(truncatedMisses * 2, fullMisses);
+
+  // what a page would not keep is refused
+  index_key.SetFromInteger(scale + 1);
+  index_key.data[8] = 1;
+  EXPECT_THROW(truncated.Insert(index_key, rid, transaction), Exception);
+  EXPECT_TRUE(full.Insert(index_key, rid, transaction));
+
+  // and the truncated tree shrinks as the other one does
+  for (int64_t key = 1; key <= scale; key += 2) {
+    index_key.SetFromInteger(key);
+    truncated.Remove(index_key, transaction);
+  }
+  ASSERT_TRUE(truncated.Check(true));
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= scale; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 2 == 0, truncated.GetValue(index_key, rids));
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  delete key_schema;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeInsertTests, CompressedKeysTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint, b bigint");
+  GenericComparator<64> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(30, disk_manager);
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> full(
+          "foo_pk", bpm, comparator, INVALID_PAGE_ID, true);
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> compressed(
+          "bar_pk", bpm, comparator, INVALID_PAGE_ID, true, 64, true);
+  EXPECT_THROW((BPlusTree<GenericKey<64>, RID, GenericComparator<64>>(
+          "baz_pk", bpm, comparator, INVALID_PAGE_ID, false, 64, true)),
+               Exception);
+  GenericKey<64> index_key;
+  RID rid;
+  Transaction *transaction = new Transaction(0);
+
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void) header_page;
+
+  // keys of one tenant share their first column, a prefix of 8 bytes
+  auto setKey = [&](int64_t tenant, int64_t key) {
+    memset(index_key.data, 0, sizeof(index_key.data));
+    memcpy(index_key.data, &tenant, sizeof(int64_t));
+    memcpy(index_key.data + sizeof(int64_t), &key, sizeof(int64_t));
+  };
+  const int64_t tenant = 0x0123456789ABCDEF;
+  int64_t scale = 2000;
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= scale; key++) {
+    keys.push_back(key);
+  }
+  std::random_shuffle(keys.begin(), keys.end());
+  for (auto key : keys) {
+    rid.Set(0, key);
+    setKey(tenant, key);
+    EXPECT_TRUE(full.Insert(index_key, rid, transaction));
+    EXPECT_TRUE(compressed.Insert(index_key, rid, transaction));
+  }
+  setKey(tenant, keys[0]);
+  EXPECT_FALSE(compressed.Insert(index_key, rid, transaction));
+  ASSERT_TRUE(full.Check(true));
+  ASSERT_TRUE(compressed.Check(true));
+
+  // pages read from disk by point queries and a scan of a tree
+  auto misses = [&](BPlusTree<GenericKey<64>, RID, GenericComparator<64>> &tree) {
+    size_t before = bpm->GetStats().misses;
+    std::vector<RID> rids;
+    for (auto key : keys) {
+      rids.clear();
+      setKey(tenant, key);
+      EXPECT_TRUE(tree.GetValue(index_key, rids));
+      EXPECT_EQ(rids[0].GetSlotNum(), key);
+    }
+    int64_t current_key = 1;
+    for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+      EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+      current_key++;
+    }
+    EXPECT_EQ(current_key, scale + 1);
+    return bpm->GetStats().misses - before;
+  };
+  size_t fullMisses = misses(full);
+  size_t compressedMisses = misses(compressed);
+  EXPECT_LT(compressedMisses * 2, fullMisses);
+
+  // keys without the prefix of the pages they go to, and wider ones
+  for (int64_t key = 1; key <= scale; key += 3) {
+    rid.Set(1, key);
+    setKey(key % 2 == 0 ? 1 : tenant, key << 40);
+    EXPECT_TRUE(compressed.Insert(index_key, rid, transaction));
+  }
+  for (int64_t key = 1; key <= scale; key += 2) {
+    setKey(tenant, key);
+    compressed.Remove(index_key, transaction);
+  }
+  ASSERT_TRUE(compressed.Check(true));
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= scale; key++) {
+    setKey(tenant, key);
+    EXPECT_EQ(key % 2 == 0, compressed.GetValue(index_key, rids));
+    if (key % 3 == 1) {
+      setKey(key % 2 == 0 ? 1 : tenant, key << 40);
+      rids.clear();
+      EXPECT_TRUE(compressed.GetValue(index_key, rids));
+      EXPECT_EQ(rids[0].GetPageId(), 1);
+      EXPECT_EQ(rids[0].GetSlotNum(), key);
+    }
+  }
+  int64_t count = 0;
+  GenericKey<64> previous;
+  for (auto iterator = compressed.Begin(); iterator.isEnd() == false;
+       ++iterator) {
+    if (count > 0) {
+      EXPECT_LT(comparator(previous, (*iterator).first), 0);
+    }
+    previous = (*iterator).first;
+    count++;
+  }
+  EXPECT_EQ(count, scale / 2 + (scale + 2) / 3);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  delete key_schema;
+  remove("test.db");
+  remove("test.log");
+}
 
 } // namespace cmudb
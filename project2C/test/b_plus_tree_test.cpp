@@ -3,9 +3,12 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <iostream>
+#include <random>
 #include <sstream>
+#include <thread>
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
@@ -183,4 +186,219 @@ TEST(BPlusTreeTests, RandomTest) {
   remove("test.db");
   remove("test.log");
 }
+
+/*
+ * Random point lookups on a tree which fits in the buffer pool, from 1 and 4
+ * threads, with swizzling off and on. Only reports numbers, run it with
+ * --gtest_also_run_disabled_tests. Swizzling saves one page table probe per
+ * internal level, which is small next to the leaf search: expect the two to
+ * be within noise of each other on a tree this shallow.
+ */
+TEST(BPlusTreeTests, DISABLED_SwizzleBenchmark) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  const int64_t scale = 20000;
+  const int lookups = 1 << 16;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(4096, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  tree.openCheck = false;
+  Transaction *transaction = new Transaction(0);
+  GenericKey<8> index_key;
+  RID rid;
+  for (int64_t key = 1; key <= scale; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  for (int swizzling = 0; swizzling <= 1; ++swizzling) {
+    bpm->SetSwizzling(swizzling ? 2048 : 0);
+    for (int num_threads : {1, 4}) {
+      auto lookup = [&](int seed) {
+        std::mt19937 engine(seed);
+        std::uniform_int_distribution<int64_t> distribution(1, scale);
+        GenericKey<8> key;
+        std::vector<RID> result;
+        for (int i = 0; i < lookups / num_threads; ++i) {
+          key.SetFromInteger(distribution(engine));
+          result.clear();
+          EXPECT_TRUE(tree.GetValue(key, result));
+        }
+      };
+      // first round swizzles what it can
+      lookup(0);
+      std::vector<std::thread> threads;
+      auto start = std::chrono::steady_clock::now();
+      for (int tid = 0; tid < num_threads; ++tid) {
+        threads.push_back(std::thread(lookup, tid + 1));
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double, std::nano> elapsed =
+              std::chrono::steady_clock::now() - start;
+      printf("swizzling %-3s threads: %d  %8.1f ns/lookup\n",
+             swizzling ? "on" : "off", num_threads,
+             elapsed.count() * num_threads / lookups);
+    }
+  }
+  printf("%s", bpm->GetStats().ToString().c_str());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+  delete key_schema;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * Bigint keys, negative ones too, in pages searched as int64_t
+ * (GenericKey<8>), through the comparator (GenericKey<16>), and through the
+ * inlined comparators of IntegerKey: every key is found, in order, and keys
+ * between them are not.
+ */
+TEST(BPlusTreeTests, IntegerSearchTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  Schema *int_schema = ParseCreateStatement("a integer");
+  GenericComparator<8> comparator8(key_schema);
+  GenericComparator<16> comparator16(key_schema);
+  const int64_t scale = 4000;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree8("foo_pk", bpm,
+                                                            comparator8);
+  BPlusTree<GenericKey<16>, RID, GenericComparator<16>> tree16(
+          "bar_pk", bpm, comparator16);
+  BPlusTree<IntegerKey<int32_t>, RID, IntegerComparator<int32_t>> tree32(
+          "baz_pk", bpm, IntegerComparator<int32_t>(int_schema));
+  BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> tree64(
+          "qux_pk", bpm, IntegerComparator<int64_t>(key_schema));
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  Transaction *transaction = new Transaction(0);
+
+  std::vector<int64_t> keys;
+  for (int64_t key = -scale / 2; key < scale / 2; key++) {
+    keys.push_back(key * 3);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+
+  auto run = [&](auto &tree, auto index_key) {
+    RID rid;
+    for (auto key : keys) {
+      rid.Set(0, key & 0xFFFF);
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.Insert(index_key, rid, transaction));
+    }
+    EXPECT_TRUE(tree.Check(true));
+    int64_t current_key = -scale / 2 * 3;
+    for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+      EXPECT_EQ((*iterator).first.ToString(), current_key);
+      current_key += 3;
+    }
+    EXPECT_EQ(current_key, scale / 2 * 3);
+
+    std::vector<RID> result;
+    for (int64_t key = -scale / 2 * 3 - 1; key <= scale / 2 * 3; key++) {
+      index_key.SetFromInteger(key);
+      bool stored = key >= -scale / 2 * 3 && key < scale / 2 * 3 &&
+                    key % 3 == 0;
+      EXPECT_EQ(tree.GetValue(index_key, result), stored);
+      if (stored) {
+        EXPECT_EQ(result[0].GetSlotNum(), key & 0xFFFF);
+      }
+    }
+  };
+  run(tree8, GenericKey<8>());
+  run(tree16, GenericKey<16>());
+  run(tree32, IntegerKey<int32_t>());
+  run(tree64, IntegerKey<int64_t>());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+  delete key_schema;
+  delete int_schema;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * Random point lookups of the keys of IntegerSearchTest, a third of them
+ * stored, in each kind of tree. Only reports numbers, run it with
+ * --gtest_also_run_disabled_tests.
+ */
+TEST(BPlusTreeTests, DISABLED_IntegerSearchBenchmark) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  Schema *int_schema = ParseCreateStatement("a integer");
+  GenericComparator<8> comparator8(key_schema);
+  GenericComparator<16> comparator16(key_schema);
+  const int64_t scale = 20000;
+  const int lookups = 1 << 17;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(4096, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree8("foo_pk", bpm,
+                                                            comparator8);
+  BPlusTree<GenericKey<16>, RID, GenericComparator<16>> tree16(
+          "bar_pk", bpm, comparator16);
+  BPlusTree<IntegerKey<int32_t>, RID, IntegerComparator<int32_t>> tree32(
+          "baz_pk", bpm, IntegerComparator<int32_t>(int_schema));
+  BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>> tree64(
+          "qux_pk", bpm, IntegerComparator<int64_t>(key_schema));
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  Transaction *transaction = new Transaction(0);
+
+  std::vector<int64_t> keys;
+  for (int64_t key = -scale / 2; key < scale / 2; key++) {
+    keys.push_back(key * 3);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+
+  auto run = [&](auto &tree, auto index_key, const char *name) {
+    RID rid;
+    for (auto key : keys) {
+      rid.Set(0, key & 0xFFFF);
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, rid, transaction);
+    }
+    std::mt19937 engine(1);
+    std::uniform_int_distribution<int64_t> distribution(-scale / 2 * 3,
+                                                        scale / 2 * 3);
+    std::vector<RID> result;
+    int found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i) {
+      index_key.SetFromInteger(distribution(engine));
+      found += tree.GetValue(index_key, result);
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+    printf("%-18s %8.1f ns/lookup, %d found\n", name,
+           elapsed.count() / lookups, found);
+  };
+  run(tree8, GenericKey<8>(), "integer search");
+  run(tree16, GenericKey<16>(), "comparator");
+  run(tree32, IntegerKey<int32_t>(), "IntegerKey<int32>");
+  run(tree64, IntegerKey<int64_t>(), "IntegerKey<int64>");
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+  delete key_schema;
+  delete int_schema;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
 } // namespace cmudb
@@ -0,0 +1,194 @@
+/**
+ * disk_extendible_hash_table_test.cpp
+ */
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "index/disk_extendible_hash_table.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(DiskExtendibleHashTableTest, InsertTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  DiskExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+          "foo_pk", bpm, comparator);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  GenericKey<8> index_key;
+  RID rid;
+  std::vector<RID> rids;
+  index_key.SetFromInteger(1);
+  EXPECT_EQ(false, table.GetValue(index_key, rids));
+
+  const int64_t num_keys = 10000;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rid.Set((int32_t)(key >> 32), key & 0xFFFFFFFF);
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, table.Insert(index_key, rid));
+  }
+  // only unique keys
+  index_key.SetFromInteger(42);
+  EXPECT_EQ(false, table.Insert(index_key, rid));
+  // the directories had to grow
+  EXPECT_LT(0, table.GetGlobalDepth());
+
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, table.GetValue(index_key, rids));
+    EXPECT_EQ(1, rids.size());
+    EXPECT_EQ(key & 0xFFFFFFFF, rids[0].GetSlotNum());
+  }
+  index_key.SetFromInteger(num_keys);
+  EXPECT_EQ(false, table.GetValue(index_key, rids));
+  EXPECT_EQ(true, table.Check());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskExtendibleHashTableTest, DeleteTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  DiskExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+          "foo_pk", bpm, comparator);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  GenericKey<8> index_key;
+  RID rid;
+  std::vector<RID> rids;
+  const int64_t num_keys = 10000;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rid.Set((int32_t)(key >> 32), key & 0xFFFFFFFF);
+    index_key.SetFromInteger(key);
+    table.Insert(index_key, rid);
+  }
+
+  // odd keys go
+  for (int64_t key = 1; key < num_keys; key += 2) {
+    index_key.SetFromInteger(key);
+    table.Remove(index_key);
+  }
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 2 == 0, table.GetValue(index_key, rids));
+  }
+  EXPECT_EQ(true, table.Check());
+
+  // then the rest, buckets merge back into one
+  for (int64_t key = 0; key < num_keys; key += 2) {
+    index_key.SetFromInteger(key);
+    table.Remove(index_key);
+  }
+  EXPECT_EQ(0, table.GetGlobalDepth());
+  EXPECT_EQ(true, table.Check());
+
+  // and grows again
+  for (int64_t key = 0; key < num_keys; key++) {
+    rid.Set((int32_t)(key >> 32), key & 0xFFFFFFFF);
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, table.Insert(index_key, rid));
+  }
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, table.GetValue(index_key, rids));
+  }
+  EXPECT_EQ(true, table.Check());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// lookups of keys that stay while other threads insert and remove theirs
+TEST(DiskExtendibleHashTableTest, ConcurrentTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  DiskExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+          "foo_pk", bpm, comparator);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  const int64_t num_keys = 4000;
+  GenericKey<8> index_key;
+  RID rid;
+  // multiples of 4 stay
+  for (int64_t key = 0; key < num_keys; key += 4) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    table.Insert(index_key, rid);
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 1; tid < 4; tid++) {
+    threads.push_back(std::thread([&table, tid] {
+      GenericKey<8> index_key;
+      RID rid;
+      std::vector<RID> rids;
+      for (int run = 0; run < 5; run++) {
+        for (int64_t key = tid; key < num_keys; key += 4) {
+          rid.Set(0, key);
+          index_key.SetFromInteger(key);
+          EXPECT_EQ(true, table.Insert(index_key, rid));
+        }
+        for (int64_t key = 0; key < num_keys; key += 4) {
+          index_key.SetFromInteger(key);
+          EXPECT_EQ(true, table.GetValue(index_key, rids));
+          EXPECT_EQ(key, rids[0].GetSlotNum());
+        }
+        for (int64_t key = tid; key < num_keys; key += 4) {
+          index_key.SetFromInteger(key);
+          table.Remove(index_key);
+        }
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 4 == 0, table.GetValue(index_key, rids));
+  }
+  EXPECT_EQ(true, table.Check());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb
@@ -0,0 +1,83 @@
+/**
+ * integer_key_test.cpp
+ */
+
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "index/integer_key.h"
+#include "vtable/virtual_table.h"
+
+namespace cmudb {
+
+// -1, 0 or 1 as a is below, equal to or above b
+static int Sign(int64_t a, int64_t b) { return (a > b) - (a < b); }
+
+/*
+ * Every value comes back as it was set, and keys order as their values, by
+ * the comparator and by their bytes alike.
+ */
+template <typename T> static void CheckRoundTripAndOrder() {
+  const std::vector<int64_t> values = {
+          std::numeric_limits<T>::min(), std::numeric_limits<T>::min() + 1,
+          -65536, -257, -256, -255, -1, 0, 1, 255, 256, 257, 65536,
+          std::numeric_limits<T>::max() - 1, std::numeric_limits<T>::max()};
+  IntegerComparator<T> comparator;
+  IntegerKey<T> lhs, rhs;
+  for (int64_t a : values) {
+    lhs.SetFromInteger(a);
+    EXPECT_EQ(lhs.GetValue(), a);
+    EXPECT_EQ(lhs.ToString(), a);
+    for (int64_t b : values) {
+      rhs.SetFromInteger(b);
+      EXPECT_EQ(comparator(lhs, rhs), Sign(a, b)) << a << " " << b;
+      int bytes = memcmp(lhs.data, rhs.data, sizeof(T));
+      EXPECT_EQ((bytes > 0) - (bytes < 0), Sign(a, b)) << a << " " << b;
+    }
+  }
+}
+
+TEST(IntegerKeyTests, Int32Test) { CheckRoundTripAndOrder<int32_t>(); }
+
+TEST(IntegerKeyTests, Int64Test) { CheckRoundTripAndOrder<int64_t>(); }
+
+/*
+ * A key built from a key tuple holds the value of its integer column
+ */
+TEST(IntegerKeyTests, SetFromKeyTest) {
+  Schema *int_schema = ParseCreateStatement("a integer");
+  Schema *bigint_schema = ParseCreateStatement("a bigint");
+  IntegerComparator<int32_t> comparator32(int_schema);
+  IntegerComparator<int64_t> comparator64(bigint_schema);
+  IntegerKey<int32_t> key32, previous32;
+  IntegerKey<int64_t> key64, previous64;
+  // the smallest values are NULL to the type system, left out
+  const std::vector<int64_t> values = {-2147483647, -1, 0, 1, 2147483647};
+  for (size_t i = 0; i < values.size(); i++) {
+    std::vector<Value> int_value{
+            Value(TypeId::INTEGER, static_cast<int32_t>(values[i]))};
+    key32.SetFromKey(Tuple(int_value, int_schema));
+    EXPECT_EQ(key32.GetValue(), values[i]);
+    const int64_t wide = values[i] * (1 << 20);
+    std::vector<Value> bigint_value{Value(TypeId::BIGINT, wide)};
+    key64.SetFromKey(Tuple(bigint_value, bigint_schema));
+    EXPECT_EQ(key64.GetValue(), wide);
+    if (i > 0) {
+      EXPECT_LT(comparator32(previous32, key32), 0);
+      EXPECT_LT(comparator64(previous64, key64), 0);
+    }
+    previous32 = key32;
+    previous64 = key64;
+  }
+#ifndef NDEBUG
+  // the schema must be one integer column of the size of the key
+  EXPECT_DEATH(IntegerComparator<int32_t>{bigint_schema}, "");
+  EXPECT_DEATH(IntegerComparator<int64_t>{int_schema}, "");
+#endif
+  delete int_schema;
+  delete bigint_schema;
+}
+
+} // namespace cmudb
@@ -0,0 +1,420 @@
+/**
+ * async_disk_manager.cpp
+ */
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "common/logger.h"
+#include "disk/async_disk_manager.h"
+
+namespace cmudb {
+
+// O_DIRECT wants buffers, offsets and lengths aligned to the logical block
+// size of the device, pages are multiples of it
+static const size_t DIRECT_IO_ALIGNMENT = 512;
+
+static size_t RoundUp(size_t size, size_t unit) {
+  return (size + unit - 1) / unit * unit;
+}
+
+static char *AlignedAlloc(size_t size) {
+  void *buf = nullptr;
+  if (posix_memalign(&buf, DIRECT_IO_ALIGNMENT, size) != 0) {
+    throw std::bad_alloc();
+  }
+  return static_cast<char *>(buf);
+}
+
+static bool IsAligned(const char *buf) {
+  return reinterpret_cast<uintptr_t>(buf) % DIRECT_IO_ALIGNMENT == 0;
+}
+
+/*
+ * Open name with O_DIRECT, or buffered when the file system does not
+ * support it (e.g. tmpfs), direct tells which one it was
+ */
+static int OpenFile(const std::string &name, bool &direct) {
+  int fd = open(name.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+  direct = fd >= 0;
+  if (fd < 0) {
+    fd = open(name.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  return fd;
+}
+
+// one I/O in flight, user_data of its submission queue entry
+struct AsyncDiskManager::Request {
+  std::function<void(ssize_t)> done;
+  char *target;  // buffer of the caller
+  char *bounce;  // aligned copy of target if target is not aligned
+  bool write;
+  struct iovec iov;
+};
+
+/**
+ * Constructor: open the db and log files again, directly, in place of the
+ * buffered descriptors of DiskManager, and set up the ring and its
+ * completion thread
+ */
+AsyncDiskManager::AsyncDiskManager(const std::string &db_file,
+                                   unsigned queue_depth)
+    : DiskManager(db_file), log_size_(0) {
+  bool log_direct = false;
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+  db_fd_ = OpenFile(file_name_, direct_);
+  // nothing was written through the log stream yet
+  log_io_.close();
+  log_fd_ = log_name_.empty() ? -1 : OpenFile(log_name_, log_direct);
+  if (db_fd_ < 0 || log_fd_ < 0) {
+    LOG_DEBUG("can't open db or log file");
+  }
+  if (!direct_ || !log_direct) {
+    LOG_DEBUG("O_DIRECT not supported, using the page cache");
+  }
+  log_staging_ = AlignedAlloc(LOG_BUFFER_SIZE + 2 * DIRECT_IO_ALIGNMENT);
+  if (SetupRing(queue_depth)) {
+    reaper_thread_ = new std::thread([&] { ReapCompletions(); });
+  }
+  // the partial last block of an existing log is rewritten by the next flush
+  int log_size = log_name_.empty() ? -1 : GetFileSize(log_name_);
+  if (log_size > 0) {
+    log_size_ = log_size;
+    const off_t block_start = log_size_ / DIRECT_IO_ALIGNMENT *
+                              DIRECT_IO_ALIGNMENT;
+    if (block_start < log_size_) {
+      SubmitAndWait(false, log_fd_, log_staging_, DIRECT_IO_ALIGNMENT,
+                    block_start);
+    }
+  }
+}
+
+AsyncDiskManager::~AsyncDiskManager() {
+  if (IsUring()) {
+    std::unique_lock<std::mutex> lck(submit_latch_);
+    submit_cv_.wait(lck, [&] { return in_flight_ == 0; });
+    // a nop without request stops the completion thread
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_NOP;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0);
+    lck.unlock();
+    reaper_thread_->join();
+    delete reaper_thread_;
+    munmap(sqes_, sqes_size_);
+    if (cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+  }
+  free(log_staging_);
+  // db_fd_ is closed by DiskManager
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+  }
+}
+
+/*
+ * Map the submission and completion rings, no liburing required
+ */
+bool AsyncDiskManager::SetupRing(unsigned queue_depth) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = syscall(__NR_io_uring_setup, queue_depth, &params);
+  if (ring_fd_ < 0) {
+    LOG_DEBUG("io_uring not available, I/O is done on the calling thread");
+    return false;
+  }
+  queue_depth_ = params.sq_entries;
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ =
+          params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  cq_ring_ = single_mmap ? sq_ring_
+                         : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE, ring_fd_,
+                                IORING_OFF_CQ_RING);
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+    LOG_DEBUG("mmap of the io_uring rings failed");
+    close(ring_fd_);
+    ring_fd_ = -1;
+    return false;
+  }
+  char *sq = static_cast<char *>(sq_ring_);
+  char *cq = static_cast<char *>(cq_ring_);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = cq + params.cq_off.cqes;
+  return true;
+}
+
+/*
+ * Queue one read or write of len bytes at offset. Unaligned buffers go
+ * through an aligned bounce buffer. Without io_uring the I/O is done and done
+ * is called right here.
+ */
+void AsyncDiskManager::Submit(bool write, int fd, char *buf, size_t len,
+                              off_t offset,
+                              std::function<void(ssize_t)> done) {
+  Request *req = new Request{std::move(done), buf, nullptr, write, {buf, len}};
+  if (!IsAligned(buf)) {
+    req->bounce = AlignedAlloc(RoundUp(len, DIRECT_IO_ALIGNMENT));
+    if (write) {
+      memcpy(req->bounce, buf, len);
+    }
+    req->iov.iov_base = req->bounce;
+  }
+  if (IsUring()) {
+    std::unique_lock<std::mutex> lck(submit_latch_);
+    submit_cv_.wait(lck, [&] { return in_flight_ < queue_depth_; });
+    in_flight_++;
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    // vectored opcodes, supported by every kernel with io_uring
+    sqe->opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&req->iov);
+    sqe->len = 1;
+    sqe->off = offset;
+    sqe->user_data = reinterpret_cast<uint64_t>(req);
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    int rc;
+    do {
+      rc = syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0);
+    } while (rc < 0 && errno == EINTR);
+    if (rc < 0) {
+      // the entry stays queued and is picked up by the next enter
+      LOG_DEBUG("io_uring_enter failed");
+    }
+    return;
+  }
+  ssize_t result = write ? pwrite(fd, req->iov.iov_base, len, offset)
+                 : pread(fd, req->iov.iov_base, len, offset);
+  if (req->bounce != nullptr) {
+    if (!write && result > 0) {
+      memcpy(buf, req->bounce, result);
+    }
+    free(req->bounce);
+  }
+  req->done(result);
+  delete req;
+}
+
+ssize_t AsyncDiskManager::SubmitAndWait(bool write, int fd, char *buf,
+                                        size_t len, off_t offset) {
+  std::promise<ssize_t> result;
+  Submit(write, fd, buf, len, offset,
+         [&](ssize_t rc) { result.set_value(rc); });
+  return result.get_future().get();
+}
+
+/*
+ * Body of the completion thread: waits for completions and runs their
+ * callbacks, one at a time. A callback must not wait for other I/O of this
+ * disk manager.
+ */
+void AsyncDiskManager::ReapCompletions() {
+  while (true) {
+    unsigned head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS,
+              nullptr, 0);
+      continue;
+    }
+    io_uring_cqe *cqe = static_cast<io_uring_cqe *>(cqes_) + (head & *cq_mask_);
+    Request *req = reinterpret_cast<Request *>(cqe->user_data);
+    const ssize_t result = cqe->res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    if (req == nullptr) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lck(submit_latch_);
+      in_flight_--;
+      submit_cv_.notify_all();
+    }
+    if (req->bounce != nullptr) {
+      if (!req->write && result > 0) {
+        memcpy(req->target, req->bounce, result);
+      }
+      free(req->bounce);
+    }
+    if (result < 0) {
+      errno = -result;
+    }
+    req->done(result < 0 ? -1 : result);
+    delete req;
+  }
+}
+
+void AsyncDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  WritePages(page_id, &page_data, 1);
+}
+
+/**
+ * All the pages are submitted before waiting for the first one
+ */
+void AsyncDiskManager::WritePages(page_id_t page_id,
+                                  const char *const *pages_data,
+                                  size_t count) {
+  std::mutex latch;
+  std::condition_variable cv;
+  size_t pending = count;
+  for (size_t i = 0; i < count; ++i) {
+    Submit(true, db_fd_, const_cast<char *>(pages_data[i]), PAGE_SIZE,
+           static_cast<off_t>(page_id + i) * PAGE_SIZE, [&](ssize_t rc) {
+             if (rc != PAGE_SIZE) {
+               LOG_DEBUG("I/O error while writing");
+             }
+             std::lock_guard<std::mutex> lck(latch);
+             if (--pending == 0) {
+               cv.notify_one();
+             }
+           });
+  }
+  std::unique_lock<std::mutex> lck(latch);
+  cv.wait(lck, [&] { return pending == 0; });
+}
+
+void AsyncDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  std::promise<void> done;
+  ReadPageAsync(page_id, page_data, [&] { done.set_value(); });
+  done.get_future().wait();
+}
+
+/**
+ * Same as ReadPage, a page beyond the end of the file reads as zeros
+ */
+void AsyncDiskManager::ReadPageAsync(page_id_t page_id, char *page_data,
+                                     std::function<void()> callback) {
+  Submit(false, db_fd_, page_data, PAGE_SIZE,
+         static_cast<off_t>(page_id) * PAGE_SIZE,
+         [page_data, callback](ssize_t rc) {
+           if (rc < 0) {
+             LOG_DEBUG("I/O error while reading");
+             rc = 0;
+           }
+           if (rc < PAGE_SIZE) {
+             memset(page_data + rc, 0, PAGE_SIZE - rc);
+           }
+           callback();
+         });
+}
+
+void AsyncDiskManager::WritePageAsync(page_id_t page_id,
+                                      const char *page_data,
+                                      std::function<void()> callback) {
+  Submit(true, db_fd_, const_cast<char *>(page_data), PAGE_SIZE,
+         static_cast<off_t>(page_id) * PAGE_SIZE, [callback](ssize_t rc) {
+           if (rc != PAGE_SIZE) {
+             LOG_DEBUG("I/O error while writing");
+           }
+           callback();
+         });
+}
+
+/**
+ * Append to the log. O_DIRECT only writes whole blocks, so the partial last
+ * block of the log is kept in log_staging_ and written again together with
+ * the new records, and the file is cut back to the end of the log.
+ */
+void AsyncDiskManager::WriteLog(char *log_data, int size) {
+  // enforce swap log buffer
+  assert(log_data != buffer_used);
+  assert(size <= LOG_BUFFER_SIZE);
+  buffer_used = log_data;
+
+  if (size == 0) // no effect on num_flushes_ if log buffer is empty
+    return;
+
+  flush_log_ = true;
+
+  if (flush_log_f_ != nullptr)
+    // used for checking non-blocking flushing
+    assert(flush_log_f_->wait_for(std::chrono::seconds(10)) ==
+           std::future_status::ready);
+
+  num_flushes_ += 1;
+  const off_t block_start = log_size_ / DIRECT_IO_ALIGNMENT *
+                            DIRECT_IO_ALIGNMENT;
+  const size_t tail = log_size_ - block_start;
+  const size_t length = RoundUp(tail + size, DIRECT_IO_ALIGNMENT);
+  memcpy(log_staging_ + tail, log_data, size);
+  memset(log_staging_ + tail + size, 0, length - tail - size);
+  if (SubmitAndWait(true, log_fd_, log_staging_, length, block_start) !=
+      static_cast<ssize_t>(length)) {
+    LOG_DEBUG("I/O error while writing log");
+    return;
+  }
+  log_size_ += size;
+  if (ftruncate(log_fd_, log_size_) != 0) {
+    LOG_DEBUG("I/O error while writing log");
+  }
+  // keep the new partial last block
+  const size_t new_tail = log_size_ % DIRECT_IO_ALIGNMENT;
+  memmove(log_staging_, log_staging_ + (log_size_ - new_tail - block_start),
+          new_tail);
+  flush_log_ = false;
+}
+
+/**
+ * Read size bytes of the log at offset, through an aligned buffer covering
+ * the blocks around them
+ * @return: false means already reach the end
+ */
+bool AsyncDiskManager::ReadLog(char *log_data, int size, int offset) {
+  if (offset >= log_size_) {
+    return false;
+  }
+  const off_t block_start = offset / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+  const off_t end = std::min<off_t>(offset + size, log_size_);
+  const size_t length = RoundUp(end - block_start, DIRECT_IO_ALIGNMENT);
+  char *buf = AlignedAlloc(length);
+  ssize_t rc = SubmitAndWait(false, log_fd_, buf, length, block_start);
+  int read_count = 0;
+  if (rc < 0) {
+    LOG_DEBUG("I/O error while reading log");
+  } else {
+    read_count = std::max<off_t>(
+            0, std::min<off_t>(end, block_start + rc) - offset);
+    memcpy(log_data, buf + (offset - block_start), read_count);
+  }
+  // if log file ends before reading "size"
+  memset(log_data + read_count, 0, size - read_count);
+  free(buf);
+  return true;
+}
+
+} // namespace cmudb
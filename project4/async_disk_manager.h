@@ -0,0 +1,82 @@
+/**
+ * async_disk_manager.h
+ *
+ * DiskManager backend bypassing the kernel page cache: the db and log files
+ * are opened with O_DIRECT (the buffer pool is the only cache of a page) and
+ * every read and write is submitted through io_uring. A completion thread
+ * reaps the results and runs the callbacks, so a caller can keep many page
+ * I/Os in flight with ReadPageAsync/WritePageAsync. The synchronous interface
+ * of DiskManager submits and waits.
+ * The descriptors opened by DiskManager are replaced, so no page goes
+ * through the page cache behind the back of the direct ones.
+ * Falls back to buffered I/O when the file system refuses O_DIRECT, and to
+ * pread/pwrite on the calling thread when io_uring is not available.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "disk/disk_manager.h"
+
+namespace cmudb {
+
+class AsyncDiskManager : public DiskManager {
+public:
+  // at most queue_depth I/Os are in flight, submitters wait beyond that
+  AsyncDiskManager(const std::string &db_file, unsigned queue_depth = 64);
+  ~AsyncDiskManager();
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+  void ReadPage(page_id_t page_id, char *page_data) override;
+  // one write per page, all in flight together
+  void WritePages(page_id_t page_id, const char *const *pages_data,
+                  size_t count) override;
+
+  void ReadPageAsync(page_id_t page_id, char *page_data,
+                     std::function<void()> callback) override;
+  void WritePageAsync(page_id_t page_id, const char *page_data,
+                      std::function<void()> callback) override;
+
+  void WriteLog(char *log_data, int size) override;
+  bool ReadLog(char *log_data, int size, int offset) override;
+
+  inline bool IsDirect() const { return direct_; }
+  inline bool IsUring() const { return ring_fd_ >= 0; }
+
+private:
+  struct Request;
+  // submit one read or write, done gets the result of the system call
+  void Submit(bool write, int fd, char *buf, size_t len, off_t offset,
+              std::function<void(ssize_t)> done);
+  // submit and wait for the result
+  ssize_t SubmitAndWait(bool write, int fd, char *buf, size_t len,
+                        off_t offset);
+  bool SetupRing(unsigned queue_depth);
+  void ReapCompletions();
+
+  bool direct_;             // files opened with O_DIRECT, db_fd_ included
+  int log_fd_;
+  off_t log_size_;          // end of the log, the file is block aligned
+  char *log_staging_;       // aligned copy of the log tail + one flush
+
+  // io_uring related, the ring is shared by all submitters
+  int ring_fd_ = -1;
+  unsigned queue_depth_ = 0;
+  std::mutex submit_latch_;
+  std::condition_variable submit_cv_; // submitters waiting for a free slot
+  unsigned in_flight_ = 0;
+  void *sq_ring_ = nullptr;
+  void *cq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  void *sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+  unsigned *sq_tail_, *sq_mask_, *sq_array_;
+  unsigned *cq_head_, *cq_tail_, *cq_mask_;
+  void *cqes_;
+  std::thread *reaper_thread_ = nullptr;
+};
+
+} // namespace cmudb
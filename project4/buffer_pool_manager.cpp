@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <sstream>
+
 #include "buffer/buffer_pool_manager.h"
 
 namespace cmudb {
 
+// page reads the prefetch thread keeps in flight
+static const size_t PREFETCH_DEPTH = 32;
+
 /*
  * BufferPoolManager Constructor
  * When log_manager is nullptr, logging is disabled (for test purpose)
@@ -9,14 +15,40 @@ namespace cmudb {
  */
 BufferPoolManager::BufferPoolManager(size_t pool_size,
                                                  DiskManager *disk_manager,
-                                                 LogManager *log_manager)
+                                                 LogManager *log_manager,
+                                                 ReplacerType replacer_type,
+                                                 size_t numa_partitions)
     : pool_size_(pool_size), disk_manager_(disk_manager),
       log_manager_(log_manager) {
   // a consecutive memory space for buffer pool
   pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE);
-  replacer_ = new LRUReplacer<Page *>;
+  arena_ = new FrameArena(pool_size_, numa_partitions);
+  for (size_t i = 0; i < pool_size_; ++i) {
+    pages_[i].data_ = arena_->GetFrame(i);
+  }
+  // never holds more than pool_size_ pages, so it never grows
+  page_table_ = new LinearProbeHashTable<page_id_t, Page *>(pool_size_,
+                                                           INVALID_PAGE_ID);
+  switch (replacer_type) {
+  case ReplacerType::LRU:
+    replacer_ = new LRUReplacer<Page *>;
+    break;
+  case ReplacerType::LRU_K:
+    replacer_ = new LRUKReplacer<Page *>;
+    break;
+  case ReplacerType::CLOCK:
+    replacer_ = new ClockReplacer<Page *>(pool_size_, pages_);
+    break;
+  case ReplacerType::ARC:
+    arc_replacer_ = new ARCReplacer<Page *>(pool_size_);
+    replacer_ = arc_replacer_;
+    break;
+  }
   free_list_ = new std::list<Page *>;
+  io_pending_ = new bool[pool_size_]();
+  io_cv_ = new std::condition_variable[pool_size_];
+  flushing_ = new size_t[pool_size_]();
+  swizzles_ = new std::vector<std::pair<size_t, Page *>>[pool_size_];
 
   // put all the pages into free list
   for (size_t i = 0; i < pool_size_; ++i) {
@@ -24,15 +56,36 @@ BufferPoolManager::BufferPoolManager(size_t pool_size,
   }
 }
 
+/*
+ * Constructor for subclasses which route requests to other pools and own no
+ * frames of their own (see ParallelBufferPoolManager)
+ */
+BufferPoolManager::BufferPoolManager(DiskManager *disk_manager,
+                                     LogManager *log_manager)
+    : pool_size_(0), pages_(nullptr), arena_(nullptr),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager), page_table_(nullptr), replacer_(nullptr),
+      free_list_(nullptr), io_pending_(nullptr), io_cv_(nullptr),
+      flushing_(nullptr), swizzles_(nullptr) {}
+
 /*
  * BufferPoolManager Deconstructor
  * WARNING: Do Not Edit This Function
  */
 BufferPoolManager::~BufferPoolManager() {
+  // the threads use the frames, the page table and latch_
+  StopStatsDumper();
+  StopPageCleaner();
+  StopPrefetcher();
   delete[] pages_;
+  delete arena_;
   delete page_table_;
   delete replacer_;
   delete free_list_;
+  delete[] io_pending_;
+  delete[] io_cv_;
+  delete[] flushing_;
+  delete[] swizzles_;
 }
 
 /**
@@ -47,41 +100,109 @@ BufferPoolManager::~BufferPoolManager() {
  * pointer
  *
  * This function must mark the Page as pinned and remove its entry from LRUReplacer before it is returned to the caller.
+ *
+ * latch_ is not held during the disk I/O of step 2 and 4, see ReplaceFrame.
+ * A hit on a frame whose I/O is still in flight waits for that frame only.
  */
 Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-  lock_guard<mutex> lck(latch_);
+  unique_lock<mutex> lck = LockLatch();
+  page_id_t first;
+  size_t count;
+  if (SequentialFetch(page_id, first, count)) {
+    for (size_t i = 0; i < count; ++i) {
+      QueuePrefetch(first + i);
+    }
+  }
   Page *tar = nullptr;
-  if (page_table_->Find(page_id,tar)) { //1.1
+  while (!page_table_->Find(page_id,tar)) {
+    // the latest copy may still be on its way to disk from an evicted frame
+    auto writing = writing_back_.find(page_id);
+    if (writing == writing_back_.end()) {
+      break;
+    }
+    stats_.pin_waits++;
+    WaitForIO(writing->second, lck);
+  }
+  if (tar != nullptr) { //1.1
+    stats_.hits++;
     tar->pin_count_++;
-    replacer_->Erase(tar);
+    replacer_->Pin(tar);
+    if (io_pending_[tar - pages_]) {
+      stats_.pin_waits++;
+      WaitForIO(tar, lck);
+    }
     return tar;
   }
   //1.2
+  stats_.misses++;
   tar = GetVictimPage();
-  if (tar == nullptr) return tar;
-  //2
-  if (tar->is_dirty_) {
-    //Before your buffer pool manager evicts a dirty page from LRU replacer and write this page back to db file,
-    // it needs to flush logs up to pageLSN. You need to compare persistent_lsn_ (a member variable maintains
-    // by Log Manager) with your pageLSN. However unlike group commit, buffer pool can force log manager to flush log
-    // buffer, but still needs to wait for logs to be permanently stored before continue
-    if (ENABLE_LOGGING && log_manager_->GetPersistentLSN() < tar->GetLSN())
-      log_manager_->Flush(true);
-    disk_manager_->WritePage(tar->GetPageId(),tar->data_);
+  if (tar == nullptr) {
+    stats_.all_pinned++;
+    return tar;
   }
-  //3
-  page_table_->Remove(tar->GetPageId());
-  page_table_->Insert(page_id,tar);
-  //4
-  disk_manager_->ReadPage(page_id,tar->data_);
-  tar->pin_count_ = 1;
-  tar->is_dirty_ = false;
-  tar->page_id_= page_id;
-
+  ReplaceFrame(tar, page_id, true, lck);
   return tar;
 }
 //Page *BufferPoolManager::find
 
+/*
+ * Optimistic lookup of a buffered page: neither latch_ nor the page latch is
+ * taken and nothing is written, the page is not pinned either. Returns its
+ * frame and the version to check with Page::Validate once the caller is done
+ * reading, the frame may be written or even handed over to another page in
+ * the meantime: both change the version.
+ * return nullptr if the page is not buffered, or is being written or loaded
+ * right now
+ */
+Page *BufferPoolManager::FetchPageOptimistic(page_id_t page_id,
+                                             uint64_t &version) {
+  Page *tar = nullptr;
+  // lookups in the page table take no lock
+  if (!page_table_->Find(page_id, tar)) {
+    return nullptr;
+  }
+  version = tar->GetVersion();
+  // a frame claimed for another page after the lookup has an odd version, or
+  // an even one with its new page id
+  if ((version & 1) || tar->page_id_ != page_id) {
+    return nullptr;
+  }
+  return tar;
+}
+
+/*
+ * Fetch a page and take its latch, see page_guard.h. Also used by
+ * ParallelBufferPoolManager, the guard unpins through the owning instance.
+ */
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id) {
+  Page *page = FetchPage(page_id);
+  if (page == nullptr) {
+    return ReadPageGuard();
+  }
+  page->RLatch();
+  return ReadPageGuard(this, page);
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id) {
+  Page *page = FetchPage(page_id);
+  if (page == nullptr) {
+    return WritePageGuard();
+  }
+  page->WLatch();
+  return WritePageGuard(this, page);
+}
+
+WritePageGuard BufferPoolManager::NewPageGuarded(page_id_t &page_id) {
+  Page *page = NewPage(page_id);
+  if (page == nullptr) {
+    return WritePageGuard();
+  }
+  page->WLatch();
+  WritePageGuard guard(this, page);
+  guard.MarkDirty();
+  return guard;
+}
+
 /*
  * Implementation of unpin page
  * if pin_count>0, decrement it and if it becomes zero, put it back to
@@ -89,13 +210,31 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) {
  * dirty flag of this page
  */
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  lock_guard<mutex> lck(latch_);
+  unique_lock<mutex> lck = LockLatch();
   Page *tar = nullptr;
   page_table_->Find(page_id,tar);
   if (tar == nullptr) {
     return false;
   }
-  tar->is_dirty_ |= is_dirty;
+  return Unpin(tar, is_dirty);
+}
+
+/*
+ * Used by page guards: the caller holds a pin on page, so it is still in its
+ * frame
+ */
+bool BufferPoolManager::UnpinFrame(Page *page, bool is_dirty) {
+  unique_lock<mutex> lck = LockLatch();
+  return Unpin(page, is_dirty);
+}
+
+bool BufferPoolManager::Unpin(Page *tar, bool is_dirty) {
+  if (is_dirty && !tar->is_dirty_) {
+    tar->is_dirty_ = true;
+    // let the page cleaner write pages back before evictions have to
+    if (++dirty_count_ > high_watermark_ * pool_size_ && cleaner_running_)
+      cleaner_cv_.notify_one();
+  }
 
   if (tar->GetPinCount() <= 0) {
 //    cout<<"error "<<tar->GetPageId()<<endl;
@@ -115,17 +254,36 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
  * write_page method of the disk manager
  * if page is not found in page table, return false
  * NOTE: make sure page_id != INVALID_PAGE_ID
+ * The page is pinned during the write instead of holding latch_: completion
+ * callbacks of an asynchronous disk manager take latch_.
  */
 bool BufferPoolManager::FlushPage(page_id_t page_id) {
-  lock_guard<mutex> lck(latch_);
+  unique_lock<mutex> lck = LockLatch();
   Page *tar = nullptr;
   page_table_->Find(page_id,tar);
   if (tar == nullptr || tar->page_id_ == INVALID_PAGE_ID) {
     return false;
   }
+  WaitForIO(tar, lck);
   if (tar->is_dirty_) {
-    disk_manager_->WritePage(page_id,tar->GetData());
     tar->is_dirty_ = false;
+    dirty_count_--;
+    tar->pin_count_++;
+    replacer_->Pin(tar);
+    // without its swizzled ids, from a copy: the page is not latched
+    char copy[PAGE_SIZE];
+    const char *data = tar->GetData();
+    if (tar->swizzled_ > 0) {
+      memcpy(copy, data, PAGE_SIZE);
+      RestoreSwizzled(tar, copy);
+      data = copy;
+    }
+    lck.unlock();
+    disk_manager_->WritePage(page_id,data);
+    AcquireLatch(lck);
+    if (--tar->pin_count_ == 0) {
+      replacer_->Insert(tar);
+    }
   }
 
   return true;
@@ -140,7 +298,7 @@ bool BufferPoolManager::FlushPage(page_id_t page_id) {
  * the page is found within page table, but pin_count != 0, return false
  */
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
-  lock_guard<mutex> lck(latch_);
+  unique_lock<mutex> lck = LockLatch();
   Page *tar = nullptr;
   page_table_->Find(page_id,tar);
   if (tar != nullptr) {
@@ -151,9 +309,16 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) {
     }
     replacer_->Erase(tar);
     page_table_->Remove(page_id);
-    tar->is_dirty_= false;
+    if (tar->is_dirty_) {
+      tar->is_dirty_= false;
+      dirty_count_--;
+    }
+    // the page cleaner or FlushDirtyPages may still be reading it
+    tar->WLatch();
+    RestoreSwizzled(tar);
     tar->ResetMemory();
     tar->page_id_ = INVALID_PAGE_ID;
+    tar->WUnlatch();
     free_list_->push_back(tar);
   }
   disk_manager_->DeallocatePage(page_id);
@@ -169,31 +334,247 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) {
  * into page table. return nullptr if all the pages in pool are pinned
  */
 Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-  lock_guard<mutex> lck(latch_);
+  unique_lock<mutex> lck = LockLatch();
   Page *tar = nullptr;
   tar = GetVictimPage();
   if (tar == nullptr) {
+    stats_.all_pinned++;
     return tar;
   }
-
   page_id = disk_manager_->AllocatePage();
+  ReplaceFrame(tar, page_id, false, lck);
+  return tar;
+}
+
+/*
+ * Same as NewPage, but page_id has already been allocated by the caller.
+ * ParallelBufferPoolManager uses it because the owner of a page is decided
+ * by its id, so the id has to exist before a frame is picked.
+ */
+Page *BufferPoolManager::NewPageWithId(page_id_t page_id) {
+  unique_lock<mutex> lck = LockLatch();
+  Page *tar = GetVictimPage();
+  if (tar == nullptr) {
+    stats_.all_pinned++;
+    return tar;
+  }
+  ReplaceFrame(tar, page_id, false, lck);
+  return tar;
+}
+
+/*
+ * Hand the victim frame tar over to page_id, pinned once. Called and returns
+ * with latch_ held through lck.
+ * The new mapping is published and the frame is marked as loading before
+ * latch_ is dropped, then the old content is written back if dirty and the
+ * new content is read from disk (or zeroed for a new page). Fetchers of
+ * page_id find the frame and wait on it, fetchers of the old page id wait in
+ * writing_back_, everybody else goes on without waiting for this I/O.
+ */
+void BufferPoolManager::ReplaceFrame(Page *tar, page_id_t page_id, bool read,
+                                     unique_lock<mutex> &lck) {
+  const bool write_back = tar->is_dirty_;
+  const page_id_t old_page_id = ClaimFrame(tar, page_id);
+  lck.unlock();
+  // wait for the page cleaner if it is still writing the old content, the
+  // version stays odd from ClaimFrame to FinishIO
+  tar->rwlatch_.WLock();
   //2
-  if (tar->is_dirty_) {
-    if (ENABLE_LOGGING && log_manager_->GetPersistentLSN() < tar->GetLSN())
-      log_manager_->Flush(true);
-    disk_manager_->WritePage(tar->GetPageId(),tar->data_);
+  if (write_back) {
+    WriteBack(tar, old_page_id);
   }
+  //4
+  if (read) {
+    disk_manager_->ReadPage(page_id,tar->data_);
+  } else {
+    tar->ResetMemory();
+  }
+  tar->rwlatch_.WUnlock();
+  AcquireLatch(lck);
+  FinishIO(tar, old_page_id);
+}
+
+/*
+ * Write the dirty content of an evicted frame back as old_page_id, latch_ not
+ * held and the frame claimed by ClaimFrame
+ */
+void BufferPoolManager::WriteBack(Page *tar, page_id_t old_page_id) {
+  //Before your buffer pool manager evicts a dirty page from LRU replacer and write this page back to db file,
+  // it needs to flush logs up to pageLSN. You need to compare persistent_lsn_ (a member variable maintains
+  // by Log Manager) with your pageLSN. However unlike group commit, buffer pool can force log manager to flush log
+  // buffer, but still needs to wait for logs to be permanently stored before continue
+  if (ENABLE_LOGGING && log_manager_->GetPersistentLSN() < tar->GetLSN()) {
+    stats_.wal_flushes++;
+    log_manager_->Flush(true);
+  }
+  disk_manager_->WritePage(old_page_id,tar->data_);
+}
+
+/*
+ * First half of ReplaceFrame, called with latch_ held: map page_id to frame
+ * tar, pinned once and marked as loading. Returns the page id it had before.
+ * Optimistic readers of the old page fail from now on.
+ */
+page_id_t BufferPoolManager::ClaimFrame(Page *tar, page_id_t page_id) {
+  tar->BeginWrite();
+  // unpinned, nobody else reads it under a latch
+  RestoreSwizzled(tar);
+  const page_id_t old_page_id = tar->page_id_;
+  const bool write_back = tar->is_dirty_;
   //3
-  page_table_->Remove(tar->GetPageId());
+  page_table_->Remove(old_page_id);
   page_table_->Insert(page_id,tar);
-
-  //4
+  // a clean frame may still be on its way to disk by the page cleaner or
+  // FlushDirtyPages, fetchers of the old page must wait for that as well
+  if (write_back || flushing_[tar - pages_] > 0) {
+    writing_back_[old_page_id] = tar;
+  }
+  if (write_back) {
+    dirty_count_--;
+    stats_.dirty_write_backs++;
+  }
+  if (old_page_id != INVALID_PAGE_ID) {
+    stats_.evictions++;
+  }
   tar->page_id_ = page_id;
-  tar->ResetMemory();
   tar->is_dirty_ = false;
   tar->pin_count_ = 1;
+  io_pending_[tar - pages_] = true;
+  return old_page_id;
+}
 
-  return tar;
+/*
+ * Second half of ReplaceFrame, called with latch_ held once the I/O of frame
+ * tar is done: wake up whoever waits for it
+ */
+void BufferPoolManager::FinishIO(Page *tar, page_id_t old_page_id) {
+  tar->EndWrite();
+  writing_back_.erase(old_page_id);
+  io_pending_[tar - pages_] = false;
+  io_cv_[tar - pages_].notify_all();
+}
+
+/*
+ * Block until the I/O in flight on frame tar (if any) is done. Only waiters
+ * of this frame are woken up when it completes.
+ */
+void BufferPoolManager::WaitForIO(Page *tar, unique_lock<mutex> &lck) {
+  const size_t frame_id = tar - pages_;
+  io_cv_[frame_id].wait(lck, [&] { return !io_pending_[frame_id]; });
+}
+
+/*
+ * Let the B+ tree (or any page holding child page ids) follow frames instead
+ * of looking its children up in the page table. Children pinned this way are
+ * not evicted, hence the limit. Ids swizzled so far stay until their page is
+ * written, evicted or write latched by a B+ tree writer.
+ */
+void BufferPoolManager::SetSwizzling(size_t max_pins) {
+  max_swizzled_ = max_pins;
+}
+
+/*
+ * Replace the page id in *slot, which lies inside the data of parent, by the
+ * frame of child, and pin child until the id is put back. parent must not
+ * have been written since version was taken: the page version is held odd
+ * while the id is replaced, which fails if a writer is in, and is a new one
+ * afterwards, so that optimistic readers of the slot start over.
+ * return false if swizzling is off or at its limit, parent is being written
+ * to disk or has changed, or child does not hold the page of *slot any more
+ */
+bool BufferPoolManager::Swizzle(Page *parent, uint64_t version,
+                                page_id_t *slot, Page *child) {
+  if (max_swizzled_ == 0) {
+    return false;
+  }
+  unique_lock<mutex> lck = LockLatch();
+  const size_t parent_id = parent - pages_;
+  const size_t child_id = child - pages_;
+  assert(parent_id < pool_size_ && child_id < pool_size_);
+  if (swizzled_count_ >= max_swizzled_ || flushing_[parent_id] > 0 ||
+      io_pending_[child_id]) {
+    return false;
+  }
+  uint64_t expected = version;
+  if (!parent->version_.compare_exchange_strong(expected, version + 1,
+                                                std::memory_order_acquire)) {
+    return false;
+  }
+  const bool swizzled = *slot == child->page_id_ && parent != child;
+  if (swizzled) {
+    *slot = SWIZZLE_TAG | static_cast<page_id_t>(child_id);
+    swizzles_[parent_id].push_back(
+            {reinterpret_cast<char *>(slot) - parent->data_, child});
+    parent->swizzled_++;
+    if (child->pin_count_++ == 0) {
+      replacer_->Pin(child);
+    }
+    swizzled_count_++;
+    stats_.swizzles++;
+  }
+  parent->version_.store(swizzled ? version + 2 : version,
+                         std::memory_order_release);
+  return swizzled;
+}
+
+/*
+ * Called by a writer of page right after latching it, before it moves any
+ * child page id around
+ */
+void BufferPoolManager::Unswizzle(Page *page) {
+  // no swizzle gets in while the caller holds the write latch
+  if (page->swizzled_ == 0) {
+    return;
+  }
+  unique_lock<mutex> lck = LockLatch();
+  RestoreSwizzled(page);
+}
+
+/*
+ * Called with latch_ held: put the page ids swizzled inside frame tar back and
+ * unpin their children. Nobody may read tar under a page latch meanwhile, and
+ * optimistic readers must see a new version.
+ */
+void BufferPoolManager::RestoreSwizzled(Page *tar) {
+  auto &swizzles = swizzles_[tar - pages_];
+  for (auto &swizzle : swizzles) {
+    Page *child = swizzle.second;
+    memcpy(tar->data_ + swizzle.first, &child->page_id_, sizeof(page_id_t));
+    if (--child->pin_count_ == 0) {
+      replacer_->Insert(child);
+    }
+  }
+  swizzled_count_ -= swizzles.size();
+  stats_.unswizzles += swizzles.size();
+  tar->swizzled_ = 0;
+  swizzles.clear();
+}
+
+/*
+ * Same for copy, a copy of the data of frame tar on its way to disk: tar is
+ * left as is
+ */
+void BufferPoolManager::RestoreSwizzled(Page *tar, char *copy) {
+  for (auto &swizzle : swizzles_[tar - pages_]) {
+    memcpy(copy + swizzle.first, &swizzle.second->page_id_, sizeof(page_id_t));
+  }
+}
+
+/*
+ * Same for the copy of a flush target, from the ids it had when it was
+ * claimed. None got swizzled since (flushing_), but a writer may have put
+ * them back and moved ids around: only slots still holding a swizzled id
+ * are taken back.
+ */
+void BufferPoolManager::RestoreSwizzled(const FlushTarget &target,
+                                        char *copy) {
+  for (auto &swizzle : target.swizzled) {
+    page_id_t page_id;
+    memcpy(&page_id, copy + swizzle.first, sizeof(page_id_t));
+    if (IsSwizzled(page_id)) {
+      memcpy(copy + swizzle.first, &swizzle.second, sizeof(page_id_t));
+    }
+  }
 }
 
 Page *BufferPoolManager::GetVictimPage() {
@@ -214,11 +595,558 @@ Page *BufferPoolManager::GetVictimPage() {
   return tar;
 }
 
+/*
+ * Start a background thread writing dirty unpinned pages back to disk ahead of
+ * eviction, so that FetchPage/NewPage mostly find a clean victim.
+ * It wakes up every LOG_TIMEOUT, or as soon as UnpinPage makes more than
+ * high_watermark of the frames dirty, and then cleans pages until at most
+ * low_watermark of the frames are dirty.
+ */
+void BufferPoolManager::RunPageCleaner(double high_watermark,
+                                       double low_watermark) {
+  assert(0 <= low_watermark && low_watermark <= high_watermark);
+  unique_lock<mutex> lck = LockLatch();
+  if (cleaner_running_) return;
+  high_watermark_ = high_watermark;
+  low_watermark_ = low_watermark;
+  cleaner_running_ = true;
+  cleaner_thread_ = new thread([&] {
+    unique_lock<mutex> latch = LockLatch();
+    while (cleaner_running_) {
+      if (dirty_count_ > high_watermark_ * pool_size_) {
+        CleanDirtyPages(latch);
+      }
+      cleaner_cv_.wait_for(latch, LOG_TIMEOUT);
+    }
+  });
+}
+
+/*
+ * Stop and join the page cleaner thread
+ */
+void BufferPoolManager::StopPageCleaner() {
+  {
+    unique_lock<mutex> lck = LockLatch();
+    if (!cleaner_running_) return;
+    cleaner_running_ = false;
+    cleaner_cv_.notify_one();
+  }
+  cleaner_thread_->join();
+  delete cleaner_thread_;
+  cleaner_thread_ = nullptr;
+}
+
+/*
+ * One sweep of the page cleaner over the frame array, called with latch_ held.
+ * Pinned pages are skipped, they are likely to be dirtied again. A page is
+ * marked clean and read latched before latch_ is dropped: whoever evicts or
+ * deletes it meanwhile waits on its latch, and whoever dirties it again does
+ * so after the write and sets the dirty flag again. The frame is counted in
+ * flushing_ meanwhile: evicting it puts the page id in writing_back_ until
+ * the write is done, see ReplaceFrame.
+ */
+void BufferPoolManager::CleanDirtyPages(unique_lock<mutex> &lck) {
+  for (size_t i = 0; i < pool_size_ && cleaner_running_ &&
+                     dirty_count_ > low_watermark_ * pool_size_; ++i) {
+    Page *tar = &pages_[cleaner_hand_];
+    cleaner_hand_ = (cleaner_hand_ + 1) % pool_size_;
+    if (!tar->is_dirty_ || tar->pin_count_ > 0) continue;
+    // unpinned pages are never latched by anybody else
+    tar->RLatch();
+    tar->is_dirty_ = false;
+    dirty_count_--;
+    // no swizzle until the write is done
+    flushing_[tar - pages_]++;
+    if (tar->swizzled_ > 0) {
+      tar->BeginWrite();
+      RestoreSwizzled(tar);
+      tar->EndWrite();
+    }
+    const page_id_t page_id = tar->page_id_;
+    lck.unlock();
+    if (ENABLE_LOGGING && log_manager_->GetPersistentLSN() < tar->GetLSN()) {
+      stats_.wal_flushes++;
+      log_manager_->Flush(true);
+    }
+    disk_manager_->WritePage(page_id, tar->data_);
+    stats_.cleaner_writes++;
+    // DeletePage waits for the latch while holding latch_
+    tar->RUnlatch();
+    AcquireLatch(lck);
+    flushing_[tar - pages_]--;
+  }
+}
+
+/*
+ * Write back at most batch dirty pages in page id order, so that runs of
+ * consecutive pages become a single vectored write instead of one random
+ * write per page. The log is flushed once up to the largest page LSN before
+ * anything is written (WAL). latch_ is only held to pick the pages and to
+ * release them, not during the I/O.
+ */
+FlushStats BufferPoolManager::FlushDirtyPages(size_t batch) {
+  FlushStats stats;
+  std::vector<FlushTarget> targets;
+  ClaimDirtyPages(batch, targets);
+  WriteDirtyPages(targets, stats);
+  ReleaseDirtyPages(targets);
+  return stats;
+}
+
+/*
+ * Pick the batch dirty pages with the lowest page ids and mark them clean.
+ * Unpinned pages are read latched right away (nobody else holds their latch)
+ * and counted in flushing_, so evicting one of them waits for the write.
+ * Pinned pages may be latched by their user who could be waiting for latch_,
+ * they just get one more pin here and are latched one at a time later on.
+ * Either way flushing_ keeps their ids from being swizzled meanwhile.
+ */
+void BufferPoolManager::ClaimDirtyPages(size_t batch,
+                                        std::vector<FlushTarget> &targets) {
+  unique_lock<mutex> lck = LockLatch();
+  const size_t begin = targets.size();
+  for (size_t i = 0; i < pool_size_; ++i) {
+    Page *tar = &pages_[i];
+    if (tar->is_dirty_ && !io_pending_[i]) {
+      targets.push_back({tar, tar->page_id_, tar->pin_count_ > 0,
+                         INVALID_LSN, {}});
+    }
+  }
+  auto by_page_id = [](const FlushTarget &a, const FlushTarget &b) {
+    return a.page_id < b.page_id;
+  };
+  if (targets.size() - begin > batch) {
+    std::nth_element(targets.begin() + begin, targets.begin() + begin + batch,
+                     targets.end(), by_page_id);
+    targets.resize(begin + batch);
+  }
+  std::sort(targets.begin() + begin, targets.end(), by_page_id);
+  for (size_t i = begin; i < targets.size(); ++i) {
+    Page *tar = targets[i].page;
+    tar->is_dirty_ = false;
+    dirty_count_--;
+    flushing_[tar - pages_]++;
+    if (targets[i].pinned) {
+      tar->pin_count_++;
+      for (auto &swizzle : swizzles_[tar - pages_]) {
+        targets[i].swizzled.push_back(
+                {swizzle.first, swizzle.second->page_id_});
+      }
+    } else {
+      tar->RLatch();
+      targets[i].lsn = tar->GetLSN();
+      if (tar->swizzled_ > 0) {
+        tar->BeginWrite();
+        RestoreSwizzled(tar);
+        tar->EndWrite();
+      }
+    }
+  }
+}
+
+/*
+ * Write the claimed pages, sorted by page id, without holding any latch_.
+ * Pinned pages are copied optimistically against their version while the
+ * read latches of the unpinned pages are held, so that they are written in
+ * the same runs. A copy that races with a writer is taken again under the
+ * read latch, once the unpinned pages are written and unlatched.
+ * Also used by ParallelBufferPoolManager on the pages of all its instances.
+ */
+void BufferPoolManager::WriteDirtyPages(std::vector<FlushTarget> &targets,
+                                        FlushStats &stats) {
+  std::vector<const char *> data(targets.size());
+  std::vector<size_t> batch, deferred;
+  size_t pinned = 0;
+  for (auto &target : targets) {
+    if (target.pinned) {
+      pinned++;
+    }
+  }
+  std::vector<char> copies(pinned * PAGE_SIZE);
+  char *copy = copies.data();
+  for (size_t i = 0; i < targets.size(); ++i) {
+    Page *tar = targets[i].page;
+    if (targets[i].pinned) {
+      // the read latches of the unpinned targets are held here, waiting on
+      // the latch of a pinned page would deadlock with a writer holding it
+      // and crabbing down to one of them: copy optimistically, or later
+      uint64_t version = tar->GetVersion();
+      memcpy(copy, tar->data_, PAGE_SIZE);
+      targets[i].lsn = tar->GetLSN();
+      RestoreSwizzled(targets[i], copy);
+      data[i] = copy;
+      copy += PAGE_SIZE;
+      if (!tar->Validate(version)) {
+        deferred.push_back(i);
+        continue;
+      }
+    } else {
+      data[i] = tar->data_;
+    }
+    batch.push_back(i);
+  }
+  stats.pages_copied += pinned;
+  WritePageRuns(targets, data, batch, stats);
+  for (auto &target : targets) {
+    if (!target.pinned) {
+      target.page->RUnlatch();
+    }
+  }
+  // no page latch is held anymore
+  for (size_t i : deferred) {
+    Page *tar = targets[i].page;
+    tar->RLatch();
+    memcpy(const_cast<char *>(data[i]), tar->data_, PAGE_SIZE);
+    targets[i].lsn = tar->GetLSN();
+    tar->RUnlatch();
+    RestoreSwizzled(targets[i], const_cast<char *>(data[i]));
+  }
+  WritePageRuns(targets, data, deferred, stats);
+}
+
+/*
+ * Write the targets at indexes, ascending page ids, from data: the log is
+ * flushed once up to their largest page LSN first (WAL), then every run of
+ * consecutive page ids is a single vectored write.
+ */
+void BufferPoolManager::WritePageRuns(std::vector<FlushTarget> &targets,
+                                      std::vector<const char *> &data,
+                                      std::vector<size_t> &indexes,
+                                      FlushStats &stats) {
+  lsn_t max_lsn = INVALID_LSN;
+  for (size_t i : indexes) {
+    max_lsn = std::max(max_lsn, targets[i].lsn);
+  }
+  if (ENABLE_LOGGING && log_manager_->GetPersistentLSN() < max_lsn) {
+    stats_.wal_flushes++;
+    log_manager_->Flush(true);
+    stats.log_flushed = true;
+  }
+  // coalesce runs of consecutive page ids
+  std::vector<const char *> run;
+  for (size_t begin = 0, end; begin < indexes.size(); begin = end) {
+    run.assign(1, data[indexes[begin]]);
+    for (end = begin + 1;
+         end < indexes.size() && targets[indexes[end]].page_id ==
+                                         targets[indexes[end - 1]].page_id + 1;
+         ++end) {
+      run.push_back(data[indexes[end]]);
+    }
+    disk_manager_->WritePages(targets[indexes[begin]].page_id, run.data(),
+                              run.size());
+    stats.write_calls++;
+  }
+  stats.pages_written += indexes.size();
+}
+
+/*
+ * Undo what ClaimDirtyPages did to the pages of this instance, the read
+ * latches are already released by WriteDirtyPages
+ */
+void BufferPoolManager::ReleaseDirtyPages(std::vector<FlushTarget> &targets) {
+  unique_lock<mutex> lck = LockLatch();
+  for (auto &target : targets) {
+    Page *tar = target.page;
+    if (target.pinned && --tar->pin_count_ == 0) {
+      replacer_->Insert(tar);
+    }
+    flushing_[tar - pages_]--;
+  }
+}
+
+/*
+ * Ask the prefetch thread to load count pages starting at page_id
+ */
+void BufferPoolManager::Prefetch(page_id_t page_id, size_t count) {
+  unique_lock<mutex> lck = LockLatch();
+  for (size_t i = 0; i < count; ++i) {
+    QueuePrefetch(page_id + i);
+  }
+}
+
+void BufferPoolManager::Prefetch(const std::vector<page_id_t> &page_ids) {
+  unique_lock<mutex> lck = LockLatch();
+  for (auto page_id : page_ids) {
+    QueuePrefetch(page_id);
+  }
+}
+
+void BufferPoolManager::SetReadAhead(size_t window) {
+  read_ahead_window_ = window;
+}
+
+void BufferPoolManager::WaitForPrefetch() {
+  unique_lock<mutex> lck = LockLatch();
+  prefetch_idle_cv_.wait(lck, [&] {
+    return prefetch_queue_.empty() && prefetch_in_flight_ == 0;
+  });
+}
+
+/*
+ * Called with latch_ held. The prefetch thread is started on first use. It
+ * loads a page like a miss of FetchPage, writing a dirty victim back first,
+ * and leaves the page unpinned in the replacer. Pages already buffered or not
+ * on disk yet are skipped, when no frame can be taken the queue is dropped:
+ * the pool is too busy for it.
+ * At most pool_size_ pages are queued, more would evict each other anyway.
+ * Reads go through ReadPageAsync, up to PREFETCH_DEPTH of them in flight when
+ * the disk manager completes them asynchronously.
+ * A page leaves the queue only once it is skipped or its read is in flight,
+ * so that WaitForPrefetch sees it either queued or in flight.
+ */
+void BufferPoolManager::QueuePrefetch(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID || prefetch_queue_.size() >= pool_size_) {
+    return;
+  }
+  prefetch_queue_.push_back(page_id);
+  if (prefetch_running_) {
+    prefetch_cv_.notify_one();
+    return;
+  }
+  prefetch_running_ = true;
+  prefetch_thread_ = new thread([&] {
+    unique_lock<mutex> latch = LockLatch();
+    // size of the file when last asked, it only grows
+    page_id_t num_pages = 0;
+    while (prefetch_running_ || prefetch_in_flight_ > 0) {
+      if (prefetch_queue_.empty() && prefetch_in_flight_ == 0) {
+        prefetch_idle_cv_.notify_all();
+      }
+      if (!prefetch_running_ || prefetch_queue_.empty() ||
+          prefetch_in_flight_ >= PREFETCH_DEPTH) {
+        prefetch_cv_.wait(latch);
+        continue;
+      }
+      const page_id_t next = prefetch_queue_.front();
+      if (next >= num_pages) {
+        // GetNumPages is an fstat, not done under latch_
+        latch.unlock();
+        const page_id_t on_disk = disk_manager_->GetNumPages();
+        AcquireLatch(latch);
+        num_pages = std::max(num_pages, on_disk);
+        if (next < num_pages || prefetch_queue_.empty() ||
+            prefetch_queue_.front() != next) {
+          continue;
+        }
+      }
+      prefetch_queue_.pop_front();
+      Page *tar = nullptr;
+      if (next >= num_pages || page_table_->Find(next, tar) ||
+          writing_back_.count(next)) {
+        continue;
+      }
+      tar = GetVictimPage();
+      if (tar == nullptr) {
+        prefetch_queue_.clear();
+        continue;
+      }
+      stats_.prefetched++;
+      const bool write_back = tar->is_dirty_;
+      const page_id_t old_page_id = ClaimFrame(tar, next);
+      prefetch_in_flight_++;
+      latch.unlock();
+      // wait for the page cleaner if it is still writing the old content
+      tar->rwlatch_.WLock();
+      if (write_back) {
+        WriteBack(tar, old_page_id);
+      }
+      tar->rwlatch_.WUnlock();
+      disk_manager_->ReadPageAsync(next, tar->data_, [this, tar, old_page_id] {
+        unique_lock<mutex> lck = LockLatch();
+        FinishIO(tar, old_page_id);
+        if (--tar->pin_count_ == 0) {
+          replacer_->Insert(tar);
+        }
+        prefetch_in_flight_--;
+        prefetch_cv_.notify_one();
+      });
+      AcquireLatch(latch);
+    }
+    prefetch_idle_cv_.notify_all();
+  });
+}
+
+/*
+ * Stop and join the prefetch thread, pending requests are dropped and reads
+ * in flight are waited for
+ */
+void BufferPoolManager::StopPrefetcher() {
+  {
+    unique_lock<mutex> lck = LockLatch();
+    if (!prefetch_running_) return;
+    prefetch_running_ = false;
+    prefetch_queue_.clear();
+    prefetch_cv_.notify_one();
+  }
+  prefetch_thread_->join();
+  delete prefetch_thread_;
+  prefetch_thread_ = nullptr;
+}
+
+/*
+ * Sequential scan detection, called with latch_ (ParallelBufferPoolManager:
+ * its scan latch) held on every fetch while read-ahead is on. Once a
+ * few consecutive page ids were fetched in a row, keep the read-ahead window
+ * after page_id queued: returns true and sets [first, first + count) to the
+ * pages not queued yet. Fetching the same page again does not break a run.
+ */
+bool BufferPoolManager::SequentialFetch(page_id_t page_id, page_id_t &first,
+                                        size_t &count) {
+  if (read_ahead_window_ == 0 || page_id == last_fetched_) {
+    return false;
+  }
+  sequential_run_ = page_id == last_fetched_ + 1 ? sequential_run_ + 1 : 0;
+  last_fetched_ = page_id;
+  if (sequential_run_ < 2) {
+    return false;
+  }
+  const page_id_t last = page_id + read_ahead_window_;
+  // continue the window queued so far, unless it belongs to another scan
+  first = read_ahead_next_ > page_id && read_ahead_next_ <= last + 1
+              ? read_ahead_next_
+              : page_id + 1;
+  if (first > last) {
+    return false;
+  }
+  count = last - first + 1;
+  read_ahead_next_ = last + 1;
+  return true;
+}
+
+/*
+ * Lock latch_ and record how long it took in the latch wait histogram. An
+ * uncontended lock goes to bucket 0 without reading the clock.
+ */
+unique_lock<mutex> BufferPoolManager::LockLatch() {
+  unique_lock<mutex> lck(latch_, defer_lock);
+  AcquireLatch(lck);
+  return lck;
+}
+
+void BufferPoolManager::AcquireLatch(unique_lock<mutex> &lck) {
+  if (lck.try_lock()) {
+    stats_.latch_wait[0]++;
+    return;
+  }
+  auto start = chrono::steady_clock::now();
+  lck.lock();
+  uint64_t wait = chrono::duration_cast<chrono::nanoseconds>(
+                          chrono::steady_clock::now() - start).count();
+  size_t bucket = 1;
+  while (bucket < BufferPoolStats::HISTOGRAM_SIZE - 1 && wait >> bucket) {
+    bucket++;
+  }
+  stats_.latch_wait[bucket]++;
+}
+
+/*
+ * Snapshot of the counters, taken without latch_: counters updated meanwhile
+ * may or may not be part of it
+ */
+BufferPoolStats BufferPoolManager::GetStats() {
+  BufferPoolStats stats;
+  stats.hits = stats_.hits;
+  stats.misses = stats_.misses;
+  stats.evictions = stats_.evictions;
+  stats.dirty_write_backs = stats_.dirty_write_backs;
+  stats.cleaner_writes = stats_.cleaner_writes;
+  stats.wal_flushes = stats_.wal_flushes;
+  stats.pin_waits = stats_.pin_waits;
+  stats.all_pinned = stats_.all_pinned;
+  stats.prefetched = stats_.prefetched;
+  stats.swizzles = stats_.swizzles;
+  stats.unswizzles = stats_.unswizzles;
+  if (arc_replacer_ != nullptr) {
+    ARCStats arc_stats = arc_replacer_->GetStats();
+    stats.b1_ghost_hits = arc_stats.b1_ghost_hits;
+    stats.b2_ghost_hits = arc_stats.b2_ghost_hits;
+    stats.target_t1 = arc_stats.target_t1;
+  }
+  for (size_t i = 0; i < BufferPoolStats::HISTOGRAM_SIZE; ++i) {
+    stats.latch_wait[i] = stats_.latch_wait[i];
+  }
+  return stats;
+}
+
+/*
+ * Start a thread handing a GetStats() snapshot to dumper every interval,
+ * e.g. to log it or to export it to a monitoring system
+ */
+void BufferPoolManager::RunStatsDumper(
+        std::function<void(const BufferPoolStats &)> dumper,
+        std::chrono::milliseconds interval) {
+  lock_guard<mutex> lck(dumper_latch_);
+  if (dumper_running_) return;
+  dumper_running_ = true;
+  dumper_thread_ = new thread([=] {
+    unique_lock<mutex> latch(dumper_latch_);
+    while (dumper_running_) {
+      auto stopped = [&] { return !dumper_running_; };
+      if (!dumper_cv_.wait_for(latch, interval, stopped)) {
+        latch.unlock();
+        dumper(GetStats());
+        latch.lock();
+      }
+    }
+  });
+}
+
+/*
+ * Stop and join the stats dumper thread
+ */
+void BufferPoolManager::StopStatsDumper() {
+  {
+    lock_guard<mutex> lck(dumper_latch_);
+    if (!dumper_running_) return;
+    dumper_running_ = false;
+    dumper_cv_.notify_one();
+  }
+  dumper_thread_->join();
+  delete dumper_thread_;
+  dumper_thread_ = nullptr;
+}
+
+/*
+ * One line per counter, and the non empty buckets of the latch histogram
+ */
+std::string BufferPoolStats::ToString() const {
+  std::ostringstream os;
+  os << "hits: " << hits << "\nmisses: " << misses
+     << "\nevictions: " << evictions
+     << "\ndirty write-backs: " << dirty_write_backs
+     << "\ncleaner writes: " << cleaner_writes
+     << "\nWAL flushes: " << wal_flushes << "\npin waits: " << pin_waits
+     << "\nall pinned: " << all_pinned << "\nprefetched: " << prefetched
+     << "\nswizzles: " << swizzles << "\nunswizzles: " << unswizzles
+     << "\nARC ghost hits: " << b1_ghost_hits << " B1 " << b2_ghost_hits
+     << " B2, target T1 " << target_t1 << "\nlatch waits:";
+  for (size_t i = 0; i < HISTOGRAM_SIZE; ++i) {
+    if (latch_wait[i] == 0) continue;
+    if (i == 0) {
+      os << " none " << latch_wait[i];
+    } else if (i == HISTOGRAM_SIZE - 1) {
+      os << " >=" << (1ull << (i - 1)) << "ns " << latch_wait[i];
+    } else {
+      os << " <" << (1ull << i) << "ns " << latch_wait[i];
+    }
+  }
+  os << "\n";
+  return os.str();
+}
+
 //DEBUG
 bool BufferPoolManager::CheckAllUnpined() {
   bool res = true;
+  unique_lock<mutex> lck = LockLatch();
+  // pins held by swizzled child pointers do not count
+  std::vector<int> swizzle_pins(pool_size_);
+  for (size_t i = 0; i < pool_size_; i++) {
+    for (auto &swizzle : swizzles_[i]) {
+      swizzle_pins[swizzle.second - pages_]++;
+    }
+  }
   for (size_t i = 1; i < pool_size_; i++) {
-    if (pages_[i].pin_count_ != 0) {
+    if (pages_[i].pin_count_ != swizzle_pins[i]) {
       res = false;
       std::cout<<"page "<<pages_[i].page_id_<<" pin count:"<<pages_[i].pin_count_<<endl;
     }
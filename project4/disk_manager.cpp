@@ -0,0 +1,249 @@
+/**
+ * disk_manager.cpp
+ */
+#include <algorithm>
+#include <assert.h>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+
+#include "common/logger.h"
+#include "disk/disk_manager.h"
+
+namespace cmudb {
+
+
+/**
+ * Constructor: open/create a single database file & log file
+ * @input db_file: database file name
+ */
+DiskManager::DiskManager(const std::string &db_file)
+    : file_name_(db_file), next_page_id_(0), num_flushes_(0), flush_log_(false),
+      flush_log_f_(nullptr) {
+  std::string::size_type n = file_name_.find(".");
+  if (n == std::string::npos) {
+    LOG_DEBUG("wrong file format");
+    return;
+  }
+  log_name_ = file_name_.substr(0, n) + ".log";
+
+  log_io_.open(log_name_,
+               std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
+  // directory or file does not exist
+  if (!log_io_.is_open()) {
+    log_io_.clear();
+    // create a new file
+    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app |
+                                std::ios::out);
+    log_io_.close();
+    // reopen with original mode
+    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app |
+                                std::ios::out);
+  }
+
+  // create the file if it does not exist
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (db_fd_ < 0) {
+    LOG_DEBUG("can't open db file");
+  }
+}
+
+DiskManager::~DiskManager() {
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+  log_io_.close();
+}
+
+/**
+ * Write the contents of the specified page into disk file
+ */
+void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  WritePages(page_id, &page_data, 1);
+}
+
+/**
+ * Write count pages, given as separate buffers, into consecutive pages of the
+ * disk file starting at page_id. One pwritev covers up to IOV_MAX pages.
+ */
+void DiskManager::WritePages(page_id_t page_id, const char *const *pages_data,
+                             size_t count) {
+  off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  struct iovec iov[IOV_MAX];
+  while (count > 0) {
+    int iovcnt = static_cast<int>(std::min<size_t>(count, IOV_MAX));
+    for (int i = 0; i < iovcnt; ++i) {
+      iov[i].iov_base = const_cast<char *>(pages_data[i]);
+      iov[i].iov_len = PAGE_SIZE;
+    }
+    // a short write leaves us in the middle of a page, finish it first
+    ssize_t written = pwritev(db_fd_, iov, iovcnt, offset);
+    if (written < 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    while (written % PAGE_SIZE != 0) {
+      const size_t done = written % PAGE_SIZE;
+      ssize_t rc = pwrite(db_fd_, pages_data[written / PAGE_SIZE] + done,
+                          PAGE_SIZE - done, offset + written);
+      if (rc < 0) {
+        LOG_DEBUG("I/O error while writing");
+        return;
+      }
+      written += rc;
+    }
+    offset += written;
+    pages_data += written / PAGE_SIZE;
+    count -= written / PAGE_SIZE;
+  }
+}
+
+/**
+ * Read the contents of the specified page into the given memory area
+ */
+void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  int offset = page_id * PAGE_SIZE;
+  // check if read beyond file length
+  if (offset > GetFileSize(file_name_)) {
+    LOG_DEBUG("I/O error while reading");
+    // std::cerr << "I/O error while reading" << std::endl;
+  } else {
+    int read_count = 0;
+    while (read_count < PAGE_SIZE) {
+      ssize_t rc = pread(db_fd_, page_data + read_count,
+                         PAGE_SIZE - read_count, offset + read_count);
+      if (rc <= 0) {
+        break;
+      }
+      read_count += rc;
+    }
+    // if file ends before reading PAGE_SIZE
+    if (read_count < PAGE_SIZE) {
+      LOG_DEBUG("Read less than a page");
+      // std::cerr << "Read less than a page" << std::endl;
+      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    }
+  }
+}
+
+/**
+ * Synchronous versions of the asynchronous page I/O, callback is called
+ * before returning
+ */
+void DiskManager::ReadPageAsync(page_id_t page_id, char *page_data,
+                                std::function<void()> callback) {
+  ReadPage(page_id, page_data);
+  callback();
+}
+
+void DiskManager::WritePageAsync(page_id_t page_id, const char *page_data,
+                                 std::function<void()> callback) {
+  WritePage(page_id, page_data);
+  callback();
+}
+
+/**
+ * Write the contents of the log into disk file
+ * Only return when sync is done, and only perform sequence write
+ */
+void DiskManager::WriteLog(char *log_data, int size) {
+  // enforce swap log buffer
+  assert(log_data != buffer_used);
+  buffer_used = log_data;
+
+  if (size == 0) // no effect on num_flushes_ if log buffer is empty
+    return;
+
+  flush_log_ = true;
+
+  if (flush_log_f_ != nullptr)
+    // used for checking non-blocking flushing
+    assert(flush_log_f_->wait_for(std::chrono::seconds(10)) ==
+           std::future_status::ready);
+
+  num_flushes_ += 1;
+  // sequence write
+  log_io_.write(log_data, size);
+
+  // check for I/O error
+  if (log_io_.bad()) {
+    LOG_DEBUG("I/O error while writing log");
+    return;
+  }
+  // needs to flush to keep disk file in sync
+  log_io_.flush();
+  flush_log_ = false;
+}
+
+/**
+ * Read the contents of the log into the given memory area
+ * Always read from the beginning and perform sequence read
+ * @return: false means already reach the end
+ */
+bool DiskManager::ReadLog(char *log_data, int size, int offset) {
+  if (offset >= GetFileSize(log_name_)) {
+    // LOG_DEBUG("end of log file");
+    // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
+    return false;
+  }
+  log_io_.seekp(offset);
+  log_io_.read(log_data, size);
+  // if log file ends before reading "size"
+  int read_count = log_io_.gcount();
+  if (read_count < size) {
+    log_io_.clear();
+    memset(log_data + read_count, 0, size - read_count);
+  }
+
+  return true;
+}
+
+/**
+ * Allocate new page (operations like create index/table)
+ * For now just keep an increasing counter
+ */
+page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+
+/**
+ * Deallocate page (operations like drop index/table)
+ * Need bitmap in header page for tracking pages
+ */
+void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
+  return;
+}
+
+/**
+ * Returns the number of pages written to the db file so far, pages allocated
+ * but never written are not in it yet
+ */
+int DiskManager::GetNumPages() {
+  struct stat stat_buf;
+  int rc = fstat(db_fd_, &stat_buf);
+  return rc == 0 ? stat_buf.st_size / PAGE_SIZE : 0;
+}
+
+/**
+ * Returns number of flushes made so far
+ */
+int DiskManager::GetNumFlushes() const { return num_flushes_; }
+
+/**
+ * Returns true if the log is currently being flushed
+ */
+bool DiskManager::GetFlushState() const { return flush_log_; }
+
+/**
+ * Private helper function to get disk file size
+ */
+int DiskManager::GetFileSize(const std::string &file_name) {
+  struct stat stat_buf;
+  int rc = stat(file_name.c_str(), &stat_buf);
+  return rc == 0 ? stat_buf.st_size : -1;
+}
+
+} // namespace cmudb
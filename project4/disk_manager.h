@@ -0,0 +1,69 @@
+/**
+ * disk_manager.h
+ *
+ * Disk manager takes care of the allocation and deallocation of pages within a
+ * database. It also performs read and write of pages to and from disk, and
+ * provides a logical file layer within the context of a database management
+ * system.
+ */
+
+#pragma once
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <string>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class DiskManager {
+public:
+  DiskManager(const std::string &db_file);
+  virtual ~DiskManager();
+
+  virtual void WritePage(page_id_t page_id, const char *page_data);
+  virtual void ReadPage(page_id_t page_id, char *page_data);
+  // write count consecutive pages starting at page_id with vectored I/O
+  virtual void WritePages(page_id_t page_id, const char *const *pages_data,
+                          size_t count);
+
+  // callback runs once the I/O is done, here on the calling thread before
+  // returning, in AsyncDiskManager on its completion thread
+  virtual void ReadPageAsync(page_id_t page_id, char *page_data,
+                             std::function<void()> callback);
+  virtual void WritePageAsync(page_id_t page_id, const char *page_data,
+                              std::function<void()> callback);
+
+  virtual void WriteLog(char *log_data, int size);
+  virtual bool ReadLog(char *log_data, int size, int offset);
+
+  // number of pages the db file holds
+  int GetNumPages();
+
+  page_id_t AllocatePage();
+  void DeallocatePage(page_id_t page_id);
+
+  int GetNumFlushes() const;
+  bool GetFlushState() const;
+  inline void SetFlushLogFuture(std::future<void> *f) { flush_log_f_ = f; }
+  inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
+
+protected:
+  int GetFileSize(const std::string &name);
+  // stream to write log file
+  std::fstream log_io_;
+  std::string log_name_;
+  // descriptor of the db file, only positional I/O (pread/pwrite) is done on
+  // it so that concurrent page reads and writes need no latch
+  int db_fd_;
+  std::string file_name_;
+  std::atomic<page_id_t> next_page_id_;
+  int num_flushes_;
+  bool flush_log_;
+  std::future<void> *flush_log_f_;
+  char *buffer_used = nullptr;
+};
+
+} // namespace cmudb
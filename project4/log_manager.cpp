@@ -17,20 +17,25 @@ void LogManager::RunFlushThread() {
   if (ENABLE_LOGGING) return;
   ENABLE_LOGGING = true;
   //you need to start a separate background thread which is responsible for flushing the logs into disk file
+  // latch_ is not held during the write, appends go on into the other buffer
+  // and a flush requested meanwhile is done right after
   flush_thread_ = new thread([&] {
-    while (ENABLE_LOGGING) {//The thread is triggered every LOG_TIMEOUT seconds or when the log buffer is full
-      unique_lock<mutex> latch(latch_);
+    unique_lock<mutex> latch(latch_);
+    while (ENABLE_LOGGING || logBufferOffset_ > 0) {//The thread is triggered every LOG_TIMEOUT seconds or when the log buffer is full
       // (2) When LOG_TIMEOUT is triggered.
       cv_.wait_for(latch, LOG_TIMEOUT, [&] {return needFlush_.load();});
       assert(flushBufferSize_ == 0);
+      needFlush_ = false;
       if (logBufferOffset_ > 0) {
         swap(log_buffer_,flush_buffer_);
         swap(logBufferOffset_,flushBufferSize_);
+        const lsn_t flushLsn = lastLsn_;
+        latch.unlock();
         disk_manager_->WriteLog(flush_buffer_, flushBufferSize_);
+        latch.lock();
         flushBufferSize_ = 0;
-        SetPersistentLSN(lastLsn_);
+        SetPersistentLSN(flushLsn);
       }
-      needFlush_ = false;
       appendCv_.notify_all();
     }
   });
@@ -69,10 +74,12 @@ void LogManager::StopFlushThread() {
  */
 lsn_t LogManager::AppendLogRecord(LogRecord &log_record) {
   unique_lock<mutex> latch(latch_);
-  if (logBufferOffset_ + log_record.GetSize() >= LOG_BUFFER_SIZE) {
+  // the flush thread may be busy writing the other buffer, ask again until
+  // this one has been swapped out
+  while (logBufferOffset_ + log_record.GetSize() >= LOG_BUFFER_SIZE) {
     needFlush_ = true;
     cv_.notify_one(); //let RunFlushThread wake up.
-    appendCv_.wait(latch, [&] {return logBufferOffset_ + log_record.GetSize()< LOG_BUFFER_SIZE;});
+    appendCv_.wait(latch);
   }
   log_record.lsn_ = next_lsn_++;
   memcpy(log_buffer_ + logBufferOffset_, &log_record, LogRecord::HEADER_SIZE);
@@ -108,10 +115,11 @@ lsn_t LogManager::AppendLogRecord(LogRecord &log_record) {
 void LogManager::Flush(bool force) {
   unique_lock<mutex> latch(latch_);
   if (force) {
+    const lsn_t lsn = lastLsn_;
     needFlush_ = true;
     cv_.notify_one(); //let RunFlushThread wake up.
-    if (ENABLE_LOGGING)
-      appendCv_.wait(latch, [&] { return !needFlush_.load(); }); //block append thread
+    if (ENABLE_LOGGING) //block append thread until its records are on disk
+      appendCv_.wait(latch, [&] { return persistent_lsn_ >= lsn; });
   } else {
     appendCv_.wait(latch);// group commit,  But instead of forcing flush,
     // you need to wait for LOG_TIMEOUT or other operations to implicitly trigger the flush operations
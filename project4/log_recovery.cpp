@@ -79,33 +79,37 @@ void LogRecovery::Redo() {
         continue;
       }
       if (log.log_record_type_ == LogRecordType::NEWPAGE) {
-        auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(log.page_id_));
-        assert(page != nullptr);
+        WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(log.page_id_);
+        assert(!guard.IsEmpty());
+        auto page = static_cast<TablePage *>(guard.GetPage());
         bool needRedo = log.lsn_ > page->GetLSN();
         if (needRedo) {
           page->Init(log.page_id_, PAGE_SIZE, log.prev_page_id_, nullptr, nullptr);
           page->SetLSN(log.lsn_);
+          guard.MarkDirty();
           if (log.prev_page_id_ != INVALID_PAGE_ID) {
-            auto prevPage = static_cast<TablePage *>(
-                    buffer_pool_manager_->FetchPage(log.prev_page_id_));
-            assert(prevPage != nullptr);
-            bool needChange = prevPage->GetNextPageId() == log.page_id_;
+            WritePageGuard prevGuard =
+                    buffer_pool_manager_->FetchPageWrite(log.prev_page_id_);
+            assert(!prevGuard.IsEmpty());
+            auto prevPage = static_cast<TablePage *>(prevGuard.GetPage());
+            if (prevPage->GetNextPageId() == log.page_id_) {
+              prevGuard.MarkDirty();
+            }
             prevPage->SetNextPageId(log.page_id_);
-            buffer_pool_manager_->UnpinPage(prevPage->GetPageId(), needChange);
           }
         }
-        buffer_pool_manager_->UnpinPage(page->GetPageId(), needRedo);
 
         continue;
       }
       RID rid = log.log_record_type_ == LogRecordType::INSERT ? log.insert_rid_ :
                 log.log_record_type_ == LogRecordType::UPDATE ? log.update_rid_ :
                 log.delete_rid_;
-      auto page = static_cast<TablePage *>(
-              buffer_pool_manager_->FetchPage(rid.GetPageId()));
-      assert(page != nullptr);
+      WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+      assert(!guard.IsEmpty());
+      auto page = static_cast<TablePage *>(guard.GetPage());
       bool needRedo = log.lsn_ > page->GetLSN();
       if (needRedo) {
+        guard.MarkDirty();
         if (log.log_record_type_ == LogRecordType::INSERT) {
           page->InsertTuple(log.insert_tuple_, rid, nullptr, nullptr, nullptr);
         } else if (log.log_record_type_ == LogRecordType::UPDATE) {
@@ -121,7 +125,6 @@ void LogRecovery::Redo() {
         }
         page->SetLSN(log.lsn_);
       }
-      buffer_pool_manager_->UnpinPage(page->GetPageId(), needRedo);
     }
     memmove(log_buffer_, log_buffer_ + bufferOffset, LOG_BUFFER_SIZE - bufferOffset);
     bufferOffset = LOG_BUFFER_SIZE - bufferOffset;//rest partial log
@@ -154,20 +157,23 @@ void LogRecovery::Undo() {
         if (!buffer_pool_manager_->DeletePage(log.page_id_))
           disk_manager_->DeallocatePage(log.page_id_);
         if (log.prev_page_id_ != INVALID_PAGE_ID) {
-          auto prevPage = static_cast<TablePage *>(
-                  buffer_pool_manager_->FetchPage(log.prev_page_id_));
-          assert(prevPage != nullptr);
+          WritePageGuard prevGuard =
+                  buffer_pool_manager_->FetchPageWrite(log.prev_page_id_);
+          assert(!prevGuard.IsEmpty());
+          auto prevPage = static_cast<TablePage *>(prevGuard.GetPage());
           assert(prevPage->GetNextPageId() == log.page_id_);
           prevPage->SetNextPageId(INVALID_PAGE_ID);
-          buffer_pool_manager_->UnpinPage(prevPage->GetPageId(), true);
+          prevGuard.MarkDirty();
         }
         continue;
       }
       RID rid = log.log_record_type_ == LogRecordType::INSERT ? log.insert_rid_ :
                 log.log_record_type_ == LogRecordType::UPDATE ? log.update_rid_ :
                 log.delete_rid_;
-      auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-      assert(page != nullptr);
+      WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+      assert(!guard.IsEmpty());
+      guard.MarkDirty();
+      auto page = static_cast<TablePage *>(guard.GetPage());
       assert(page->GetLSN() >= log.lsn_);
       if (log.log_record_type_ == LogRecordType::INSERT) {
         page->ApplyDelete(log.insert_rid_, nullptr, nullptr);
@@ -183,7 +189,6 @@ void LogRecovery::Undo() {
       } else if (log.log_record_type_ == LogRecordType::ROLLBACKDELETE) {
         page->MarkDelete(log.delete_rid_, nullptr, nullptr, nullptr);
       } else assert(false);
-      buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
     }
   }
   active_txn_.clear();
@@ -0,0 +1,208 @@
+/**
+ * async_disk_manager_test.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "disk/async_disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// completed I/Os, counted by callbacks on the completion thread
+class Completions {
+public:
+  void Done() {
+    std::lock_guard<std::mutex> lck(latch_);
+    count_++;
+    cv_.notify_all();
+  }
+  void WaitFor(int count) {
+    std::unique_lock<std::mutex> lck(latch_);
+    cv_.wait(lck, [&] { return count_ >= count; });
+  }
+
+private:
+  std::mutex latch_;
+  std::condition_variable cv_;
+  int count_ = 0;
+};
+
+TEST(AsyncDiskManagerTest, PageTest) {
+  remove("test.db");
+  remove("test.log");
+  AsyncDiskManager *disk_manager = new AsyncDiskManager("test.db", 8);
+  // one byte off, goes through a bounce buffer
+  std::vector<char> buffer(PAGE_SIZE * 2 + 1);
+  char *data = buffer.data() + 1;
+
+  for (int i = 0; i < 20; ++i) {
+    snprintf(data, PAGE_SIZE, "page %d", i);
+    disk_manager->WritePage(i, data);
+  }
+  Completions writes;
+  for (int i = 20; i < 40; ++i) {
+    snprintf(data, PAGE_SIZE, "page %d", i);
+    disk_manager->WritePageAsync(i, data, [&] { writes.Done(); });
+    // the caller keeps its buffer until the write is done
+    writes.WaitFor(i - 19);
+  }
+  EXPECT_EQ(40, disk_manager->GetNumPages());
+
+  std::vector<std::vector<char>> pages(40, std::vector<char>(PAGE_SIZE));
+  Completions reads;
+  for (int i = 0; i < 40; ++i) {
+    disk_manager->ReadPageAsync(i, pages[i].data(), [&] { reads.Done(); });
+  }
+  reads.WaitFor(40);
+  for (int i = 0; i < 40; ++i) {
+    EXPECT_EQ("page " + std::to_string(i), std::string(pages[i].data()));
+  }
+  // beyond the end of the file
+  memset(data, 1, PAGE_SIZE);
+  disk_manager->ReadPage(100, data);
+  EXPECT_EQ(0, data[0]);
+  EXPECT_EQ(0, data[PAGE_SIZE - 1]);
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(AsyncDiskManagerTest, LogTest) {
+  remove("test.db");
+  remove("test.log");
+  std::vector<char> log(4 * LOG_BUFFER_SIZE);
+  for (size_t i = 0; i < log.size(); ++i) {
+    log[i] = static_cast<char>(i * 7);
+  }
+  AsyncDiskManager *disk_manager = new AsyncDiskManager("test.db");
+  // sizes not a multiple of the block size, alternating buffers like the
+  // log manager does
+  std::vector<char> buffers[2];
+  int sizes[] = {100, LOG_BUFFER_SIZE, 1, 512, LOG_BUFFER_SIZE - 3};
+  int offset = 0, flushes = 0;
+  for (int size : sizes) {
+    std::vector<char> &buffer = buffers[flushes++ % 2];
+    buffer.assign(log.begin() + offset, log.begin() + offset + size);
+    disk_manager->WriteLog(buffer.data(), size);
+    offset += size;
+  }
+  EXPECT_EQ(5, disk_manager->GetNumFlushes());
+  delete disk_manager;
+
+  // reopened, appends after the existing log
+  disk_manager = new AsyncDiskManager("test.db");
+  while (offset < static_cast<int>(log.size())) {
+    int size = std::min<int>(LOG_BUFFER_SIZE, log.size() - offset);
+    std::vector<char> &buffer = buffers[flushes++ % 2];
+    buffer.assign(log.begin() + offset, log.begin() + offset + size);
+    disk_manager->WriteLog(buffer.data(), size);
+    offset += size;
+  }
+
+  std::vector<char> read(log.size() + 100);
+  EXPECT_TRUE(disk_manager->ReadLog(read.data(), read.size(), 0));
+  EXPECT_EQ(0, memcmp(log.data(), read.data(), log.size()));
+  EXPECT_EQ(0, read[log.size()]);
+  EXPECT_TRUE(disk_manager->ReadLog(read.data(), 10, 511));
+  EXPECT_EQ(0, memcmp(log.data() + 511, read.data(), 10));
+  EXPECT_FALSE(
+          disk_manager->ReadLog(read.data(), 10, static_cast<int>(log.size())));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(AsyncDiskManagerTest, BufferPoolTest) {
+  remove("test.db");
+  remove("test.log");
+  AsyncDiskManager *disk_manager = new AsyncDiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+
+  page_id_t page_id;
+  for (int i = 0; i < 50; ++i) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  // prefetched reads complete on the completion thread
+  bpm->Prefetch(0, 10);
+  for (int i = 0; i < 50; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * Random page reads of a 16384 page file, with up to 32 reads in flight. The
+ * buffered DiskManager does them one at a time out of the page cache, the
+ * AsyncDiskManager goes to the device. Only reports numbers, run it with
+ * --gtest_also_run_disabled_tests.
+ */
+TEST(AsyncDiskManagerTest, DISABLED_ReadBenchmark) {
+  const int num_pages = 16384;
+  const int num_reads = 1 << 15;
+  const int depth = 32;
+  remove("test.db");
+  remove("test.log");
+
+  for (int async = 0; async <= 1; ++async) {
+    DiskManager *disk_manager = async ? new AsyncDiskManager("test.db")
+                                      : new DiskManager("test.db");
+    char *buffers = static_cast<char *>(aligned_alloc(PAGE_SIZE,
+                                                      depth * PAGE_SIZE));
+    memset(buffers, 0, depth * PAGE_SIZE);
+    if (!async) {
+      for (int i = 0; i < num_pages; ++i) {
+        disk_manager->WritePage(i, buffers);
+      }
+    }
+    std::mt19937 engine(0);
+    std::uniform_int_distribution<int> distribution(0, num_pages - 1);
+    Completions reads;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_reads; ++i) {
+      // at most depth reads in flight, what they read is not looked at
+      reads.WaitFor(i - depth + 1);
+      disk_manager->ReadPageAsync(distribution(engine),
+                                  buffers + i % depth * PAGE_SIZE,
+                                  [&] { reads.Done(); });
+    }
+    reads.WaitFor(num_reads);
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+    printf("%-8s %10.0f reads/s\n", async ? "io_uring" : "buffered",
+           num_reads / elapsed.count());
+    if (async) {
+      AsyncDiskManager *async_manager =
+              static_cast<AsyncDiskManager *>(disk_manager);
+      printf("O_DIRECT: %d  io_uring: %d\n", async_manager->IsDirect(),
+             async_manager->IsUring());
+    }
+    free(buffers);
+    delete disk_manager;
+  }
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb